@@ -0,0 +1,53 @@
+#ifndef ADC_SAMPLER_H
+#define ADC_SAMPLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "hal/adc_types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// ADC1 sampling in continuous (DMA) mode.
+// The converter scans the registered channels at a fixed rate and DMA
+// fills frames without the CPU; a task woken per completed frame averages
+// each channel over `average` conversions and converts the mean to mV
+// through adc_cali. Readers take the latest value, never waiting on the ADC;
+// a subscribed task is notified once every channel has a new value.
+
+#define ADC_SAMPLER_MAX_CHANNELS    7       // ADC1 on the ESP32-C6
+#define ADC_SAMPLER_OUTPUT_HZ       10      // Averaged values per channel per second
+#define ADC_SAMPLER_AVERAGE         64      // Conversions per averaged value
+#define ADC_SAMPLER_ATTEN           ADC_ATTEN_DB_12  // Full scale about 3.3V
+#define ADC_SAMPLER_FULL_SCALE_MV   3300    // Uncalibrated fallback
+#define ADC_SAMPLER_STALE_MS        1000    // Older values are not handed out
+#define ADC_SAMPLER_TASK_PRIORITY   5       // Above the sensor task
+#define ADC_SAMPLER_TASK_STACK      3072
+
+// Sampler configuration
+typedef struct {
+    uint32_t output_hz;      // Averaged values per channel per second
+    uint16_t average;        // Conversions per value (raised if the rate would fall below the ADC minimum)
+    TaskHandle_t notify;     // Woken with xTaskNotifyGive on each complete set; may be NULL
+} adc_sampler_config_t;
+
+// Sampler statistics
+typedef struct {
+    uint32_t frames;         // DMA frames processed
+    uint32_t overflows;      // Frames dropped: the task fell behind
+    uint32_t sample_rate_hz; // Conversions per second, all channels
+} adc_sampler_stats_t;
+
+// Function prototypes
+// Channels are registered before the sampler starts
+esp_err_t adc_sampler_add_channel(adc_channel_t channel);
+esp_err_t adc_sampler_start(const adc_sampler_config_t *config);
+esp_err_t adc_sampler_stop(void);
+// Latest averaged value; ESP_ERR_INVALID_STATE while there is none fresh
+esp_err_t adc_sampler_get_mv(adc_channel_t channel, uint32_t *mv);
+// Boot-time only: wait until every channel has a value
+esp_err_t adc_sampler_wait_ready(uint32_t timeout_ms);
+void adc_sampler_set_notify(TaskHandle_t task);
+void adc_sampler_get_stats(adc_sampler_stats_t *stats);
+
+#endif // ADC_SAMPLER_H
@@ -0,0 +1,52 @@
+#ifndef CASCADE_CONTROL_H
+#define CASCADE_CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pid_controller.h"
+
+// Cascade control: the room loop sets a heater surface-temperature
+// setpoint, an inner loop on a second NTC on the heater body tracks it
+// with the power. The inner loop sees the element's heat long before the
+// room does, so the room loop can be tuned faster without overshoot, and
+// the surface setpoint and a hard trip bound the body temperature.
+
+#define CASCADE_TRIP_HYSTERESIS     5.0f    // Surface must cool this far below the ceiling to resume
+#define CASCADE_SETPOINT_MARGIN     5.0f    // Outer loop output stays this far below the ceiling
+#define CASCADE_SURFACE_MIN_VALID   -20.0f  // Readings outside this range mean a faulty NTC
+#define CASCADE_SURFACE_MAX_VALID   150.0f
+#define CASCADE_SURFACE_NONE        INT32_MIN  // Q16.16 surface reading when there is none
+
+// Cascade configuration
+typedef struct {
+    pid_config_t outer;      // Room temperature -> surface setpoint (°C)
+    pid_config_t inner;      // Surface temperature -> power (%)
+    float surface_ceiling;   // Hard limit on the heater body (°C)
+} cascade_config_t;
+
+// Cascade state
+typedef struct {
+    pid_controller_t outer;
+    pid_controller_t inner;
+    float surface_ceiling;
+    pid_q16_t surface_ceiling_q;
+    pid_q16_t surface_setpoint;  // Last outer loop output (Q16.16 °C)
+    uint16_t outer_every;    // Inner steps per outer step
+    uint16_t steps;          // Inner steps since the last outer step
+    bool tripped;            // Over the ceiling (or sensor fault): power held at 0
+    uint32_t trips;          // Times the ceiling or a sensor fault cut the power
+} cascade_controller_t;
+
+// Function prototypes
+// The outer sample time must be a multiple of the inner one
+esp_err_t cascade_controller_init(cascade_controller_t *cascade, const cascade_config_t *config);
+// One inner step, once per inner sample_time_ms; returns the power (%).
+// The outer output reaches the inner loop in Q16.16, with no float between.
+pid_q16_t cascade_controller_compute_q16(cascade_controller_t *cascade, pid_q16_t room_setpoint,
+                                         pid_q16_t room_temp, pid_q16_t surface_temp);
+float cascade_controller_compute(cascade_controller_t *cascade, float room_setpoint,
+                                 float room_temp, float surface_temp);
+void cascade_controller_reset(cascade_controller_t *cascade);
+bool cascade_surface_valid(float surface_temp);
+
+#endif // CASCADE_CONTROL_H
@@ -0,0 +1,57 @@
+#ifndef DS18B20_H
+#define DS18B20_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "onewire.h"
+
+// DS18B20 sensors on one 1-Wire bus.
+// A bus task owns the bus: it finds the sensors by ROM search, starts a
+// conversion on all of them at once, sleeps through the 750 ms it takes and
+// reads each scratchpad on its next wakeup. Readers only copy the latest
+// result, so neither the sensor task nor anything else waits on the bus.
+
+#define DS18B20_FAMILY              0x28
+#define DS18B20_MAX_SENSORS         4
+#define DS18B20_CONVERSION_MS       750     // 12-bit resolution
+#define DS18B20_PERIOD_MS           1000    // One conversion round per period
+#define DS18B20_STALE_MS            5000    // Older readings are not handed out
+#define DS18B20_SEARCH_RETRY_MS     10000   // Empty or failing bus: search again
+#define DS18B20_FAILED_ROUNDS       5       // Rounds without any reading before a new search
+#define DS18B20_TASK_PRIORITY       3       // Below the sensor task
+#define DS18B20_TASK_STACK          3072
+
+// Function commands
+#define DS18B20_CMD_CONVERT_T       0x44
+#define DS18B20_CMD_READ_SCRATCHPAD 0xBE
+
+#define DS18B20_SCRATCHPAD_LEN      9
+#define DS18B20_POWER_ON_RAW        0x0550  // 85 C: reset value, no conversion yet
+
+// Function prototypes
+// Start the bus task on pin (once; later calls must use the same pin)
+esp_err_t ds18b20_start(gpio_num_t pin);
+// Latest reading of the sensor at index, in ROM search order;
+// ESP_ERR_INVALID_STATE while there is none newer than DS18B20_STALE_MS
+esp_err_t ds18b20_get(uint8_t index, float *celsius);
+uint8_t ds18b20_count(void);
+
+// Temperature from a scratchpad; false on a CRC error or when the fixed
+// bits of the configuration register are wrong (an all-zero read passes the
+// CRC). Bits below the configured resolution are undefined and masked off.
+static inline bool ds18b20_decode(const uint8_t scratchpad[DS18B20_SCRATCHPAD_LEN], int16_t *raw,
+                                  float *celsius) {
+    if (onewire_crc8(scratchpad, DS18B20_SCRATCHPAD_LEN) != 0 || (scratchpad[4] & 0x9F) != 0x1F) {
+        return false;
+    }
+    int16_t value = (int16_t)(scratchpad[0] | (scratchpad[1] << 8));
+    uint8_t resolution = (scratchpad[4] >> 5) & 0x03;  // 0: 9 bits .. 3: 12 bits
+    value &= ~((1 << (3 - resolution)) - 1);
+    *raw = value;
+    *celsius = value / 16.0f;
+    return true;
+}
+
+#endif // DS18B20_H
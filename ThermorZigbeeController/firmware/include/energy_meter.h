@@ -0,0 +1,30 @@
+#ifndef ENERGY_METER_H
+#define ENERGY_METER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// Delivered-energy meter.
+// Converts the firing path's per-channel time at full power (see
+// triac_control_get_energy_us) into Wh and keeps a lifetime total in NVS.
+// The total is rebuilt from the boot checkpoint and the cumulative
+// counters on every update, so no rounding accumulates.
+
+#define ENERGY_CHECKPOINT_INTERVAL_S    300     // At most one NVS write per 5 minutes
+#define ENERGY_CHECKPOINT_MIN_MWH       1000    // ...and only once 1 Wh has been added
+
+// Full-power time summed over channels to mWh (1 mWh = 3.6e6 us*W).
+// Each channel carries an equal share of the heater's rated power.
+static inline uint64_t energy_us_to_mwh(uint64_t full_power_us, uint16_t max_power_watts,
+                                        uint8_t num_channels) {
+    return full_power_us * max_power_watts / (3600000ULL * num_channels);
+}
+
+// Function prototypes
+esp_err_t energy_meter_init(uint16_t max_power_watts, uint8_t num_channels);
+esp_err_t energy_meter_update(void);
+esp_err_t energy_meter_checkpoint(void);
+uint64_t energy_meter_get_mwh(void);
+uint32_t energy_meter_get_wh(void);
+
+#endif // ENERGY_METER_H
@@ -0,0 +1,60 @@
+#ifndef NTC_TABLE_H
+#define NTC_TABLE_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// NTC divider conversion by table.
+// With the NTC on the ADC side of a divider fed from the ADC full scale,
+// T(mV) follows from R = r_series * mV / (supply - mV) and the beta equation
+// 1/T = 1/T0 + ln(R/R0)/beta: a logf and three float divisions per reading,
+// all soft-float on the C6. Instead T is tabulated in centi-degrees on a
+// uniform mV grid and interpolated in integers.
+//
+// The curve depends only on beta, t_nominal and r_series/r_nominal. The one
+// for the NTC_DEFAULT_* values below is generated by scripts/gen_ntc_table.py
+// (which reads them from this file) into flash; other curves are built in RAM.
+
+#define NTC_TABLE_SUPPLY_MV     3300    // Divider supply = ADC full scale
+#define NTC_TABLE_STEP_MV       10      // Grid spacing; under 0.05C error over -40..120C
+                                        // for r_series from about R0/2 to R0
+#define NTC_TABLE_SIZE          (NTC_TABLE_SUPPLY_MV / NTC_TABLE_STEP_MV + 1)
+#define NTC_TABLE_MIN_CENTI     -5000   // Entries are clamped to -50..250C
+#define NTC_TABLE_MAX_CENTI     25000
+#define NTC_TABLE_FAULT_MV      30      // Within this of either rail: shorted or open NTC
+                                        // (above 180C / below -50C on the default curve)
+#define NTC_TABLE_FAULT_CENTI   -27315  // Returned for those
+
+// Curve baked into the firmware
+#define NTC_DEFAULT_BETA        3950
+#define NTC_DEFAULT_T_NOMINAL   25
+#define NTC_DEFAULT_SERIES_RATIO 1      // r_series / r_nominal
+
+extern const int16_t ntc_default_centi[NTC_TABLE_SIZE];
+
+// Conversion table of one sensor
+typedef struct {
+    const int16_t *centi;   // ntc_default_centi, or `built`
+    int16_t *built;         // RAM table for a non-default curve; NULL otherwise
+} ntc_table_t;
+
+// Function prototypes
+// Selects the flash table when the curve is the default one, else builds one
+// in RAM; call again whenever the parameters change. Not safe against a
+// concurrent lookup: call from the task that reads the sensor.
+esp_err_t ntc_table_build(ntc_table_t *table, float beta, float r_nominal,
+                          float t_nominal, float r_series);
+void ntc_table_free(ntc_table_t *table);
+
+// Temperature in centi-degrees for a divider voltage
+static inline int32_t ntc_table_lookup(const ntc_table_t *table, uint32_t mv) {
+    if (mv < NTC_TABLE_FAULT_MV || mv > NTC_TABLE_SUPPLY_MV - NTC_TABLE_FAULT_MV) {
+        return NTC_TABLE_FAULT_CENTI;
+    }
+    uint32_t i = mv / NTC_TABLE_STEP_MV;
+    int32_t t0 = table->centi[i];
+    int32_t t1 = table->centi[i + 1];
+    return t0 + (t1 - t0) * (int32_t)(mv - i * NTC_TABLE_STEP_MV) / NTC_TABLE_STEP_MV;
+}
+
+#endif // NTC_TABLE_H
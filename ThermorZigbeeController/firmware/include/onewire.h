@@ -0,0 +1,46 @@
+#ifndef ONEWIRE_H
+#define ONEWIRE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// 1-Wire protocol helpers, independent of how the bus is driven: the
+// Dallas/Maxim CRC and the ROM search as a per-bit state machine (the
+// transport reads the bit and its complement, the search picks the branch
+// to write back).
+
+#define ONEWIRE_ROM_LEN             8
+#define ONEWIRE_ROM_BITS            (ONEWIRE_ROM_LEN * 8)
+
+// ROM commands
+#define ONEWIRE_CMD_SEARCH_ROM      0xF0
+#define ONEWIRE_CMD_MATCH_ROM       0x55
+#define ONEWIRE_CMD_SKIP_ROM        0xCC
+
+// 64-bit ROM: family code, 48-bit serial, CRC
+typedef struct {
+    uint8_t bytes[ONEWIRE_ROM_LEN];
+} onewire_rom_t;
+
+// ROM search state, kept across passes
+typedef struct {
+    onewire_rom_t rom;       // ROM of the running pass
+    int last_discrepancy;    // Branch point taken 0 on the previous pass (1-based, 0: none)
+    int last_zero;           // Branch point taken 0 on this pass
+    bool last_device;        // No branch left: the previous pass found the last ROM
+} onewire_search_t;
+
+// Function prototypes
+uint8_t onewire_crc8(const uint8_t *data, size_t len);
+void onewire_search_init(onewire_search_t *search);
+// Another pass is needed to find the next ROM
+bool onewire_search_pending(const onewire_search_t *search);
+// One ROM bit of a pass (0..63): from the bit and its complement as read
+// from the bus, the bit to write. False when no device answered.
+bool onewire_search_step(onewire_search_t *search, int bit, bool id_bit, bool cmp_bit,
+                         bool *direction);
+// End of a pass: true when search->rom holds a ROM with a valid CRC
+bool onewire_search_finish(onewire_search_t *search);
+
+#endif // ONEWIRE_H
@@ -0,0 +1,57 @@
+#ifndef ONEWIRE_BUS_H
+#define ONEWIRE_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "driver/rmt_tx.h"
+#include "driver/rmt_rx.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "onewire.h"
+
+// 1-Wire master on the RMT peripheral.
+// The TX channel drives the pin open-drain and loops back into the RX
+// channel, which records the line: the slot timing is done by the hardware,
+// with interrupts left enabled, so the radio is never held off. Each call
+// waits for its own transfer, so the bus belongs to one task (see ds18b20.c).
+// Needs an external 4.7K pull-up; parasite power is not supported.
+
+#define ONEWIRE_RESOLUTION_HZ       1000000 // 1 tick = 1 us
+#define ONEWIRE_RESET_LOW_US        500     // Reset pulse (480 min)
+#define ONEWIRE_RESET_RELEASE_US    500     // Presence window after the reset
+#define ONEWIRE_PRESENCE_MIN_US     30      // Shorter lows are not a presence pulse
+#define ONEWIRE_SLOT_US             70      // Time slot, recovery included
+#define ONEWIRE_WRITE1_LOW_US       3       // Write 1 / read slot: short low, then release
+#define ONEWIRE_WRITE0_LOW_US       60
+#define ONEWIRE_READ_THRESHOLD_US   15      // Devices hold a 0 low past this
+#define ONEWIRE_MAX_WRITE           10      // Bytes per transfer (match ROM + command)
+#define ONEWIRE_RX_SYMBOLS          16      // One byte of read slots, plus margin
+#define ONEWIRE_TIMEOUT_MS          50
+
+// Bus state
+typedef struct {
+    rmt_channel_handle_t tx;
+    rmt_channel_handle_t rx;
+    rmt_encoder_handle_t encoder;    // Copy encoder: slots are built as symbols
+    QueueHandle_t rx_done;           // Receive completions from the RMT ISR
+    rmt_symbol_word_t tx_symbols[ONEWIRE_MAX_WRITE * 8];
+    rmt_symbol_word_t rx_symbols[ONEWIRE_RX_SYMBOLS];
+    gpio_num_t pin;
+} onewire_bus_t;
+
+// Function prototypes
+esp_err_t onewire_bus_init(onewire_bus_t *bus, gpio_num_t pin);
+esp_err_t onewire_bus_deinit(onewire_bus_t *bus);
+// ESP_ERR_NOT_FOUND when no device answers the reset
+esp_err_t onewire_bus_reset(onewire_bus_t *bus);
+esp_err_t onewire_bus_write(onewire_bus_t *bus, const uint8_t *data, size_t len);
+esp_err_t onewire_bus_read(onewire_bus_t *bus, uint8_t *data, size_t len);
+// Reset and address one device, or all of them with rom == NULL
+esp_err_t onewire_bus_select(onewire_bus_t *bus, const onewire_rom_t *rom);
+// Enumerate the devices on the bus; *found is set even on a partial search
+esp_err_t onewire_bus_search(onewire_bus_t *bus, onewire_rom_t *roms, size_t max, size_t *found);
+
+#endif // ONEWIRE_BUS_H
@@ -3,6 +3,65 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "esp_err.h"
+
+// Fixed-point arithmetic: the ESP32-C6 has no FPU, so the control law runs
+// on Q16.16 integers with saturation. ki*dt is small and is kept in Q8.24;
+// the integral carries 24 extra fraction bits so small errors still count.
+typedef int32_t pid_q16_t;
+
+#define PID_Q16_ONE     65536
+#define PID_Q24_SHIFT   24
+
+static inline pid_q16_t pid_q16_from_float(float x) {
+    float scaled = x * (float)PID_Q16_ONE;
+    if (scaled >= 2147483647.0f) {
+        return INT32_MAX;
+    }
+    if (scaled <= -2147483648.0f) {
+        return INT32_MIN;
+    }
+    return (pid_q16_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+static inline float pid_q16_to_float(pid_q16_t x) {
+    return (float)x / (float)PID_Q16_ONE;
+}
+
+// Relay auto-tune (Astrom-Hagglund). The output switches between two levels
+// around the running output while the input swings through the setpoint;
+// the limit cycle's amplitude and period give the ultimate gain and period.
+#define PID_TUNE_RELAY_STEP     30.0f   // Relay amplitude d (output units)
+#define PID_TUNE_HYSTERESIS     0.1f    // Noise band around the setpoint (input units)
+#define PID_TUNE_CYCLES         3       // Cycles averaged, after one discarded
+#define PID_TUNE_TIMEOUT_MS     (6UL * 3600 * 1000)  // Give up without a limit cycle
+
+typedef enum {
+    PID_TUNE_IDLE,
+    PID_TUNE_RUNNING,
+    PID_TUNE_DONE,           // New gains applied
+    PID_TUNE_FAILED          // Timed out, previous gains kept
+} pid_tune_state_t;
+
+// Relay auto-tune state
+typedef struct {
+    pid_tune_state_t state;
+    float bias;              // Output the relay swings around
+    float saved_kp;          // Gains restored on abort or failure
+    float saved_ki;
+    float saved_kd;
+    bool relay_high;         // Relay output is at bias + d
+    bool cycle_started;      // A rising switch has been seen
+    uint32_t start_time;     // Tuning start (ms)
+    uint32_t cycle_time;     // Last rising switch (ms)
+    float peak_max;          // Input extremes over the running cycle
+    float peak_min;
+    uint8_t cycles;          // Complete cycles seen
+    float period_sum;        // Sums over the averaged cycles
+    float amplitude_sum;
+    float ku;                // Result: ultimate gain
+    float tu;                // Result: ultimate period (s)
+} pid_autotune_t;
 
 // PID controller configuration
 typedef struct {
@@ -14,26 +73,44 @@ typedef struct {
     uint32_t sample_time_ms; // Sample time in milliseconds
 } pid_config_t;
 
-// PID controller state
+// PID controller state. Coefficients are rebuilt from the config whenever
+// the gains, limits or sample time change, never per call.
 typedef struct {
     pid_config_t config;
-    float integral;          // Integral accumulator
-    float last_error;        // Previous error for derivative
-    float last_input;        // Previous input for derivative on measurement
-    uint32_t last_time;      // Last computation time
+    pid_q16_t kp_q;          // kp
+    int32_t ki_dt_q24;       // ki * dt (Q8.24)
+    pid_q16_t kd_dt_q;       // kd / dt, from the precomputed reciprocal of dt
+    pid_q16_t out_min_q;     // Output limits
+    pid_q16_t out_max_q;
+    pid_q16_t feedforward;   // Added to the output ahead of the limits (output units)
+    int64_t integral;        // Integral term in output units (Q16.16 << 24)
+    pid_q16_t last_error;    // Previous error
+    pid_q16_t last_input;    // Previous input for derivative on measurement
+    pid_q16_t last_output;   // Previous output
+    uint32_t samples;        // Samples computed, the controller's time base
     bool first_run;          // First run flag
+    pid_autotune_t tune;     // Relay auto-tune
 } pid_controller_t;
 
 // Function prototypes
+// Compute runs once per sample_time_ms: the caller's loop is the clock, and
+// dt is always the configured sample time.
 void pid_controller_init(pid_controller_t *pid, const pid_config_t *config);
 float pid_controller_compute(pid_controller_t *pid, float setpoint, float input);
+pid_q16_t pid_controller_compute_q16(pid_controller_t *pid, pid_q16_t setpoint, pid_q16_t input);
 void pid_controller_reset(pid_controller_t *pid);
 void pid_controller_set_tunings(pid_controller_t *pid, float kp, float ki, float kd);
 void pid_controller_set_output_limits(pid_controller_t *pid, float min, float max);
 void pid_controller_set_sample_time(pid_controller_t *pid, uint32_t sample_time_ms);
+// Known share of the output (e.g. the power a setpoint ramp needs); the
+// integral then only carries what the model misses
+void pid_controller_set_feedforward(pid_controller_t *pid, float feedforward);
 
 // Advanced features
 void pid_controller_set_auto_tune(pid_controller_t *pid, bool enable);
+pid_tune_state_t pid_controller_get_auto_tune_state(const pid_controller_t *pid);
 void pid_controller_get_tunings(pid_controller_t *pid, float *kp, float *ki, float *kd);
+esp_err_t pid_controller_save_tunings(const pid_controller_t *pid);
+esp_err_t pid_controller_load_tunings(pid_controller_t *pid);
 
-#endif // PID_CONTROLLER_H
\ No newline at end of file
+#endif // PID_CONTROLLER_H
@@ -0,0 +1,33 @@
+#ifndef PT1000_H
+#define PT1000_H
+
+#include <stdint.h>
+
+// PT1000 RTD conversion (IEC 60751).
+// Callendar-Van Dusen: R(T) = R0 (1 + A T + B T^2 + C (T - 100) T^3), the
+// C term below 0C only. Rather than solving it per sample in soft-float,
+// R is tabulated every PT1000_TABLE_STEP_C and T is interpolated linearly
+// in integers; the curve bends so little that the error stays under 0.005C.
+
+#define PT1000_R0               1000.0f
+#define PT1000_CVD_A            3.9083e-3
+#define PT1000_CVD_B            -5.775e-7
+#define PT1000_CVD_C            -4.183e-12
+
+#define PT1000_TABLE_MIN_C      -50     // Table range; beyond it the end segments are extended
+#define PT1000_TABLE_MAX_C      150
+#define PT1000_TABLE_STEP_C     10
+#define PT1000_TABLE_SIZE       ((PT1000_TABLE_MAX_C - PT1000_TABLE_MIN_C) / PT1000_TABLE_STEP_C + 1)
+
+// Round trip of a two-wire copper lead, for the lead compensation
+#define PT1000_COPPER_OHM_MM2_PER_M 0.0172f
+
+extern const uint32_t pt1000_table_mohm[PT1000_TABLE_SIZE];
+
+// Function prototypes
+float pt1000_resistance_to_temperature(float ohms);
+// Two-wire sensor: the leads add to the RTD; lead_ohms is the round trip
+float pt1000_temperature(float measured_ohms, float lead_ohms);
+float pt1000_lead_resistance(float length_m, float area_mm2);
+
+#endif // PT1000_H
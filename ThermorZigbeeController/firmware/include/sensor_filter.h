@@ -0,0 +1,75 @@
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// Sensor filter chain.
+// Up to SENSOR_FILTER_MAX_STAGES stages run in order on each sample, the
+// output of one feeding the next. All state is sized at compile time and
+// lives in the chain itself: no heap, and a fixed cost per sample for each
+// stage (the median works on at most SENSOR_FILTER_MAX_MEDIAN values).
+
+#define SENSOR_FILTER_MAX_STAGES    4
+#define SENSOR_FILTER_MAX_WINDOW    16      // Moving average samples
+#define SENSOR_FILTER_MAX_MEDIAN    7       // Median window (odd)
+
+typedef enum {
+    SENSOR_FILTER_MOVING_AVERAGE,   // Mean of the last `window` samples (running sum)
+    SENSOR_FILTER_MEDIAN,           // Median of the last `window` samples: rejects spikes
+    SENSOR_FILTER_EXPONENTIAL,      // y += alpha * (x - y)
+    SENSOR_FILTER_RATE_LIMIT        // Output moves at most `max_rate` per second
+} sensor_filter_type_t;
+
+// Stage configuration
+typedef struct {
+    sensor_filter_type_t type;
+    uint8_t window;          // MOVING_AVERAGE, MEDIAN
+    float alpha;             // EXPONENTIAL: weight of the new sample, (0, 1]
+    float max_rate;          // RATE_LIMIT: units (°C) per second
+} sensor_filter_stage_config_t;
+
+// Stage state
+typedef struct {
+    int32_t samples[SENSOR_FILTER_MAX_WINDOW];  // Millidegrees: the running sum never drifts
+    int32_t sum;
+    uint8_t index;
+    uint8_t count;
+} sensor_filter_average_t;
+
+typedef struct {
+    float history[SENSOR_FILTER_MAX_MEDIAN];    // Arrival order
+    float sorted[SENSOR_FILTER_MAX_MEDIAN];
+    uint8_t index;
+    uint8_t count;
+} sensor_filter_median_t;
+
+typedef struct {
+    float value;
+    uint32_t time_ms;                           // RATE_LIMIT only
+    bool primed;
+} sensor_filter_last_t;
+
+typedef struct {
+    sensor_filter_stage_config_t config;
+    union {
+        sensor_filter_average_t average;
+        sensor_filter_median_t median;
+        sensor_filter_last_t last;
+    } state;
+} sensor_filter_stage_t;
+
+// Filter chain
+typedef struct {
+    sensor_filter_stage_t stages[SENSOR_FILTER_MAX_STAGES];
+    uint8_t count;          // 0: samples pass through
+} sensor_filter_t;
+
+// Function prototypes
+esp_err_t sensor_filter_init(sensor_filter_t *filter, const sensor_filter_stage_config_t *stages,
+                             uint8_t count);
+void sensor_filter_reset(sensor_filter_t *filter);
+float sensor_filter_apply(sensor_filter_t *filter, float value, uint32_t now_ms);
+
+#endif // SENSOR_FILTER_H
@@ -0,0 +1,46 @@
+#ifndef SETPOINT_RAMP_H
+#define SETPOINT_RAMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "thermal_model.h"
+
+// Setpoint trajectory between the setpoint source (UI, schedule, Zigbee)
+// and the controller. A rise in the target is followed at a bounded rate
+// instead of as a step, so the loop does not saturate and wind up after a
+// mode change. Falls are followed at once: the room cools on its own.
+// The ramp never holds the room back: if the room warms faster, the
+// effective setpoint follows it.
+
+#define SETPOINT_RAMP_MAX_RATE      0.1f    // Default ceiling, °C per minute
+#define SETPOINT_RAMP_MIN_RATE      0.005f  // Floor, °C per minute
+#define SETPOINT_RAMP_MIN_STEP      0.5f    // Smaller rises are applied at once
+#define SETPOINT_RAMP_HEADROOM      0.6f    // Share of the full-power heat-up rate to ask for
+#define SETPOINT_RAMP_LANDING_S     900.0f  // Time constant of the final approach
+#define SETPOINT_RAMP_DONE          0.05f   // Close enough: jump to the target
+
+// Ramp state
+typedef struct {
+    float target;            // Where the setpoint source wants to go
+    float effective;         // What the controller is given
+    float rate;              // °C per second in use
+    float step_rate;         // °C per second applied at the last update (landing included)
+    float max_rate;          // Configured ceiling, °C per second
+    bool ramping;
+    bool valid;              // effective has been seeded
+} setpoint_ramp_t;
+
+// Function prototypes
+void setpoint_ramp_init(setpoint_ramp_t *ramp, float max_rate_c_per_min);
+// Once per control step: returns the setpoint to control to
+float setpoint_ramp_update(setpoint_ramp_t *ramp, float target, float temperature, float dt_s);
+// Heating off or suspended: the next ramp starts from the room
+void setpoint_ramp_track(setpoint_ramp_t *ramp, float temperature);
+// Use the identified room for the rate (falls back to the configured maximum)
+void setpoint_ramp_set_model(setpoint_ramp_t *ramp, const thermal_model_params_t *model,
+                             float temperature);
+bool setpoint_ramp_is_active(const setpoint_ramp_t *ramp);
+// Power (%) the identified room needs to follow the ramp, for the PID feedforward
+float setpoint_ramp_feedforward(const setpoint_ramp_t *ramp, const thermal_model_params_t *model);
+
+#endif // SETPOINT_RAMP_H
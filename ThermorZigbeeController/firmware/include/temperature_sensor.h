@@ -3,7 +3,10 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include "driver/adc.h"
+#include "hal/adc_types.h"
+#include "driver/gpio.h"
+#include "ntc_table.h"
+#include "sensor_filter.h"
 
 // Temperature sensor types
 typedef enum {
@@ -16,14 +19,21 @@ typedef enum {
 
 // Temperature sensor configuration
 typedef struct {
-    adc1_channel_t adc_channel;  // ADC channel for analog sensors
+    adc_channel_t adc_channel;   // ADC1 channel for analog sensors (see adc_sampler.h)
     temp_sensor_type_t sensor_type;
     
+    // DS18B20: 1-Wire bus pin and the sensor's place in ROM search order
+    gpio_num_t onewire_pin;
+    uint8_t onewire_index;
+    
     // NTC thermistor parameters
     float beta;             // Beta coefficient
     float r_nominal;        // Nominal resistance at T_nominal
     float t_nominal;        // Nominal temperature (°C)
-    float r_series;         // Series resistor value
+    float r_series;         // Series resistor value (NTC and PT1000 dividers)
+    
+    // PT1000: round-trip resistance of a two-wire lead (see pt1000_lead_resistance)
+    float r_lead;
     
     // Calibration
     float offset;           // Temperature offset
@@ -37,11 +47,11 @@ typedef struct {
     uint32_t last_read_time;
     bool initialized;
     
-    // Moving average filter
-    float *filter_buffer;
-    uint8_t filter_size;
-    uint8_t filter_index;
-    bool filter_full;
+    // NTC: voltage to temperature table for the configured curve
+    ntc_table_t ntc_table;
+    
+    // Filter chain for temperature_sensor_read_filtered
+    sensor_filter_t filter;
 } temp_sensor_t;
 
 // Function prototypes
@@ -50,7 +60,14 @@ esp_err_t temperature_sensor_deinit(temp_sensor_t *sensor);
 float temperature_sensor_read(temp_sensor_t *sensor);
 float temperature_sensor_read_filtered(temp_sensor_t *sensor);
 esp_err_t temperature_sensor_calibrate(temp_sensor_t *sensor, float offset, float scale);
+// Moving average over filter_size readings (0: no filtering)
 esp_err_t temperature_sensor_set_filter(temp_sensor_t *sensor, uint8_t filter_size);
+esp_err_t temperature_sensor_set_filter_chain(temp_sensor_t *sensor,
+                                              const sensor_filter_stage_config_t *stages,
+                                              uint8_t count);
+// New NTC curve (e.g. a measured beta): the conversion table is rebuilt
+esp_err_t temperature_sensor_set_ntc(temp_sensor_t *sensor, float beta, float r_nominal,
+                                     float t_nominal, float r_series);
 
 // Helper functions
 float ntc_resistance_to_temperature(float resistance, float beta, float r_nominal, float t_nominal);
@@ -0,0 +1,72 @@
+#ifndef THERMAL_MODEL_H
+#define THERMAL_MODEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pid_controller.h"
+
+// Online identification of the room as a first-order-plus-dead-time model
+//   tau * dT/dt = K * u(t - theta) + T_ambient - T
+// from the control loop's own power (%) and temperature (°C) history.
+// The loop's 1 s samples are averaged into one model sample per minute.
+// A small bank of recursive least squares estimators, one per candidate
+// dead time d, fits
+//   T[k] - T[k-1] = p0 * (T[k-1] - 20) + p1 * (u[k-d] + u[k-1-d]) / 200 + p2
+// and the one with the smallest prediction error gives the model. Memory
+// is fixed and each model sample costs the same few hundred float
+// operations, once a minute.
+
+#define THERMAL_MODEL_SAMPLE_S          60      // Model sample period
+#define THERMAL_MODEL_NUM_DELAYS        6       // Candidate dead times (see thermal_model.c)
+#define THERMAL_MODEL_MAX_DELAY         8       // Longest, in model samples
+#define THERMAL_MODEL_FORGETTING        0.998f  // Per model sample: about 8 h of memory
+#define THERMAL_MODEL_MIN_SAMPLES       180     // 3 h of data before any retune
+#define THERMAL_MODEL_MIN_CONFIDENCE    0.7f    // Retune only above this
+#define THERMAL_MODEL_DRIFT             0.25f   // Relative gain change that triggers a retune
+#define THERMAL_MODEL_RETUNE_HOLDOFF    60      // Model samples between retunes
+#define THERMAL_MODEL_MIN_TAUC_S        300.0f  // SIMC closed-loop time constant floor
+
+// One estimator: parameters p0..p2 and their covariance
+typedef struct {
+    float p[3];
+    float cov[3][3];
+    float error_var;         // Filtered squared prediction error
+} thermal_rls_t;
+
+// Identified model, for diagnostics and tuning
+typedef struct {
+    float gain;              // K, °C per % of power
+    float tau_s;             // Time constant (s)
+    float dead_time_s;       // theta (s)
+    float ambient;           // Temperature the room settles to unheated
+    float confidence;        // 0 (unknown) to 1 (well determined)
+    uint32_t samples;        // Model samples fitted
+} thermal_model_params_t;
+
+// Estimator state
+typedef struct {
+    float power_sum;         // Averaging over the running model sample
+    float temp_sum;
+    uint16_t count;
+    float power_history[THERMAL_MODEL_MAX_DELAY + 2];
+    uint8_t history_head;    // Next slot to write
+    uint8_t history_len;     // Valid entries, up to MAX_DELAY + 2
+    float last_temp;         // Previous model sample's temperature
+    thermal_rls_t rls[THERMAL_MODEL_NUM_DELAYS];
+    uint32_t samples;
+    uint32_t last_retune;    // Model sample of the last retune
+} thermal_model_t;
+
+// Function prototypes
+void thermal_model_init(thermal_model_t *model);
+// Once per control period; true when a model sample was completed
+bool thermal_model_update(thermal_model_t *model, float power_percent, float temperature);
+// Disturbance (open window...): drop the samples in progress
+void thermal_model_hold(thermal_model_t *model);
+void thermal_model_get_params(const thermal_model_t *model, thermal_model_params_t *params);
+// SIMC PI gains for the present model; false if it is not trusted yet
+bool thermal_model_get_tunings(const thermal_model_t *model, float *kp, float *ki, float *kd);
+// Re-derive the PID gains when the model has drifted from them; true if changed
+bool thermal_model_retune(thermal_model_t *model, pid_controller_t *pid);
+
+#endif // THERMAL_MODEL_H
@@ -7,36 +7,107 @@
 
 #define MAX_TRIACS 3
 
+// Firing backend
+typedef enum {
+    TRIAC_BACKEND_ISR,       // Software schedule driven by interrupts
+    TRIAC_BACKEND_ETM        // Hardware event chain, no per-cycle CPU wakeup
+} triac_backend_t;
+
+// Soft-start ramp shape
+typedef enum {
+    TRIAC_RAMP_LINEAR,       // Constant rate
+    TRIAC_RAMP_S_CURVE       // Smoothstep: gentle start and finish
+} triac_ramp_curve_t;
+
 // Triac control configuration
 typedef struct {
     gpio_num_t triac_pins[MAX_TRIACS];  // GPIO pins for triacs
     uint8_t num_triacs;                  // Number of triacs
     gpio_num_t zero_cross_pin;           // Zero crossing detection pin
     uint16_t max_power_watts;            // Maximum power in watts
-    uint8_t mains_frequency;             // Mains frequency (50 or 60 Hz)
+    int16_t zero_cross_offset_us;        // True crossing minus detector edge (us)
+    triac_backend_t backend;             // Firing backend (see triac_etm.h for ETM limits)
+    uint16_t ramp_ms;                    // Time for a full 0-100% swing, 0 = no ramp
+    triac_ramp_curve_t ramp_curve;       // Ramp shape
+    bool staging;                        // set_power stages whole elements (ISR backend)
 } triac_config_t;
 
+// Output actuation mode
+typedef enum {
+    TRIAC_MODE_PHASE,        // Phase-angle firing inside each half-cycle
+    TRIAC_MODE_BURST         // Whole mains cycles, switched at zero voltage
+} triac_mode_t;
+
 // Triac state
 typedef struct {
     uint8_t power_level;     // Power level 0-100%
     uint16_t firing_delay;   // Delay in microseconds
     bool enabled;            // Triac enabled state
+    bool cut;                // Disabled explicitly: gate off at once, no ramp-down
+    triac_mode_t mode;       // Actuation mode
 } triac_state_t;
 
+// Firing path diagnostics
+typedef struct {
+    uint32_t zero_crossings; // Zero crossings seen
+    uint32_t fired_pulses;   // Gate pulses generated
+    uint32_t missed_alarms;  // Firing events that ran late or were dropped
+    bool mains_locked;       // Zero-cross tracker locked on the mains
+    uint8_t mains_frequency; // Detected mains frequency (50/60), 0 if unknown
+    uint32_t half_cycle_us;  // Tracked half-cycle period
+    uint32_t jitter_us;      // Mean absolute zero-cross phase error
+    uint32_t isr_max_cycles; // Worst-case CPU cycles spent in a firing ISR
+    uint32_t isr_max_us;     // Same, in microseconds
+    bool hardware_firing;    // ETM chain has taken over the firing
+    uint32_t missed_crossings; // Crossings bridged by prediction (no edge)
+    uint32_t spurious_edges;   // Edges rejected as glitches or chatter
+    uint32_t sync_losses;      // Times every gate was forced low on lost sync
+    uint32_t sample_latency_us;     // Sensor sample to firing table, last set_power_at
+    uint32_t sample_latency_max_us; // Worst seen
+} triac_diagnostics_t;
+
+// Element role under staged power
+typedef enum {
+    TRIAC_ROLE_OFF,          // Not conducting
+    TRIAC_ROLE_FULL,         // Fully on every half-cycle
+    TRIAC_ROLE_MODULATED     // Phase or burst modulated
+} triac_role_t;
+
+// Per-channel duty report. Pass the previous report back in: measured
+// duty covers the time between the two calls.
+typedef struct {
+    triac_role_t role[MAX_TRIACS];
+    uint8_t level[MAX_TRIACS];      // Commanded level (%)
+    uint8_t duty[MAX_TRIACS];       // Measured full-power duty since the previous report (%)
+    uint64_t energy_us[MAX_TRIACS]; // Energy counters at this report
+    int64_t time_us;                // esp_timer time of this report, 0 = none yet
+} triac_duty_report_t;
+
 // Function prototypes
 esp_err_t triac_control_init(const triac_config_t *config);
 esp_err_t triac_control_deinit(void);
+// Level changes ramp, a drop to 0 included (triac_control_enable cuts at once)
 esp_err_t triac_control_set_power(uint8_t power_percent);
+// Same, for a control step driven by the sensor sample taken at sample_time_us (esp_timer)
+esp_err_t triac_control_set_power_at(uint8_t power_percent, int64_t sample_time_us);
 esp_err_t triac_control_set_triac_power(uint8_t triac_num, uint8_t power_percent);
 uint8_t triac_control_get_power(void);
 uint8_t triac_control_get_triac_power(uint8_t triac_num);
+// Disabling cuts the gates on the next half-cycle, without the ramp-down;
+// the next non-zero set_power enables the channels again
 esp_err_t triac_control_enable(bool enable);
 esp_err_t triac_control_enable_triac(uint8_t triac_num, bool enable);
-bool triac_control_is_enabled(void);
-uint16_t triac_control_get_actual_power_watts(void);
+esp_err_t triac_control_set_mode(uint8_t triac_num, triac_mode_t mode);
+esp_err_t triac_control_set_ramp(uint16_t ramp_ms, triac_ramp_curve_t curve);
+triac_mode_t triac_control_get_mode(uint8_t triac_num);
+bool triac_control_is_enabled(void);                   // True while a ramp-down still fires
+uint16_t triac_control_get_actual_power_watts(void);    // From the ramped level being applied
+uint64_t triac_control_get_energy_us(uint8_t triac_num);  // Time at full power since boot
+esp_err_t triac_control_get_diagnostics(triac_diagnostics_t *diag);
+esp_err_t triac_control_get_duty_report(triac_duty_report_t *report);
 
 // Phase control helpers
-uint16_t power_to_firing_delay(uint8_t power_percent, uint8_t frequency);
-uint8_t firing_delay_to_power(uint16_t delay_us, uint8_t frequency);
+uint16_t power_to_firing_delay(uint8_t power_percent, uint32_t half_cycle_us);
+uint8_t firing_delay_to_power(uint16_t delay_us, uint32_t half_cycle_us);
 
 #endif // TRIAC_CONTROL_H
\ No newline at end of file
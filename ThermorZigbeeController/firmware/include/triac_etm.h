@@ -0,0 +1,67 @@
+#ifndef TRIAC_ETM_H
+#define TRIAC_ETM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+// Hardware phase-control backend (ESP32-C6 Event Task Matrix).
+// The zero-cross edge starts a phase timer, whose alarm raises the gates and
+// starts a pulse timer, whose alarm drops them again. No interrupt runs per
+// half-cycle; the CPU only rewrites the alarm when the firing delay changes.
+//
+// Chain (all in hardware):
+//   ZC edge      -> phase timer EN_ALARM, START; gates CLR
+//   phase alarm  -> phase timer STOP (auto-reloaded to 0); gates SET;
+//                   pulse timer EN_ALARM, START
+//   pulse alarm  -> pulse timer STOP (auto-reloaded to 0); gates CLR
+//
+// Both timers rest stopped at 0 between events, so the order in which the
+// matrix delivers tasks sharing one event never matters. All channels share
+// one firing angle, and a missing zero-cross edge simply stops firing.
+// Burst mode and the soft-start ramp need a per-cycle decision and are not
+// available on this path; level changes apply from the next crossing.
+
+#define TRIAC_ETM_PULSE_US      10      // Gate pulse width
+#define TRIAC_ETM_MIN_ALARM     2       // Earliest phase alarm after the edge (ticks)
+#define TRIAC_ETM_END_GUARD_US  200     // Gate must be low this long before the next crossing
+
+// Timer register values for one firing angle (1 tick = 1us)
+typedef struct {
+    uint32_t phase_alarm;   // Phase timer alarm count after the detector edge
+    uint32_t pulse_alarm;   // Pulse timer alarm count (gate width)
+    bool fire;              // Phase alarm routed to the gates
+} triac_etm_plan_t;
+
+// Compute the register values for a firing delay after the true crossing.
+// offset_us is the true crossing minus the detector edge, as in triac_config_t.
+static inline triac_etm_plan_t triac_etm_compute_plan(uint32_t delay_us, int32_t offset_us,
+                                                      uint32_t half_cycle_us) {
+    triac_etm_plan_t plan = {
+        .phase_alarm = 0,
+        .pulse_alarm = TRIAC_ETM_PULSE_US,
+        .fire = false,
+    };
+
+    // Too late to end the pulse before the next crossing: leave the gates off
+    if (delay_us + TRIAC_ETM_PULSE_US + TRIAC_ETM_END_GUARD_US > half_cycle_us) {
+        return plan;
+    }
+
+    int32_t alarm = (int32_t)delay_us + offset_us;
+    if (alarm < TRIAC_ETM_MIN_ALARM) {
+        alarm = TRIAC_ETM_MIN_ALARM;
+    }
+    plan.phase_alarm = (uint32_t)alarm;
+    plan.fire = true;
+    return plan;
+}
+
+// Function prototypes
+esp_err_t triac_etm_start(const gpio_num_t *triac_pins, uint8_t num_triacs, gpio_num_t zero_cross_pin);
+esp_err_t triac_etm_apply(const triac_etm_plan_t *plan, uint32_t channel_mask);
+esp_err_t triac_etm_stop(void);
+bool triac_etm_is_running(void);
+
+#endif // TRIAC_ETM_H
@@ -0,0 +1,50 @@
+#ifndef TRIAC_POWER_TABLE_H
+#define TRIAC_POWER_TABLE_H
+
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#else
+#define DRAM_ATTR
+#endif
+
+// Phase-control power mapping for a resistive load.
+// P(a) = 1 - a/pi + sin(2a)/(2*pi) is the RMS power fraction delivered when
+// firing at angle a. Tables are generated by scripts/gen_triac_power_table.py
+// and kept in DRAM so the lookups below are safe from IRAM interrupts.
+
+#define TRIAC_POWER_STEPS     100   // Delay table resolution (1%)
+#define TRIAC_ANGLE_SEGMENTS  64    // Power table resolution over 0..pi
+#define TRIAC_POWER_Q15_ONE   32768 // Full conduction in Q15
+
+extern const uint16_t triac_delay_50hz_us[TRIAC_POWER_STEPS + 1];
+extern const uint16_t triac_delay_60hz_us[TRIAC_POWER_STEPS + 1];
+extern const uint16_t triac_power_by_angle_q15[TRIAC_ANGLE_SEGMENTS + 1];
+
+// Firing delay in microseconds for a power percentage (0-100)
+static inline uint16_t triac_table_delay_us(uint8_t power_percent, uint8_t frequency) {
+    if (power_percent > TRIAC_POWER_STEPS) {
+        power_percent = TRIAC_POWER_STEPS;
+    }
+    return (frequency == 60) ? triac_delay_60hz_us[power_percent]
+                             : triac_delay_50hz_us[power_percent];
+}
+
+// Relative power (Q15) for a firing delay inside a half-cycle
+static inline uint16_t triac_table_power_q15(uint32_t delay_us, uint32_t half_cycle_us) {
+    if (delay_us >= half_cycle_us) {
+        return 0;
+    }
+    
+    // Position on the angle grid in 1/256 segment steps
+    uint32_t pos = (delay_us * (TRIAC_ANGLE_SEGMENTS * 256u)) / half_cycle_us;
+    uint32_t idx = pos >> 8;
+    uint32_t frac = pos & 0xFF;
+    
+    int32_t p0 = triac_power_by_angle_q15[idx];
+    int32_t p1 = triac_power_by_angle_q15[idx + 1];
+    return (uint16_t)(p0 + (((p1 - p0) * (int32_t)frac) >> 8));
+}
+
+#endif // TRIAC_POWER_TABLE_H
@@ -0,0 +1,79 @@
+#ifndef ZERO_CROSS_TRACKER_H
+#define ZERO_CROSS_TRACKER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#define ZC_TRACKER_ATTR IRAM_ATTR
+#else
+#define ZC_TRACKER_ATTR
+#endif
+
+// Mains zero-cross tracker.
+// Timestamps detector edges, locks a software PLL onto the half-cycle period
+// and predicts the next true crossing, so firing can follow the prediction
+// when an edge is late, noisy or missing. All times are in microseconds on
+// the caller's free-running time base.
+
+#define ZC_MIN_HALF_CYCLE_US    7000    // ~71Hz
+#define ZC_MAX_HALF_CYCLE_US    12500   // 40Hz
+#define ZC_LOCK_EDGES           4       // Consistent intervals needed to lock
+#define ZC_COAST_LIMIT          4       // Crossings without an edge before unlocking
+
+// Lock state
+typedef enum {
+    ZC_STATE_SEARCHING,     // Measuring edge intervals, no prediction yet
+    ZC_STATE_LOCKED         // Period and phase tracked, crossings predicted
+} zc_lock_state_t;
+
+// Classification of a detector edge
+typedef enum {
+    ZC_EDGE_REJECTED,       // Outside the acceptance window, ignored
+    ZC_EDGE_ACQUIRING,      // Used for lock acquisition
+    ZC_EDGE_LOCKED,         // Lock acquired; the edge is the current crossing
+    ZC_EDGE_NEXT,           // Confirmed the upcoming predicted crossing
+    ZC_EDGE_LAST            // Confirmed the crossing already in progress (late edge)
+} zc_edge_result_t;
+
+// Tracker state
+typedef struct {
+    int32_t offset_us;          // Added to an edge time to get the true crossing
+    zc_lock_state_t state;
+    uint32_t period_q8;         // Half-cycle period estimate (1/256 us)
+    uint32_t jitter_q8;         // Mean absolute phase error (1/256 us)
+    uint64_t last;              // Crossing in progress
+    uint64_t next;              // Predicted next crossing
+    bool last_matched;          // An edge confirmed the crossing in progress
+    bool next_matched;          // An edge confirmed the next crossing
+    uint8_t coasted;            // Consecutive crossings without an edge
+    uint8_t frequency;          // Detected mains frequency (50/60), 0 if unknown
+
+    // Lock acquisition
+    uint64_t acq_last_edge;
+    uint32_t acq_first;
+    uint32_t acq_sum;
+    uint8_t acq_count;
+
+    // Supervision counters, kept across re-synchronisation
+    uint32_t missed;            // Crossings that passed without an edge while locked
+    uint32_t spurious;          // Edges rejected while locked (glitches, chatter)
+} zc_tracker_t;
+
+// Function prototypes
+void zc_tracker_init(zc_tracker_t *t, int32_t offset_us);
+zc_edge_result_t zc_tracker_edge(zc_tracker_t *t, uint64_t edge_time);
+uint64_t zc_tracker_advance(zc_tracker_t *t);
+void zc_tracker_resync(zc_tracker_t *t);
+
+// Current half-cycle estimate, nominal 50Hz until locked
+static inline uint32_t zc_tracker_half_cycle_us(const zc_tracker_t *t) {
+    return (t->state == ZC_STATE_LOCKED) ? (t->period_q8 >> 8) : 10000;
+}
+
+static inline bool zc_tracker_is_locked(const zc_tracker_t *t) {
+    return t->state == ZC_STATE_LOCKED;
+}
+
+#endif // ZERO_CROSS_TRACKER_H
@@ -81,6 +81,7 @@ esp_err_t zigbee_thermostat_update_occupancy(zigbee_thermostat_t *device, bool o
 esp_err_t zigbee_thermostat_update_window_state(zigbee_thermostat_t *device, bool open);
 esp_err_t zigbee_thermostat_update_mode(zigbee_thermostat_t *device, thermor_mode_t mode);
 esp_err_t zigbee_thermostat_update_power(zigbee_thermostat_t *device, uint16_t power);
+esp_err_t zigbee_thermostat_update_energy(zigbee_thermostat_t *device, uint32_t energy_wh);
 esp_err_t zigbee_thermostat_report_attributes(zigbee_thermostat_t *device);
 
 // Zigbee callbacks
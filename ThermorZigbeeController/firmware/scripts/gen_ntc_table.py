@@ -0,0 +1,95 @@
+"""
+Generate src/ntc_table_default.c - NTC divider voltage to temperature table.
+
+The thermistor sits on the ADC side of a divider fed from the ADC full scale:
+
+    R(mV) = r_series * mV / (supply - mV)
+    1/T   = 1/T0 + ln(R / R0) / beta
+
+Only beta, T0 and r_series / R0 shape the curve, so one table serves every
+sensor built with the default values. These are read from
+include/ntc_table.h (NTC_DEFAULT_*, NTC_TABLE_*), which stays the single
+place to change them; entries are centi-degrees on a uniform mV grid,
+clamped to the table range at the two open/short ends.
+
+Runs as a PlatformIO pre-script (see platformio.ini) and can also be run by
+hand: python3 scripts/gen_ntc_table.py
+"""
+
+import math
+import os
+import re
+
+KELVIN = 273.15
+
+
+def read_defines(project_dir):
+    path = os.path.join(project_dir, "include", "ntc_table.h")
+    defines = {}
+    with open(path) as f:
+        for line in f:
+            m = re.match(r"#define\s+(NTC_(?:DEFAULT|TABLE)_\w+)\s+(-?[\d.]+)\b", line)
+            if m:
+                defines[m.group(1)] = float(m.group(2))
+    return defines
+
+
+def temperature_centi(mv, d):
+    supply = d["NTC_TABLE_SUPPLY_MV"]
+    if mv <= 0:
+        return d["NTC_TABLE_MAX_CENTI"]
+    if mv >= supply:
+        return d["NTC_TABLE_MIN_CENTI"]
+    ratio = d["NTC_DEFAULT_SERIES_RATIO"] * mv / (supply - mv)  # R / R0
+    inv_t = 1.0 / (d["NTC_DEFAULT_T_NOMINAL"] + KELVIN) + math.log(ratio) / d["NTC_DEFAULT_BETA"]
+    centi = int(round((1.0 / inv_t - KELVIN) * 100.0))
+    return max(int(d["NTC_TABLE_MIN_CENTI"]), min(int(d["NTC_TABLE_MAX_CENTI"]), centi))
+
+
+def format_array(ctype, name, size, values, per_line=10):
+    lines = ["const %s %s[%s] = {" % (ctype, name, size)]
+    for i in range(0, len(values), per_line):
+        chunk = ", ".join("%6d" % v for v in values[i:i + per_line])
+        lines.append("    %s," % chunk)
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def render(d):
+    step = int(d["NTC_TABLE_STEP_MV"])
+    size = int(d["NTC_TABLE_SUPPLY_MV"]) // step + 1
+    parts = [
+        "// Generated by scripts/gen_ntc_table.py - do not edit.",
+        "// beta %g, T0 %gC, r_series/R0 %g, %dmV supply" % (
+            d["NTC_DEFAULT_BETA"], d["NTC_DEFAULT_T_NOMINAL"],
+            d["NTC_DEFAULT_SERIES_RATIO"], d["NTC_TABLE_SUPPLY_MV"]),
+        "",
+        '#include "ntc_table.h"',
+        "",
+        "// Temperature (centi-degrees) at i * NTC_TABLE_STEP_MV",
+        format_array("int16_t", "ntc_default_centi", "NTC_TABLE_SIZE",
+                     [temperature_centi(i * step, d) for i in range(size)]),
+        "",
+    ]
+    return "\n".join(parts)
+
+
+def generate(project_dir):
+    path = os.path.join(project_dir, "src", "ntc_table_default.c")
+    content = render(read_defines(project_dir))
+    try:
+        with open(path) as f:
+            if f.read() == content:
+                return
+    except OSError:
+        pass
+    with open(path, "w") as f:
+        f.write(content)
+    print("Generated %s" % path)
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    generate(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    generate(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
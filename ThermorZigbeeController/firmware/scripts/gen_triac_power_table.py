@@ -0,0 +1,105 @@
+"""
+Generate src/triac_power_table.c - phase-control power lookup tables.
+
+For a resistive load fired at angle a (0..pi) after each zero crossing, the
+RMS power delivered, relative to full conduction, is
+
+    P(a) = 1 - a/pi + sin(2a) / (2*pi)
+
+The firmware has no FPU, so both directions of this relationship are
+precomputed here:
+
+  * triac_delay_50hz_us / triac_delay_60hz_us: firing delay for each whole
+    power percent (exact inverse of P, solved by bisection)
+  * triac_power_by_angle_q15: P sampled on a uniform angle grid, used with
+    linear interpolation for the delay -> power direction
+
+Runs as a PlatformIO pre-script (see platformio.ini) and can also be run by
+hand: python3 scripts/gen_triac_power_table.py
+"""
+
+import math
+import os
+
+POWER_STEPS = 100      # Must match TRIAC_POWER_STEPS
+ANGLE_SEGMENTS = 64    # Must match TRIAC_ANGLE_SEGMENTS
+Q15_ONE = 32768
+
+
+def power_fraction(angle):
+    return 1.0 - angle / math.pi + math.sin(2.0 * angle) / (2.0 * math.pi)
+
+
+def angle_for_power(fraction):
+    # P is monotonically decreasing on [0, pi]
+    lo, hi = 0.0, math.pi
+    for _ in range(100):
+        mid = 0.5 * (lo + hi)
+        if power_fraction(mid) > fraction:
+            lo = mid
+        else:
+            hi = mid
+    return 0.5 * (lo + hi)
+
+
+def delay_table(half_cycle_us):
+    return [int(round(angle_for_power(p / POWER_STEPS) / math.pi * half_cycle_us))
+            for p in range(POWER_STEPS + 1)]
+
+
+def power_table():
+    return [int(round(power_fraction(math.pi * i / ANGLE_SEGMENTS) * Q15_ONE))
+            for i in range(ANGLE_SEGMENTS + 1)]
+
+
+def format_array(ctype, name, size, values, per_line=10):
+    lines = ["const %s DRAM_ATTR %s[%s] = {" % (ctype, name, size)]
+    for i in range(0, len(values), per_line):
+        chunk = ", ".join("%5d" % v for v in values[i:i + per_line])
+        lines.append("    %s," % chunk)
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def render():
+    parts = [
+        "// Generated by scripts/gen_triac_power_table.py - do not edit.",
+        "// P(a) = 1 - a/pi + sin(2a)/(2*pi), a = firing angle",
+        "",
+        '#include "triac_power_table.h"',
+        "",
+        "// Firing delay (us) for 0..100% power, 50Hz mains (10000us half-cycle)",
+        format_array("uint16_t", "triac_delay_50hz_us", "TRIAC_POWER_STEPS + 1",
+                     delay_table(1000000.0 / 100)),
+        "",
+        "// Firing delay (us) for 0..100% power, 60Hz mains (8333us half-cycle)",
+        format_array("uint16_t", "triac_delay_60hz_us", "TRIAC_POWER_STEPS + 1",
+                     delay_table(1000000.0 / 120)),
+        "",
+        "// Relative power (Q15) at angle pi * i / TRIAC_ANGLE_SEGMENTS",
+        format_array("uint16_t", "triac_power_by_angle_q15", "TRIAC_ANGLE_SEGMENTS + 1",
+                     power_table(), per_line=8),
+        "",
+    ]
+    return "\n".join(parts)
+
+
+def generate(project_dir):
+    path = os.path.join(project_dir, "src", "triac_power_table.c")
+    content = render()
+    try:
+        with open(path) as f:
+            if f.read() == content:
+                return
+    except OSError:
+        pass
+    with open(path, "w") as f:
+        f.write(content)
+    print("Generated %s" % path)
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    generate(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    generate(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
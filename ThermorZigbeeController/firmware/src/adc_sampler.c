@@ -0,0 +1,323 @@
+#include "adc_sampler.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "freertos/event_groups.h"
+#include "soc/soc_caps.h"
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "ADCSampler";
+
+#define READY_BIT           BIT0
+#define FRAMES_PER_VALUE    2       // DMA interrupts per averaged value
+#define POOL_FRAMES         4       // Driver buffer, in frames
+
+// Latest value of one channel
+typedef struct {
+    uint32_t mv;
+    int64_t time_us;         // esp_timer time it was completed
+    bool valid;
+} adc_value_t;
+
+// Running average of one channel
+typedef struct {
+    uint32_t sum;
+    uint16_t count;
+} adc_accumulator_t;
+
+static adc_continuous_handle_t g_adc = NULL;
+static adc_cali_handle_t g_cali[ADC_SAMPLER_MAX_CHANNELS];
+static adc_channel_t g_channels[ADC_SAMPLER_MAX_CHANNELS];
+static uint8_t g_num_channels = 0;
+static uint32_t g_channel_mask = 0;
+static uint16_t g_average = ADC_SAMPLER_AVERAGE;
+
+static TaskHandle_t g_task = NULL;
+static TaskHandle_t g_notify = NULL;
+static EventGroupHandle_t g_events = NULL;
+static uint8_t *g_frame = NULL;
+static uint32_t g_frame_bytes = 0;
+
+static adc_accumulator_t g_acc[ADC_SAMPLER_MAX_CHANNELS];
+static adc_value_t g_values[ADC_SAMPLER_MAX_CHANNELS];
+static portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t g_frames = 0;
+static volatile uint32_t g_overflows = 0;
+static uint32_t g_sample_rate_hz = 0;
+
+static bool IRAM_ATTR conv_done_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata,
+                                   void *user_data) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(g_task, &woken);
+    return woken == pdTRUE;
+}
+
+static bool IRAM_ATTR pool_ovf_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata,
+                                  void *user_data) {
+    g_overflows++;
+    return false;
+}
+
+// Calibration per channel; without eFuse data, a plain scale of full range
+static void create_calibration(uint8_t index) {
+    g_cali[index] = NULL;
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t cali_config = {
+        .unit_id = ADC_UNIT_1,
+        .chan = g_channels[index],
+        .atten = ADC_SAMPLER_ATTEN,
+        .bitwidth = ADC_BITWIDTH_12,
+    };
+    if (adc_cali_create_scheme_curve_fitting(&cali_config, &g_cali[index]) != ESP_OK) {
+        g_cali[index] = NULL;
+    }
+#endif
+    if (!g_cali[index]) {
+        ESP_LOGW(TAG, "No calibration for channel %d, using nominal full scale", g_channels[index]);
+    }
+}
+
+static uint32_t raw_to_mv(uint8_t index, uint32_t raw) {
+    int mv;
+    if (g_cali[index] && adc_cali_raw_to_voltage(g_cali[index], raw, &mv) == ESP_OK) {
+        return mv < 0 ? 0 : mv;
+    }
+    return raw * ADC_SAMPLER_FULL_SCALE_MV / ((1 << 12) - 1);
+}
+
+// Average a completed frame into the channels; true once each has a new value
+static bool process_frame(const uint8_t *frame, uint32_t len) {
+    static uint32_t pending = 0;
+
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t *result = (const adc_digi_output_data_t *)&frame[i];
+        uint32_t channel = result->type2.channel;
+        if (result->type2.unit != ADC_UNIT_1 || channel >= ADC_SAMPLER_MAX_CHANNELS ||
+            !(g_channel_mask & (1u << channel))) {
+            continue;
+        }
+
+        uint8_t index = 0;
+        while (g_channels[index] != channel) {
+            index++;
+        }
+        adc_accumulator_t *acc = &g_acc[index];
+        acc->sum += result->type2.data;
+        if (++acc->count < g_average) {
+            continue;
+        }
+
+        uint32_t mv = raw_to_mv(index, (acc->sum + acc->count / 2) / acc->count);
+        acc->sum = 0;
+        acc->count = 0;
+        portENTER_CRITICAL(&g_lock);
+        g_values[index].mv = mv;
+        g_values[index].time_us = esp_timer_get_time();
+        g_values[index].valid = true;
+        portEXIT_CRITICAL(&g_lock);
+        pending |= 1u << channel;
+    }
+
+    if (pending == g_channel_mask) {
+        pending = 0;
+        return true;
+    }
+    return false;
+}
+
+static void sampler_task(void *pvParameters) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Everything the DMA has completed so far, without waiting for more
+        uint32_t len = 0;
+        while (adc_continuous_read(g_adc, g_frame, g_frame_bytes, &len, 0) == ESP_OK) {
+            g_frames++;
+            if (process_frame(g_frame, len)) {
+                xEventGroupSetBits(g_events, READY_BIT);
+                TaskHandle_t notify = g_notify;
+                if (notify) {
+                    xTaskNotifyGive(notify);
+                }
+            }
+        }
+    }
+}
+
+esp_err_t adc_sampler_add_channel(adc_channel_t channel) {
+    if (channel >= ADC_SAMPLER_MAX_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_channel_mask & (1u << channel)) {
+        return ESP_OK;
+    }
+    if (g_adc) {
+        ESP_LOGE(TAG, "Channel %d added after start", channel);
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_channels[g_num_channels++] = channel;
+    g_channel_mask |= 1u << channel;
+    return ESP_OK;
+}
+
+esp_err_t adc_sampler_start(const adc_sampler_config_t *config) {
+    if (!config || config->output_hz == 0 || config->average == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_adc) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (g_num_channels == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // The converter has a minimum rate: average more rather than run slower
+    g_average = config->average;
+    while (g_num_channels * g_average * config->output_hz < SOC_ADC_SAMPLE_FREQ_THRES_LOW) {
+        g_average *= 2;
+    }
+    g_sample_rate_hz = g_num_channels * g_average * config->output_hz;
+    if (g_sample_rate_hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) {
+        ESP_LOGE(TAG, "%" PRIu32 " Hz is beyond the ADC", g_sample_rate_hz);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // A frame per half value: the task wakes FRAMES_PER_VALUE times per output
+    uint32_t results = g_num_channels * g_average / FRAMES_PER_VALUE;
+    g_frame_bytes = results * SOC_ADC_DIGI_RESULT_BYTES;
+    g_frame = malloc(g_frame_bytes);
+    g_events = xEventGroupCreate();
+    if (!g_frame || !g_events) {
+        adc_sampler_stop();
+        return ESP_ERR_NO_MEM;
+    }
+    memset(g_acc, 0, sizeof(g_acc));
+    memset(g_values, 0, sizeof(g_values));
+    g_notify = config->notify;
+
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = g_frame_bytes * POOL_FRAMES,
+        .conv_frame_size = g_frame_bytes,
+    };
+    esp_err_t ret = adc_continuous_new_handle(&handle_config, &g_adc);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create the continuous ADC: %s", esp_err_to_name(ret));
+        g_adc = NULL;
+        adc_sampler_stop();
+        return ret;
+    }
+
+    adc_digi_pattern_config_t pattern[ADC_SAMPLER_MAX_CHANNELS];
+    for (uint8_t i = 0; i < g_num_channels; i++) {
+        pattern[i] = (adc_digi_pattern_config_t){
+            .atten = ADC_SAMPLER_ATTEN,
+            .channel = g_channels[i],
+            .unit = ADC_UNIT_1,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        };
+        create_calibration(i);
+    }
+    adc_continuous_config_t adc_config = {
+        .pattern_num = g_num_channels,
+        .adc_pattern = pattern,
+        .sample_freq_hz = g_sample_rate_hz,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+    };
+    adc_continuous_evt_cbs_t callbacks = {
+        .on_conv_done = conv_done_cb,
+        .on_pool_ovf = pool_ovf_cb,
+    };
+
+    if (xTaskCreate(sampler_task, "adc_sampler", ADC_SAMPLER_TASK_STACK, NULL,
+                    ADC_SAMPLER_TASK_PRIORITY, &g_task) != pdPASS) {
+        g_task = NULL;
+        adc_sampler_stop();
+        return ESP_ERR_NO_MEM;
+    }
+    ret = adc_continuous_config(g_adc, &adc_config);
+    if (ret == ESP_OK) {
+        ret = adc_continuous_register_event_callbacks(g_adc, &callbacks, NULL);
+    }
+    if (ret == ESP_OK) {
+        ret = adc_continuous_start(g_adc);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start the continuous ADC: %s", esp_err_to_name(ret));
+        adc_sampler_stop();
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "%d channels at %" PRIu32 " Hz, %d-sample averages at %" PRIu32 " Hz",
+             g_num_channels, g_sample_rate_hz, g_average, config->output_hz);
+    return ESP_OK;
+}
+
+esp_err_t adc_sampler_stop(void) {
+    if (g_adc) {
+        adc_continuous_stop(g_adc);
+        adc_continuous_deinit(g_adc);
+        g_adc = NULL;
+    }
+    if (g_task) {
+        vTaskDelete(g_task);
+        g_task = NULL;
+    }
+    for (uint8_t i = 0; i < g_num_channels; i++) {
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+        if (g_cali[i]) {
+            adc_cali_delete_scheme_curve_fitting(g_cali[i]);
+        }
+#endif
+        g_cali[i] = NULL;
+    }
+    if (g_events) {
+        vEventGroupDelete(g_events);
+        g_events = NULL;
+    }
+    free(g_frame);
+    g_frame = NULL;
+    return ESP_OK;
+}
+
+esp_err_t adc_sampler_get_mv(adc_channel_t channel, uint32_t *mv) {
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+    int64_t now = esp_timer_get_time();
+
+    for (uint8_t i = 0; i < g_num_channels; i++) {
+        if (g_channels[i] != channel) {
+            continue;
+        }
+        portENTER_CRITICAL(&g_lock);
+        if (g_values[i].valid && now - g_values[i].time_us <= (int64_t)ADC_SAMPLER_STALE_MS * 1000) {
+            *mv = g_values[i].mv;
+            ret = ESP_OK;
+        }
+        portEXIT_CRITICAL(&g_lock);
+        break;
+    }
+    return ret;
+}
+
+esp_err_t adc_sampler_wait_ready(uint32_t timeout_ms) {
+    if (!g_events) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    EventBits_t bits = xEventGroupWaitBits(g_events, READY_BIT, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms));
+    return (bits & READY_BIT) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+void adc_sampler_set_notify(TaskHandle_t task) {
+    g_notify = task;
+}
+
+void adc_sampler_get_stats(adc_sampler_stats_t *stats) {
+    stats->frames = g_frames;
+    stats->overflows = g_overflows;
+    stats->sample_rate_hz = g_sample_rate_hz;
+}
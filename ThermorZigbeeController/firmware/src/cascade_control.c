@@ -0,0 +1,95 @@
+#include "cascade_control.h"
+#include "esp_log.h"
+
+static const char *TAG = "Cascade";
+
+// Limits in Q16.16, folded at compile time
+#define SURFACE_MIN_VALID_Q ((pid_q16_t)(CASCADE_SURFACE_MIN_VALID * PID_Q16_ONE))
+#define SURFACE_MAX_VALID_Q ((pid_q16_t)(CASCADE_SURFACE_MAX_VALID * PID_Q16_ONE))
+#define TRIP_HYSTERESIS_Q   ((pid_q16_t)(CASCADE_TRIP_HYSTERESIS * PID_Q16_ONE))
+
+static bool surface_valid_q16(pid_q16_t surface_temp) {
+    return surface_temp >= SURFACE_MIN_VALID_Q && surface_temp <= SURFACE_MAX_VALID_Q;
+}
+
+esp_err_t cascade_controller_init(cascade_controller_t *cascade, const cascade_config_t *config) {
+    if (!cascade || !config || config->inner.sample_time_ms == 0 ||
+        config->outer.sample_time_ms < config->inner.sample_time_ms ||
+        config->outer.sample_time_ms % config->inner.sample_time_ms != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pid_config_t outer = config->outer;
+    if (outer.output_max > config->surface_ceiling - CASCADE_SETPOINT_MARGIN) {
+        outer.output_max = config->surface_ceiling - CASCADE_SETPOINT_MARGIN;
+    }
+    pid_controller_init(&cascade->outer, &outer);
+    pid_controller_init(&cascade->inner, &config->inner);
+
+    cascade->surface_ceiling = config->surface_ceiling;
+    cascade->surface_ceiling_q = pid_q16_from_float(config->surface_ceiling);
+    cascade->surface_setpoint = cascade->outer.out_min_q;
+    cascade->outer_every = config->outer.sample_time_ms / config->inner.sample_time_ms;
+    cascade->steps = 0;
+    cascade->tripped = false;
+    cascade->trips = 0;
+    return ESP_OK;
+}
+
+bool cascade_surface_valid(float surface_temp) {
+    return surface_temp >= CASCADE_SURFACE_MIN_VALID && surface_temp <= CASCADE_SURFACE_MAX_VALID;
+}
+
+pid_q16_t cascade_controller_compute_q16(cascade_controller_t *cascade, pid_q16_t room_setpoint,
+                                         pid_q16_t room_temp, pid_q16_t surface_temp) {
+    // Hard limit first: nothing below overrides it
+    bool valid = surface_valid_q16(surface_temp);
+    if (!valid || surface_temp >= cascade->surface_ceiling_q) {
+        if (!cascade->tripped) {
+            cascade->tripped = true;
+            cascade->trips++;
+            if (valid) {
+                ESP_LOGW(TAG, "Heater surface %.1fC over the ceiling, power cut",
+                         pid_q16_to_float(surface_temp));
+            } else {
+                ESP_LOGW(TAG, "Heater surface reading invalid, power cut");
+            }
+        }
+        pid_controller_reset(&cascade->inner);
+        return 0;
+    }
+    if (cascade->tripped) {
+        if (surface_temp > cascade->surface_ceiling_q - TRIP_HYSTERESIS_Q) {
+            return 0;
+        }
+        cascade->tripped = false;
+        ESP_LOGI(TAG, "Heater surface back to %.1fC, power restored", pid_q16_to_float(surface_temp));
+    }
+
+    // Outer loop at its own, slower rate
+    if (cascade->steps == 0) {
+        cascade->surface_setpoint = pid_controller_compute_q16(&cascade->outer, room_setpoint, room_temp);
+    }
+    if (++cascade->steps >= cascade->outer_every) {
+        cascade->steps = 0;
+    }
+
+    return pid_controller_compute_q16(&cascade->inner, cascade->surface_setpoint, surface_temp);
+}
+
+float cascade_controller_compute(cascade_controller_t *cascade, float room_setpoint,
+                                 float room_temp, float surface_temp) {
+    // NAN and out-of-range readings must not reach the conversion
+    pid_q16_t surface_q = cascade_surface_valid(surface_temp) ? pid_q16_from_float(surface_temp)
+                                                              : CASCADE_SURFACE_NONE;
+    pid_q16_t output = cascade_controller_compute_q16(cascade, pid_q16_from_float(room_setpoint),
+                                                      pid_q16_from_float(room_temp), surface_q);
+    return pid_q16_to_float(output);
+}
+
+void cascade_controller_reset(cascade_controller_t *cascade) {
+    pid_controller_reset(&cascade->outer);
+    pid_controller_reset(&cascade->inner);
+    cascade->surface_setpoint = cascade->outer.out_min_q;
+    cascade->steps = 0;
+}
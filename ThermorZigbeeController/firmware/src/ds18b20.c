@@ -0,0 +1,173 @@
+#include "ds18b20.h"
+#include "onewire_bus.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "DS18B20";
+
+// Latest result of one sensor
+typedef struct {
+    float celsius;
+    int64_t time_us;         // esp_timer time it was read
+    bool valid;
+} ds18b20_reading_t;
+
+static onewire_bus_t g_bus;
+static TaskHandle_t g_task = NULL;
+static gpio_num_t g_pin;
+
+// Sensors and readings: written by the bus task, read by anyone
+static onewire_rom_t g_roms[DS18B20_MAX_SENSORS];
+static ds18b20_reading_t g_readings[DS18B20_MAX_SENSORS];
+static uint8_t g_count = 0;
+static portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Enumerate the bus, keeping the DS18B20s in search order
+static void find_sensors(void) {
+    onewire_rom_t roms[DS18B20_MAX_SENSORS];
+    size_t found = 0;
+    uint8_t count = 0;
+
+    esp_err_t ret = onewire_bus_search(&g_bus, roms, DS18B20_MAX_SENSORS, &found);
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_FOUND) {
+        ESP_LOGW(TAG, "ROM search stopped: %s", esp_err_to_name(ret));
+    }
+
+    portENTER_CRITICAL(&g_lock);
+    for (size_t i = 0; i < found; i++) {
+        if (roms[i].bytes[0] == DS18B20_FAMILY) {
+            g_roms[count++] = roms[i];
+        }
+    }
+    memset(g_readings, 0, sizeof(g_readings));
+    g_count = count;
+    portEXIT_CRITICAL(&g_lock);
+
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t *b = g_roms[i].bytes;
+        ESP_LOGI(TAG, "Sensor %d: %02X%02X%02X%02X%02X%02X%02X%02X", i,
+                 b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7]);
+    }
+    if (count == 0) {
+        ESP_LOGW(TAG, "No DS18B20 on GPIO%d", g_pin);
+    }
+}
+
+// Collect the conversion started on the previous round
+static bool read_sensor(uint8_t index) {
+    const uint8_t command = DS18B20_CMD_READ_SCRATCHPAD;
+    uint8_t scratchpad[DS18B20_SCRATCHPAD_LEN];
+    int16_t raw;
+    float celsius;
+
+    esp_err_t ret = onewire_bus_select(&g_bus, &g_roms[index]);
+    if (ret == ESP_OK) {
+        ret = onewire_bus_write(&g_bus, &command, 1);
+    }
+    if (ret == ESP_OK) {
+        ret = onewire_bus_read(&g_bus, scratchpad, sizeof(scratchpad));
+    }
+    if (ret != ESP_OK || !ds18b20_decode(scratchpad, &raw, &celsius)) {
+        ESP_LOGD(TAG, "Sensor %d: no valid scratchpad (%s)", index, esp_err_to_name(ret));
+        return false;
+    }
+    // The reset value until a conversion has completed
+    if (raw == DS18B20_POWER_ON_RAW && !g_readings[index].valid) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&g_lock);
+    g_readings[index].celsius = celsius;
+    g_readings[index].time_us = esp_timer_get_time();
+    g_readings[index].valid = true;
+    portEXIT_CRITICAL(&g_lock);
+    return true;
+}
+
+// Each round reads the previous conversion and starts the next one, so the
+// conversion time is spent between wakeups rather than waiting on the bus.
+// DS18B20_PERIOD_MS must exceed DS18B20_CONVERSION_MS.
+static void bus_task(void *pvParameters) {
+    const uint8_t convert = DS18B20_CMD_CONVERT_T;
+    TickType_t wake = xTaskGetTickCount();
+    bool converting = false;
+    uint8_t failed_rounds = 0;
+
+    while (1) {
+        if (g_count == 0) {
+            find_sensors();
+            converting = false;
+            if (g_count == 0) {
+                vTaskDelay(pdMS_TO_TICKS(DS18B20_SEARCH_RETRY_MS));
+                wake = xTaskGetTickCount();
+                continue;
+            }
+        }
+
+        if (converting) {
+            uint8_t read = 0;
+            for (uint8_t i = 0; i < g_count; i++) {
+                read += read_sensor(i);
+            }
+            failed_rounds = read ? 0 : failed_rounds + 1;
+            if (failed_rounds >= DS18B20_FAILED_ROUNDS) {
+                ESP_LOGW(TAG, "No reading for %d rounds, searching the bus again", failed_rounds);
+                failed_rounds = 0;
+                portENTER_CRITICAL(&g_lock);
+                g_count = 0;
+                portEXIT_CRITICAL(&g_lock);
+                continue;
+            }
+        }
+
+        // All sensors at once
+        esp_err_t ret = onewire_bus_select(&g_bus, NULL);
+        if (ret == ESP_OK) {
+            ret = onewire_bus_write(&g_bus, &convert, 1);
+        }
+        converting = (ret == ESP_OK);
+
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(DS18B20_PERIOD_MS));
+    }
+}
+
+esp_err_t ds18b20_start(gpio_num_t pin) {
+    if (g_task) {
+        return pin == g_pin ? ESP_OK : ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = onewire_bus_init(&g_bus, pin);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    g_pin = pin;
+    if (xTaskCreate(bus_task, "ds18b20", DS18B20_TASK_STACK, NULL, DS18B20_TASK_PRIORITY,
+                    &g_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create bus task");
+        onewire_bus_deinit(&g_bus);
+        g_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ds18b20_get(uint8_t index, float *celsius) {
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&g_lock);
+    if (index < g_count && g_readings[index].valid &&
+        now - g_readings[index].time_us <= (int64_t)DS18B20_STALE_MS * 1000) {
+        *celsius = g_readings[index].celsius;
+        ret = ESP_OK;
+    }
+    portEXIT_CRITICAL(&g_lock);
+    return ret;
+}
+
+uint8_t ds18b20_count(void) {
+    return g_count;
+}
@@ -0,0 +1,104 @@
+#include "energy_meter.h"
+#include "triac_control.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+static const char *TAG = "EnergyMeter";
+
+#define NVS_NAMESPACE   "energy"
+#define NVS_KEY_TOTAL   "total_mwh"
+
+// Meter state
+static uint16_t g_max_power_watts = 0;
+static uint8_t g_num_channels = 0;
+static uint64_t g_boot_mwh = 0;         // Lifetime total at boot (from NVS)
+static uint64_t g_total_mwh = 0;        // Lifetime total at the last update
+static uint64_t g_saved_mwh = 0;        // Total in the last checkpoint
+static int64_t g_saved_time = 0;        // esp_timer time of the last checkpoint
+
+static esp_err_t save_total(uint64_t total_mwh) {
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = nvs_set_u64(handle, NVS_KEY_TOTAL, total_mwh);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return ret;
+}
+
+esp_err_t energy_meter_init(uint16_t max_power_watts, uint8_t num_channels) {
+    if (max_power_watts == 0 || num_channels == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    g_max_power_watts = max_power_watts;
+    g_num_channels = num_channels;
+    g_boot_mwh = 0;
+
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        nvs_get_u64(handle, NVS_KEY_TOTAL, &g_boot_mwh);
+        nvs_close(handle);
+    }
+
+    g_total_mwh = g_boot_mwh;
+    g_saved_mwh = g_boot_mwh;
+    g_saved_time = esp_timer_get_time();
+
+    ESP_LOGI(TAG, "Energy meter initialized, lifetime total %llu Wh",
+             (unsigned long long)(g_boot_mwh / 1000));
+    return ESP_OK;
+}
+
+esp_err_t energy_meter_update(void) {
+    if (g_num_channels == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint64_t full_power_us = 0;
+    for (int i = 0; i < g_num_channels; i++) {
+        full_power_us += triac_control_get_energy_us(i);
+    }
+    g_total_mwh = g_boot_mwh + energy_us_to_mwh(full_power_us, g_max_power_watts, g_num_channels);
+
+    // Bounded flash wear: a write needs both the interval and new energy
+    int64_t now = esp_timer_get_time();
+    if (now - g_saved_time >= (int64_t)ENERGY_CHECKPOINT_INTERVAL_S * 1000000 &&
+        g_total_mwh - g_saved_mwh >= ENERGY_CHECKPOINT_MIN_MWH) {
+        return energy_meter_checkpoint();
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t energy_meter_checkpoint(void) {
+    if (g_total_mwh == g_saved_mwh) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = save_total(g_total_mwh);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save energy checkpoint: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    g_saved_mwh = g_total_mwh;
+    g_saved_time = esp_timer_get_time();
+    ESP_LOGD(TAG, "Checkpoint: %llu mWh", (unsigned long long)g_total_mwh);
+
+    return ESP_OK;
+}
+
+uint64_t energy_meter_get_mwh(void) {
+    return g_total_mwh;
+}
+
+uint32_t energy_meter_get_wh(void) {
+    return (uint32_t)(g_total_mwh / 1000);
+}
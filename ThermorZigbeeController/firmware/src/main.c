@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
+#include <math.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -8,7 +10,6 @@
 #include "esp_timer.h"
 #include "nvs_flash.h"
 #include "driver/gpio.h"
-#include "driver/adc.h"
 
 // Application headers
 #include "ht1621_driver.h"
@@ -16,8 +17,13 @@
 #include "thermor_ui.h"
 #include "zigbee_thermostat.h"
 #include "pid_controller.h"
+#include "thermal_model.h"
+#include "cascade_control.h"
+#include "setpoint_ramp.h"
 #include "triac_control.h"
 #include "temperature_sensor.h"
+#include "adc_sampler.h"
+#include "energy_meter.h"
 
 static const char *TAG = "ThermorMain";
 
@@ -42,12 +48,32 @@ static const char *TAG = "ThermorMain";
 #define PIR_SENSOR_PIN      GPIO_NUM_2
 #define WINDOW_SENSOR_PIN   GPIO_NUM_3
 
+#define CONTROL_SAMPLE_TIMEOUT_MS   5000    // Heating off if the sensor goes quiet this long
+#define SENSOR_POLL_MS              100     // Sensor loop without ADC notifications (1-Wire only)
+
+// Filtered temperature sample, handed from sensor_task to control_task
+typedef struct {
+    float temperature;
+    float surface;           // Heater body (cascade mode), NAN if no valid reading
+    pid_q16_t temperature_q; // Both again in Q16.16 for the control law,
+    pid_q16_t surface_q;     // CASCADE_SURFACE_NONE if no valid reading
+    int64_t time_us;         // esp_timer time the sample was completed
+} control_sample_t;
+
 // Global objects
 static thermor_ui_t g_ui;
 static zigbee_thermostat_t g_zigbee_device;
 static QueueHandle_t g_button_queue;
 static pid_controller_t g_pid;
+static bool g_auto_tune_pending = false;  // No tuned gains stored for this room yet
+static thermal_model_t g_thermal_model;   // Identified room, re-derives the gains as it drifts
 static temp_sensor_t g_temp_sensor;
+static temp_sensor_t g_surface_sensor;    // Second NTC, on the heater body
+static cascade_controller_t g_cascade;
+static bool g_cascade_enabled = false;    // Surface NTC fitted: room loop drives a surface loop
+static setpoint_ramp_t g_setpoint_ramp;   // Eases the loop into a new target
+static control_sample_t g_sample;
+static portMUX_TYPE g_sample_lock = portMUX_INITIALIZER_UNLOCKED;
 
 // Task handles
 static TaskHandle_t g_ui_task_handle = NULL;
@@ -79,56 +105,138 @@ static void ui_task(void *pvParameters) {
     }
 }
 
-// Control Task - PID control and heating management
+// Control Task - PID control and heating management. One control step per
+// filtered sample: sensor_task notifies this task when a sample is ready.
 static void control_task(void *pvParameters) {
     float last_temp = 0;
-    uint32_t last_control_time = 0;
+    uint32_t last_energy_report = 0;
+    int64_t last_sample_us = 0;
+    thermal_model_params_t room_model = {0};  // Untrusted until the model converges
     
     while (1) {
-        uint32_t current_time = esp_timer_get_time() / 1000;
+        uint32_t pending = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONTROL_SAMPLE_TIMEOUT_MS));
+        if (pending == 0) {
+            // No temperature for a while: never keep heating blind
+            ESP_LOGW(TAG, "No temperature sample for %d ms, heating off", CONTROL_SAMPLE_TIMEOUT_MS);
+            pid_controller_set_auto_tune(&g_pid, false);
+            thermal_model_hold(&g_thermal_model);
+            triac_control_enable(false);  // Cut at once, without the ramp-down
+            thermor_ui_set_heating_state(&g_ui, false);
+            zigbee_thermostat_update_heating_state(&g_zigbee_device, false);
+            continue;
+        }
+        if (pending > 1) {
+            ESP_LOGW(TAG, "Control step late, %" PRIu32 " samples merged", pending);
+        }
         
-        // Run PID control every second
-        if ((current_time - last_control_time) >= 1000) {
-            last_control_time = current_time;
-            
-            float current_temp = g_ui.config.current_temp;
-            float target_temp = thermor_ui_get_target_temperature(&g_ui);
-            
-            // Check for window open detection
-            if (g_ui.config.window_open && g_ui.config.window_detection_enabled) {
-                // Force heating off when window is open
-                pid_controller_reset(&g_pid);
-                triac_control_set_power(0);
-                thermor_ui_set_heating_state(&g_ui, false);
-                zigbee_thermostat_update_heating_state(&g_zigbee_device, false);
-            } else if (target_temp > 0) {
-                // Run PID control
-                float output = pid_controller_compute(&g_pid, target_temp, current_temp);
-                
-                // Convert PID output (0-100%) to power level
-                uint8_t power_percent = (uint8_t)(output);
-                triac_control_set_power(power_percent);
-                
-                // Update heating state
-                bool heating = (power_percent > 0);
-                thermor_ui_set_heating_state(&g_ui, heating);
-                zigbee_thermostat_update_heating_state(&g_zigbee_device, heating);
+        control_sample_t sample;
+        portENTER_CRITICAL(&g_sample_lock);
+        sample = g_sample;
+        portEXIT_CRITICAL(&g_sample_lock);
+        uint32_t sample_ms = sample.time_us / 1000;
+        
+        // The ramp advances by the time between samples, not by wakeups
+        float dt_s = (sample.time_us - last_sample_us) / 1e6f;
+        if (last_sample_us == 0 || dt_s <= 0.0f || dt_s > CONTROL_SAMPLE_TIMEOUT_MS / 1000.0f) {
+            dt_s = g_pid.config.sample_time_ms / 1000.0f;
+        }
+        last_sample_us = sample.time_us;
+        
+        float current_temp = sample.temperature;
+        float target_temp = thermor_ui_get_target_temperature(&g_ui);
+        
+        // Check for window open detection
+        if (g_ui.config.window_open && g_ui.config.window_detection_enabled) {
+            // Force heating off when window is open
+            pid_controller_reset(&g_pid);
+            cascade_controller_reset(&g_cascade);
+            thermal_model_hold(&g_thermal_model);
+            setpoint_ramp_track(&g_setpoint_ramp, current_temp);
+            triac_control_set_power_at(0, sample.time_us);
+            thermor_ui_set_heating_state(&g_ui, false);
+            zigbee_thermostat_update_heating_state(&g_zigbee_device, false);
+        } else if (target_temp > 0) {
+            // Rises in the target reach the loop as a ramp
+            float setpoint = setpoint_ramp_update(&g_setpoint_ramp, target_temp, current_temp, dt_s);
+            pid_q16_t setpoint_q = pid_q16_from_float(setpoint);
+            pid_q16_t output;
+            if (g_cascade_enabled) {
+                // Room loop sets the heater surface setpoint, the surface loop the power
+                output = cascade_controller_compute_q16(&g_cascade, setpoint_q, sample.temperature_q,
+                                                        sample.surface_q);
+            } else {
+                // Relay auto-tune runs inside the normal loop once the room is close
+                if (g_auto_tune_pending && fabsf(target_temp - current_temp) < 0.5f &&
+                    pid_controller_get_auto_tune_state(&g_pid) == PID_TUNE_IDLE) {
+                    pid_controller_set_auto_tune(&g_pid, true);
+                }
                 
-                // Update power consumption
-                uint16_t power_watts = (power_percent * 2000) / 100;  // Assuming 2000W heater
-                zigbee_thermostat_update_power(&g_zigbee_device, power_watts);
+                // Run PID control, with the power the ramp needs fed forward
+                pid_controller_set_feedforward(&g_pid, setpoint_ramp_feedforward(&g_setpoint_ramp, &room_model));
+                output = pid_controller_compute_q16(&g_pid, setpoint_q, sample.temperature_q);
                 
-                ESP_LOGD(TAG, "PID: Target=%.1f Current=%.1f Output=%d%%", 
-                         target_temp, current_temp, power_percent);
+                pid_tune_state_t tune_state = pid_controller_get_auto_tune_state(&g_pid);
+                if (tune_state == PID_TUNE_DONE) {
+                    if (pid_controller_save_tunings(&g_pid) != ESP_OK) {
+                        ESP_LOGW(TAG, "Failed to save tuned PID gains");
+                    }
+                    pid_controller_set_auto_tune(&g_pid, false);
+                    g_auto_tune_pending = false;
+                } else if (tune_state == PID_TUNE_FAILED) {
+                    pid_controller_set_auto_tune(&g_pid, false);
+                    g_auto_tune_pending = false;  // Keep the defaults until the next boot
+                }
+            }
+            
+            // Convert PID output (0-100%) to power level
+            uint8_t power_percent = (uint8_t)(output / PID_Q16_ONE);
+            if (g_cascade_enabled && g_cascade.tripped) {
+                // Heater body over the ceiling or its NTC faulty: the gates
+                // stop on the next half-cycle instead of ramping down
+                triac_control_enable(false);
             } else {
-                // Heating off
-                triac_control_set_power(0);
-                thermor_ui_set_heating_state(&g_ui, false);
-                zigbee_thermostat_update_heating_state(&g_zigbee_device, false);
+                triac_control_set_power_at(power_percent, sample.time_us);
             }
+            
+            // Identify the room from what the loop does; retune once it is known
+            if (thermal_model_update(&g_thermal_model, power_percent, current_temp)) {
+                thermal_model_get_params(&g_thermal_model, &room_model);
+                setpoint_ramp_set_model(&g_setpoint_ramp, &room_model, current_temp);
+                if (!g_cascade_enabled && !g_auto_tune_pending &&
+                    thermal_model_retune(&g_thermal_model, &g_pid)) {
+                    if (pid_controller_save_tunings(&g_pid) != ESP_OK) {
+                        ESP_LOGW(TAG, "Failed to save retuned PID gains");
+                    }
+                }
+            }
+            
+            // Update heating state
+            bool heating = (power_percent > 0);
+            thermor_ui_set_heating_state(&g_ui, heating);
+            zigbee_thermostat_update_heating_state(&g_zigbee_device, heating);
+            
+            // Update power consumption
+            uint16_t power_watts = (power_percent * 2000) / 100;  // Assuming 2000W heater
+            zigbee_thermostat_update_power(&g_zigbee_device, power_watts);
+            
+            ESP_LOGD(TAG, "PID: Target=%.1f (ramp %.2f) Current=%.1f Output=%d%%", 
+                     target_temp, setpoint, current_temp, power_percent);
+        } else {
+            // Heating off: cooling down still tells the model about the room
+            pid_controller_set_auto_tune(&g_pid, false);
+            triac_control_set_power_at(0, sample.time_us);
+            setpoint_ramp_track(&g_setpoint_ramp, current_temp);
+            thermal_model_update(&g_thermal_model, 0, current_temp);
+            thermor_ui_set_heating_state(&g_ui, false);
+            zigbee_thermostat_update_heating_state(&g_zigbee_device, false);
         }
         
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // Delivered energy, counted per half-cycle by the firing path
+        energy_meter_update();
+        if ((sample_ms - last_energy_report) >= 60000) {
+            last_energy_report = sample_ms;
+            zigbee_thermostat_update_energy(&g_zigbee_device, energy_meter_get_wh());
+        }
     }
 }
 
@@ -136,6 +244,8 @@ static void control_task(void *pvParameters) {
 static void sensor_task(void *pvParameters) {
     float temp_accumulator = 0;
     int temp_samples = 0;
+    float surface_accumulator = 0;
+    int surface_samples = 0;
     uint32_t last_report_time = 0;
     
     // Configure PIR sensor
@@ -158,23 +268,53 @@ static void sensor_task(void *pvParameters) {
     };
     gpio_config(&window_conf);
     
+    // Woken by each complete set of ADC averages
+    adc_sampler_set_notify(xTaskGetCurrentTaskHandle());
+    
     while (1) {
         uint32_t current_time = esp_timer_get_time() / 1000;
         
         // Read temperature sensor
-        float temp = temperature_sensor_read(&g_temp_sensor);
+        float temp = temperature_sensor_read_filtered(&g_temp_sensor);
         if (temp > -50.0f) {  // Valid reading
             temp_accumulator += temp;
             temp_samples++;
         }
         
+        // Heater body, for the cascade's surface loop
+        if (g_cascade_enabled) {
+            float surface = temperature_sensor_read_filtered(&g_surface_sensor);
+            if (cascade_surface_valid(surface)) {
+                surface_accumulator += surface;
+                surface_samples++;
+            }
+        }
+        
         // Average temperature every second
         if ((current_time - last_report_time) >= 1000 && temp_samples > 0) {
             float avg_temp = temp_accumulator / temp_samples;
+            float avg_surface = surface_samples > 0 ? surface_accumulator / surface_samples : NAN;
+            pid_q16_t avg_temp_q = pid_q16_from_float(avg_temp);  // Converted once, here
+            pid_q16_t avg_surface_q = surface_samples > 0 ? pid_q16_from_float(avg_surface)
+                                                          : CASCADE_SURFACE_NONE;
             temp_accumulator = 0;
             temp_samples = 0;
+            surface_accumulator = 0;
+            surface_samples = 0;
             last_report_time = current_time;
             
+            // Hand the sample to the control step
+            portENTER_CRITICAL(&g_sample_lock);
+            g_sample.temperature = avg_temp;
+            g_sample.surface = avg_surface;
+            g_sample.temperature_q = avg_temp_q;
+            g_sample.surface_q = avg_surface_q;
+            g_sample.time_us = esp_timer_get_time();
+            portEXIT_CRITICAL(&g_sample_lock);
+            if (g_control_task_handle) {
+                xTaskNotifyGive(g_control_task_handle);
+            }
+            
             // Update UI and Zigbee
             thermor_ui_set_temperature(&g_ui, avg_temp);
             zigbee_thermostat_update_temperature(&g_zigbee_device, avg_temp);
@@ -202,7 +342,7 @@ static void sensor_task(void *pvParameters) {
             ESP_LOGI(TAG, "Window: %s", window_open ? "open" : "closed");
         }
         
-        vTaskDelay(pdMS_TO_TICKS(100));
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SENSOR_POLL_MS));
     }
 }
 
@@ -240,22 +380,70 @@ static esp_err_t init_hardware(void) {
     
     // Initialize temperature sensor
     temp_sensor_config_t temp_config = {
-        .adc_channel = ADC1_CHANNEL_0,
+        .adc_channel = ADC_CHANNEL_0,
         .sensor_type = TEMP_SENSOR_NTC_10K,
-        .beta = 3950,
+        .beta = NTC_DEFAULT_BETA,        // Default curve: table in flash
         .r_nominal = 10000,
-        .t_nominal = 25,
+        .t_nominal = NTC_DEFAULT_T_NOMINAL,
         .r_series = 10000
     };
     temperature_sensor_init(&g_temp_sensor, &temp_config);
     
+    // Heater body NTC: when fitted, the room loop drives a surface loop with a hard ceiling
+    temp_sensor_config_t surface_config = {
+        .adc_channel = ADC_CHANNEL_1,
+        .sensor_type = TEMP_SENSOR_NTC_100K,
+        .beta = NTC_DEFAULT_BETA,        // Same curve on a 100K divider
+        .r_nominal = 100000,
+        .t_nominal = NTC_DEFAULT_T_NOMINAL,
+        .r_series = 100000
+    };
+    temperature_sensor_init(&g_surface_sensor, &surface_config);
+    
+    // Spikes on single readings (triac switching, relay clicks) are dropped
+    // before the 1s averages; the surface loop gets the shorter window
+    static const sensor_filter_stage_config_t room_filter[] = {
+        { .type = SENSOR_FILTER_MEDIAN, .window = 5 },
+    };
+    static const sensor_filter_stage_config_t surface_filter[] = {
+        { .type = SENSOR_FILTER_MEDIAN, .window = 3 },
+    };
+    temperature_sensor_set_filter_chain(&g_temp_sensor, room_filter, 1);
+    temperature_sensor_set_filter_chain(&g_surface_sensor, surface_filter, 1);
+    
+    // Both channels sampled by DMA; the first averages are needed just below
+    adc_sampler_config_t sampler_config = {
+        .output_hz = ADC_SAMPLER_OUTPUT_HZ,
+        .average = ADC_SAMPLER_AVERAGE,
+        .notify = NULL,              // sensor_task subscribes once it runs
+    };
+    ret = adc_sampler_start(&sampler_config);
+    if (ret != ESP_OK || adc_sampler_wait_ready(1000) != ESP_OK) {
+        ESP_LOGE(TAG, "ADC sampler not running");
+    }
+    cascade_config_t cascade_config = {
+        .outer = { .kp = 80.0, .ki = 0.2, .kd = 0.0,           // Room error -> surface setpoint
+                   .output_min = 0.0, .output_max = 100.0, .sample_time_ms = 5000 },
+        .inner = { .kp = 8.0, .ki = 0.1, .kd = 0.0,            // Surface error -> power
+                   .output_min = 0.0, .output_max = 100.0, .sample_time_ms = 1000 },
+        .surface_ceiling = 80.0                                 // Heater body limit (C)
+    };
+    cascade_controller_init(&g_cascade, &cascade_config);
+    g_cascade_enabled = cascade_surface_valid(temperature_sensor_read(&g_surface_sensor));
+    ESP_LOGI(TAG, "%s", g_cascade_enabled ? "Cascade control on the heater surface NTC"
+                                          : "No heater surface NTC, single room loop");
+    
     // Initialize triac control
     triac_config_t triac_config = {
         .triac_pins = {TRIAC1_PIN, TRIAC2_PIN, TRIAC3_PIN},
         .num_triacs = 3,
         .zero_cross_pin = ZERO_CROSS_PIN,
         .max_power_watts = 2000,
-        .mains_frequency = 50
+        .zero_cross_offset_us = 0,    // Mains frequency is detected at runtime
+        .backend = TRIAC_BACKEND_ISR, // TRIAC_BACKEND_ETM frees the CPU, one angle for all
+        .ramp_ms = 2000,              // Soft start: 2 s for a full 0-100% swing
+        .ramp_curve = TRIAC_RAMP_S_CURVE,
+        .staging = true               // Whole elements on, one modulated: smoother current
     };
     ret = triac_control_init(&triac_config);
     if (ret != ESP_OK) {
@@ -263,6 +451,9 @@ static esp_err_t init_hardware(void) {
         return ret;
     }
     
+    // Initialize energy accounting (lifetime total restored from NVS)
+    energy_meter_init(triac_config.max_power_watts, triac_config.num_triacs);
+    
     // Initialize PID controller
     pid_config_t pid_config = {
         .kp = 25.0,
@@ -274,6 +465,14 @@ static esp_err_t init_hardware(void) {
     };
     pid_controller_init(&g_pid, &pid_config);
     
+    // Gains tuned for this room, if any; otherwise tune once near the setpoint
+    if (pid_controller_load_tunings(&g_pid) != ESP_OK) {
+        ESP_LOGI(TAG, "No tuned PID gains stored, auto-tune pending");
+        g_auto_tune_pending = true;
+    }
+    thermal_model_init(&g_thermal_model);
+    setpoint_ramp_init(&g_setpoint_ramp, SETPOINT_RAMP_MAX_RATE);
+    
     return ESP_OK;
 }
 
@@ -316,9 +515,59 @@ void app_main(void) {
     ESP_LOGI(TAG, "System initialized successfully");
     
     // Main loop - monitor system health
+    uint32_t last_spurious = 0;
+    triac_duty_report_t duty = {0};
     while (1) {
         // Print heap info every 30 seconds
         ESP_LOGI(TAG, "Free heap: %d bytes", esp_get_free_heap_size());
+        
+        // Mains sync health: a noisy zero-cross input shows up here first
+        triac_diagnostics_t diag;
+        if (triac_control_get_diagnostics(&diag) == ESP_OK) {
+            ESP_LOGI(TAG, "Mains %s %dHz, jitter %" PRIu32 "us, missed %" PRIu32 ", spurious %" PRIu32 ", sync losses %" PRIu32,
+                     diag.mains_locked ? "locked" : "searching", diag.mains_frequency, diag.jitter_us,
+                     diag.missed_crossings, diag.spurious_edges, diag.sync_losses);
+            if (diag.spurious_edges - last_spurious > 100) {
+                ESP_LOGW(TAG, "Zero-cross input is noisy, check the detector wiring");
+            }
+            last_spurious = diag.spurious_edges;
+            ESP_LOGI(TAG, "Sample to firing table: %" PRIu32 "us (worst %" PRIu32 "us)",
+                     diag.sample_latency_us, diag.sample_latency_max_us);
+        }
+        
+        // Element staging: which element carries what, measured over the last period
+        static const char roles[] = { '-', 'F', 'M' };
+        if (triac_control_get_duty_report(&duty) == ESP_OK) {
+            ESP_LOGI(TAG, "Duty: %c%d%% %c%d%% %c%d%%",
+                     roles[duty.role[0]], duty.duty[0], roles[duty.role[1]], duty.duty[1],
+                     roles[duty.role[2]], duty.duty[2]);
+        }
+        
+        // Cascade: what the room loop asks of the heater body
+        if (g_cascade_enabled) {
+            ESP_LOGI(TAG, "Surface setpoint %.1fC, ceiling %.0fC%s, %" PRIu32 " trips",
+                     pid_q16_to_float(g_cascade.surface_setpoint), g_cascade.surface_ceiling,
+                     g_cascade.tripped ? " (tripped)" : "", g_cascade.trips);
+        }
+        
+        // ADC sampling: DMA frames handled, and any the sampler task fell behind on
+        adc_sampler_stats_t adc_stats;
+        adc_sampler_get_stats(&adc_stats);
+        ESP_LOGI(TAG, "ADC: %" PRIu32 " Hz, %" PRIu32 " frames, %" PRIu32 " overflows",
+                 adc_stats.sample_rate_hz, adc_stats.frames, adc_stats.overflows);
+        
+        // Setpoint ramp after a mode change
+        if (setpoint_ramp_is_active(&g_setpoint_ramp)) {
+            ESP_LOGI(TAG, "Setpoint ramp %.2f -> %.1fC at %.3fC/min",
+                     g_setpoint_ramp.effective, g_setpoint_ramp.target, g_setpoint_ramp.rate * 60.0f);
+        }
+        
+        // Identified room model and how far to trust it
+        thermal_model_params_t model;
+        thermal_model_get_params(&g_thermal_model, &model);
+        ESP_LOGI(TAG, "Room model: K=%.3f C/%% tau=%.0fs dead time %.0fs ambient %.1fC, confidence %.2f (%" PRIu32 " samples)",
+                 model.gain, model.tau_s, model.dead_time_s, model.ambient, model.confidence, model.samples);
+        
         vTaskDelay(pdMS_TO_TICKS(30000));
     }
 }
\ No newline at end of file
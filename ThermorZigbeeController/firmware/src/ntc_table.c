@@ -0,0 +1,64 @@
+#include "ntc_table.h"
+#include "esp_log.h"
+#include <math.h>
+#include <stdlib.h>
+
+static const char *TAG = "NtcTable";
+
+// Same computation as scripts/gen_ntc_table.py
+static int16_t temperature_centi(uint32_t mv, float beta, float ratio, float t_nominal) {
+    if (mv == 0) {
+        return NTC_TABLE_MAX_CENTI;
+    }
+    if (mv >= NTC_TABLE_SUPPLY_MV) {
+        return NTC_TABLE_MIN_CENTI;
+    }
+    float r = ratio * (float)mv / (float)(NTC_TABLE_SUPPLY_MV - mv);  // R / R0
+    float inv_t = 1.0f / (t_nominal + 273.15f) + logf(r) / beta;
+    float centi = roundf((1.0f / inv_t - 273.15f) * 100.0f);
+    if (centi < NTC_TABLE_MIN_CENTI) {
+        return NTC_TABLE_MIN_CENTI;
+    }
+    if (centi > NTC_TABLE_MAX_CENTI) {
+        return NTC_TABLE_MAX_CENTI;
+    }
+    return (int16_t)centi;
+}
+
+esp_err_t ntc_table_build(ntc_table_t *table, float beta, float r_nominal,
+                          float t_nominal, float r_series) {
+    if (!table || beta <= 0.0f || r_nominal <= 0.0f || r_series <= 0.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    float ratio = r_series / r_nominal;
+    if (beta == NTC_DEFAULT_BETA && t_nominal == NTC_DEFAULT_T_NOMINAL &&
+        fabsf(ratio - NTC_DEFAULT_SERIES_RATIO) < 1e-6f) {
+        ntc_table_free(table);
+        table->centi = ntc_default_centi;
+        return ESP_OK;
+    }
+
+    if (!table->built) {
+        table->built = malloc(NTC_TABLE_SIZE * sizeof(int16_t));
+        if (!table->built) {
+            return ESP_ERR_NO_MEM;  // The previous curve stays in use
+        }
+    }
+    for (uint32_t i = 0; i < NTC_TABLE_SIZE; i++) {
+        table->built[i] = temperature_centi(i * NTC_TABLE_STEP_MV, beta, ratio, t_nominal);
+    }
+    table->centi = table->built;
+
+    ESP_LOGI(TAG, "Built NTC table: beta %.0f, T0 %.1fC, r_series/R0 %.3f", beta, t_nominal, ratio);
+    return ESP_OK;
+}
+
+void ntc_table_free(ntc_table_t *table) {
+    if (!table) {
+        return;
+    }
+    free(table->built);
+    table->built = NULL;
+    table->centi = NULL;
+}
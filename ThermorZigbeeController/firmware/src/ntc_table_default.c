@@ -0,0 +1,42 @@
+// Generated by scripts/gen_ntc_table.py - do not edit.
+// beta 3950, T0 25C, r_series/R0 1, 3300mV supply
+
+#include "ntc_table.h"
+
+// Temperature (centi-degrees) at i * NTC_TABLE_STEP_MV
+const int16_t ntc_default_centi[NTC_TABLE_SIZE] = {
+     25000,  25000,  21160,  18846,  17329,  16216,  15344,  14632,  14032,  13515,
+     13063,  12660,  12299,  11971,  11672,  11396,  11141,  10903,  10681,  10473,
+     10277,  10092,   9916,   9750,   9591,   9440,   9295,   9156,   9023,   8895,
+      8772,   8653,   8539,   8428,   8321,   8217,   8116,   8019,   7924,   7832,
+      7742,   7655,   7570,   7487,   7406,   7326,   7249,   7174,   7100,   7027,
+      6957,   6887,   6819,   6752,   6687,   6623,   6560,   6498,   6437,   6377,
+      6318,   6261,   6204,   6148,   6092,   6038,   5984,   5932,   5880,   5828,
+      5778,   5728,   5678,   5630,   5582,   5534,   5488,   5441,   5395,   5350,
+      5306,   5261,   5218,   5174,   5132,   5089,   5047,   5006,   4965,   4924,
+      4884,   4844,   4804,   4765,   4726,   4688,   4650,   4612,   4574,   4537,
+      4500,   4464,   4427,   4391,   4355,   4320,   4285,   4250,   4215,   4180,
+      4146,   4112,   4078,   4045,   4011,   3978,   3945,   3912,   3880,   3847,
+      3815,   3783,   3751,   3719,   3688,   3656,   3625,   3594,   3563,   3533,
+      3502,   3472,   3441,   3411,   3381,   3351,   3321,   3292,   3262,   3233,
+      3203,   3174,   3145,   3116,   3087,   3059,   3030,   3001,   2973,   2944,
+      2916,   2888,   2860,   2832,   2804,   2776,   2748,   2720,   2692,   2665,
+      2637,   2610,   2582,   2555,   2527,   2500,   2473,   2446,   2418,   2391,
+      2364,   2337,   2310,   2283,   2256,   2229,   2202,   2176,   2149,   2122,
+      2095,   2069,   2042,   2015,   1988,   1962,   1935,   1908,   1882,   1855,
+      1828,   1802,   1775,   1748,   1721,   1695,   1668,   1641,   1615,   1588,
+      1561,   1534,   1507,   1481,   1454,   1427,   1400,   1373,   1346,   1319,
+      1292,   1264,   1237,   1210,   1183,   1155,   1128,   1100,   1073,   1045,
+      1018,    990,    962,    934,    906,    878,    850,    822,    793,    765,
+       736,    708,    679,    650,    621,    592,    563,    534,    504,    475,
+       445,    415,    385,    355,    324,    294,    263,    232,    201,    170,
+       139,    107,     75,     43,     11,    -21,    -54,    -87,   -120,   -153,
+      -187,   -221,   -255,   -290,   -324,   -359,   -395,   -430,   -467,   -503,
+      -540,   -577,   -614,   -652,   -691,   -730,   -769,   -809,   -849,   -890,
+      -931,   -973,  -1015,  -1058,  -1102,  -1146,  -1191,  -1237,  -1283,  -1330,
+     -1378,  -1427,  -1477,  -1528,  -1579,  -1632,  -1686,  -1741,  -1798,  -1855,
+     -1915,  -1975,  -2038,  -2102,  -2167,  -2235,  -2305,  -2378,  -2453,  -2530,
+     -2611,  -2695,  -2782,  -2874,  -2970,  -3071,  -3178,  -3292,  -3413,  -3542,
+     -3682,  -3835,  -4002,  -4189,  -4400,  -4643,  -4934,  -5000,  -5000,  -5000,
+     -5000,
+};
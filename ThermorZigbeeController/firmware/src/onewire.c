@@ -0,0 +1,72 @@
+#include "onewire.h"
+#include <string.h>
+
+// x^8 + x^5 + x^4 + 1, LSB first; a ROM or scratchpad followed by its CRC
+// sums to zero
+uint8_t onewire_crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0;
+
+    while (len--) {
+        uint8_t byte = *data++;
+        for (int i = 0; i < 8; i++) {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix) {
+                crc ^= 0x8C;
+            }
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+void onewire_search_init(onewire_search_t *search) {
+    memset(search, 0, sizeof(*search));
+}
+
+bool onewire_search_pending(const onewire_search_t *search) {
+    return !search->last_device;
+}
+
+// Maxim AN187: at each bit where devices disagree, take the branch the
+// previous pass left at 0 one step further, so every pass ends on a new ROM
+bool onewire_search_step(onewire_search_t *search, int bit, bool id_bit, bool cmp_bit,
+                         bool *direction) {
+    uint8_t *byte = &search->rom.bytes[bit / 8];
+    uint8_t mask = 1 << (bit % 8);
+    int position = bit + 1;
+
+    if (bit == 0) {
+        search->last_zero = 0;
+    }
+    if (id_bit && cmp_bit) {
+        return false;  // Nobody on the bus (or it dropped out)
+    }
+
+    if (id_bit != cmp_bit) {
+        *direction = id_bit;
+    } else if (position < search->last_discrepancy) {
+        *direction = (*byte & mask) != 0;
+    } else {
+        *direction = (position == search->last_discrepancy);
+    }
+    if (id_bit == cmp_bit && !*direction) {
+        search->last_zero = position;
+    }
+
+    if (*direction) {
+        *byte |= mask;
+    } else {
+        *byte &= ~mask;
+    }
+    return true;
+}
+
+bool onewire_search_finish(onewire_search_t *search) {
+    search->last_discrepancy = search->last_zero;
+    if (search->last_discrepancy == 0) {
+        search->last_device = true;
+    }
+    return search->rom.bytes[0] != 0 &&
+           onewire_crc8(search->rom.bytes, ONEWIRE_ROM_LEN) == 0;
+}
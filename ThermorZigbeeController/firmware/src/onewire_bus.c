@@ -0,0 +1,280 @@
+#include "onewire_bus.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "soc/soc_caps.h"
+#include <string.h>
+
+static const char *TAG = "OneWire";
+
+// Slot waveforms, low first and released high to the end of the slot
+static const rmt_symbol_word_t SLOT_1 = {
+    .level0 = 0, .duration0 = ONEWIRE_WRITE1_LOW_US,
+    .level1 = 1, .duration1 = ONEWIRE_SLOT_US - ONEWIRE_WRITE1_LOW_US,
+};
+static const rmt_symbol_word_t SLOT_0 = {
+    .level0 = 0, .duration0 = ONEWIRE_WRITE0_LOW_US,
+    .level1 = 1, .duration1 = ONEWIRE_SLOT_US - ONEWIRE_WRITE0_LOW_US,
+};
+static const rmt_symbol_word_t RESET_PULSE = {
+    .level0 = 0, .duration0 = ONEWIRE_RESET_LOW_US,
+    .level1 = 1, .duration1 = ONEWIRE_RESET_RELEASE_US,
+};
+
+// Release the line once a transfer is out
+static const rmt_transmit_config_t tx_config = {
+    .loop_count = 0,
+    .flags.eot_level = 1,
+};
+
+// A receive ends once the line has been idle longer than the whole reset,
+// the longest steady level of our own waveforms
+static const rmt_receive_config_t rx_config = {
+    .signal_range_min_ns = 1000,
+    .signal_range_max_ns = (ONEWIRE_RESET_LOW_US + ONEWIRE_RESET_RELEASE_US) * 1000,
+};
+
+static bool IRAM_ATTR rx_done_cb(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t *edata,
+                                 void *user_ctx) {
+    BaseType_t woken = pdFALSE;
+    xQueueSendFromISR((QueueHandle_t)user_ctx, edata, &woken);
+    return woken == pdTRUE;
+}
+
+// Send count symbols from bus->tx_symbols; with rx set, record the line
+// meanwhile and return the number of symbols seen
+static esp_err_t transfer(onewire_bus_t *bus, size_t count, size_t *rx) {
+    rmt_rx_done_event_data_t done;
+    esp_err_t ret;
+
+    if (rx) {
+        xQueueReset(bus->rx_done);
+        ret = rmt_receive(bus->rx, bus->rx_symbols, sizeof(bus->rx_symbols), &rx_config);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    ret = rmt_transmit(bus->tx, bus->encoder, bus->tx_symbols, count * sizeof(rmt_symbol_word_t),
+                       &tx_config);
+    if (ret == ESP_OK) {
+        ret = rmt_tx_wait_all_done(bus->tx, ONEWIRE_TIMEOUT_MS);
+    }
+    if (rx && ret == ESP_OK) {
+        if (xQueueReceive(bus->rx_done, &done, pdMS_TO_TICKS(ONEWIRE_TIMEOUT_MS)) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+        *rx = done.num_symbols;
+    }
+    return ret;
+}
+
+// Read slots, decoded from how long the line stayed low in each
+static esp_err_t read_bits(onewire_bus_t *bus, uint8_t *bits, size_t count) {
+    size_t seen = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        bus->tx_symbols[i] = SLOT_1;
+    }
+    esp_err_t ret = transfer(bus, count, &seen);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (seen < count) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    for (size_t i = 0; i < count; i++) {
+        bits[i] = bus->rx_symbols[i].duration0 <= ONEWIRE_READ_THRESHOLD_US;
+    }
+    return ESP_OK;
+}
+
+esp_err_t onewire_bus_init(onewire_bus_t *bus, gpio_num_t pin) {
+    if (!bus) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(bus, 0, sizeof(*bus));
+    bus->pin = pin;
+
+    // RX first: the TX channel loops its output back onto the same pin
+    rmt_rx_channel_config_t rx_channel = {
+        .gpio_num = pin,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = ONEWIRE_RESOLUTION_HZ,
+        .mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL,
+    };
+    rmt_tx_channel_config_t tx_channel = {
+        .gpio_num = pin,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = ONEWIRE_RESOLUTION_HZ,
+        .mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL,
+        .trans_queue_depth = 4,
+        .flags.io_loop_back = true,
+        .flags.io_od_mode = true,
+    };
+    rmt_copy_encoder_config_t encoder_config = {};
+    rmt_rx_event_callbacks_t callbacks = {
+        .on_recv_done = rx_done_cb,
+    };
+
+    bus->rx_done = xQueueCreate(1, sizeof(rmt_rx_done_event_data_t));
+    if (!bus->rx_done) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t ret = rmt_new_rx_channel(&rx_channel, &bus->rx);
+    if (ret == ESP_OK) {
+        ret = rmt_new_tx_channel(&tx_channel, &bus->tx);
+    }
+    if (ret == ESP_OK) {
+        ret = rmt_new_copy_encoder(&encoder_config, &bus->encoder);
+    }
+    if (ret == ESP_OK) {
+        ret = rmt_rx_register_event_callbacks(bus->rx, &callbacks, bus->rx_done);
+    }
+    if (ret == ESP_OK) {
+        ret = rmt_enable(bus->rx);
+    }
+    if (ret == ESP_OK) {
+        ret = rmt_enable(bus->tx);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "RMT setup on GPIO%d failed: %s", pin, esp_err_to_name(ret));
+        onewire_bus_deinit(bus);
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "1-Wire bus on GPIO%d (RMT)", pin);
+    return ESP_OK;
+}
+
+esp_err_t onewire_bus_deinit(onewire_bus_t *bus) {
+    if (!bus) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (bus->tx) {
+        rmt_disable(bus->tx);
+        rmt_del_channel(bus->tx);
+        bus->tx = NULL;
+    }
+    if (bus->rx) {
+        rmt_disable(bus->rx);
+        rmt_del_channel(bus->rx);
+        bus->rx = NULL;
+    }
+    if (bus->encoder) {
+        rmt_del_encoder(bus->encoder);
+        bus->encoder = NULL;
+    }
+    if (bus->rx_done) {
+        vQueueDelete(bus->rx_done);
+        bus->rx_done = NULL;
+    }
+    return ESP_OK;
+}
+
+// Our own pulse comes back first; a device answers with a second low
+esp_err_t onewire_bus_reset(onewire_bus_t *bus) {
+    size_t seen = 0;
+
+    bus->tx_symbols[0] = RESET_PULSE;
+    esp_err_t ret = transfer(bus, 1, &seen);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (seen >= 2 && bus->rx_symbols[0].level0 == 0 &&
+        bus->rx_symbols[0].duration0 >= ONEWIRE_RESET_LOW_US - 10 &&
+        bus->rx_symbols[1].level0 == 0 &&
+        bus->rx_symbols[1].duration0 >= ONEWIRE_PRESENCE_MIN_US) {
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t onewire_bus_write(onewire_bus_t *bus, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        size_t chunk = len > ONEWIRE_MAX_WRITE ? ONEWIRE_MAX_WRITE : len;
+        for (size_t i = 0; i < chunk * 8; i++) {
+            bus->tx_symbols[i] = (data[i / 8] >> (i % 8)) & 1 ? SLOT_1 : SLOT_0;
+        }
+        esp_err_t ret = transfer(bus, chunk * 8, NULL);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        data += chunk;
+        len -= chunk;
+    }
+    return ESP_OK;
+}
+
+// A byte per receive: the RX block holds no more without DMA
+esp_err_t onewire_bus_read(onewire_bus_t *bus, uint8_t *data, size_t len) {
+    uint8_t bits[8];
+
+    for (size_t n = 0; n < len; n++) {
+        esp_err_t ret = read_bits(bus, bits, 8);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        data[n] = 0;
+        for (int i = 0; i < 8; i++) {
+            data[n] |= bits[i] << i;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t onewire_bus_select(onewire_bus_t *bus, const onewire_rom_t *rom) {
+    uint8_t command[1 + ONEWIRE_ROM_LEN];
+    size_t len = 1;
+
+    esp_err_t ret = onewire_bus_reset(bus);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (rom) {
+        command[0] = ONEWIRE_CMD_MATCH_ROM;
+        memcpy(&command[1], rom->bytes, ONEWIRE_ROM_LEN);
+        len += ONEWIRE_ROM_LEN;
+    } else {
+        command[0] = ONEWIRE_CMD_SKIP_ROM;
+    }
+    return onewire_bus_write(bus, command, len);
+}
+
+esp_err_t onewire_bus_search(onewire_bus_t *bus, onewire_rom_t *roms, size_t max, size_t *found) {
+    onewire_search_t search;
+    const uint8_t command = ONEWIRE_CMD_SEARCH_ROM;
+    esp_err_t ret = ESP_OK;
+
+    *found = 0;
+    onewire_search_init(&search);
+    while (*found < max && onewire_search_pending(&search)) {
+        ret = onewire_bus_reset(bus);
+        if (ret == ESP_OK) {
+            ret = onewire_bus_write(bus, &command, 1);
+        }
+
+        // Each bit: the devices send it and its complement, we send the branch
+        for (int bit = 0; ret == ESP_OK && bit < ONEWIRE_ROM_BITS; bit++) {
+            uint8_t answer[2];
+            bool direction;
+            ret = read_bits(bus, answer, 2);
+            if (ret != ESP_OK) {
+                break;
+            }
+            if (!onewire_search_step(&search, bit, answer[0], answer[1], &direction)) {
+                ret = ESP_ERR_NOT_FOUND;
+                break;
+            }
+            bus->tx_symbols[0] = direction ? SLOT_1 : SLOT_0;
+            ret = transfer(bus, 1, NULL);
+        }
+        if (ret != ESP_OK) {
+            break;
+        }
+        if (!onewire_search_finish(&search)) {
+            ret = ESP_ERR_INVALID_CRC;
+            break;
+        }
+        roms[(*found)++] = search.rom;
+    }
+    return ret;
+}
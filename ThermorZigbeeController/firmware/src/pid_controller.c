@@ -1,82 +1,216 @@
 #include "pid_controller.h"
-#include "esp_timer.h"
+#include "esp_log.h"
+#include "nvs.h"
 #include <math.h>
 
+static const char *TAG = "PID";
+
+#define NVS_NAMESPACE   "pid"
+#define NVS_KEY_TUNINGS "tunings"
+
+// Persisted gains
+typedef struct {
+    float kp;
+    float ki;
+    float kd;
+} pid_tunings_t;
+
+// Saturate to the Q16.16 range
+static inline pid_q16_t sat_q16(int64_t x) {
+    if (x > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (x < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (pid_q16_t)x;
+}
+
+static inline pid_q16_t mul_q16(pid_q16_t a, pid_q16_t b) {
+    return sat_q16(((int64_t)a * b) >> 16);
+}
+
+// Rebuild the fixed-point coefficients from the float config
+static void update_coefficients(pid_controller_t *pid) {
+    float dt = pid->config.sample_time_ms / 1000.0f;
+    float inv_dt = 1000.0f / pid->config.sample_time_ms;
+    float ki_dt = pid->config.ki * dt * (float)(1 << PID_Q24_SHIFT);
+    
+    pid->kp_q = pid_q16_from_float(pid->config.kp);
+    pid->ki_dt_q24 = (ki_dt >= 2147483647.0f) ? INT32_MAX : (int32_t)(ki_dt + 0.5f);
+    pid->kd_dt_q = pid_q16_from_float(pid->config.kd * inv_dt);
+    pid->out_min_q = pid_q16_from_float(pid->config.output_min);
+    pid->out_max_q = pid_q16_from_float(pid->config.output_max);
+}
+
+// Keep the integral term inside +/- output_max
+static void clamp_integral(pid_controller_t *pid) {
+    int64_t limit = (int64_t)pid->out_max_q * ((int64_t)1 << PID_Q24_SHIFT);
+    if (pid->integral > limit) {
+        pid->integral = limit;
+    } else if (pid->integral < -limit) {
+        pid->integral = -limit;
+    }
+}
+
+// Auto-tune time base (ms)
+static inline uint32_t sample_time_now(const pid_controller_t *pid) {
+    return pid->samples * pid->config.sample_time_ms;
+}
+
 void pid_controller_init(pid_controller_t *pid, const pid_config_t *config) {
     pid->config = *config;
-    pid->integral = 0.0f;
-    pid->last_error = 0.0f;
-    pid->last_input = 0.0f;
-    pid->last_time = 0;
+    if (pid->config.sample_time_ms == 0) {
+        pid->config.sample_time_ms = 1000;
+    }
+    update_coefficients(pid);
+    pid->integral = 0;
+    pid->last_error = 0;
+    pid->last_input = 0;
+    pid->last_output = 0;
+    pid->feedforward = 0;
+    pid->samples = 0;
     pid->first_run = true;
+    pid->tune.state = PID_TUNE_IDLE;
 }
 
-float pid_controller_compute(pid_controller_t *pid, float setpoint, float input) {
-    uint32_t now = esp_timer_get_time() / 1000;  // Convert to ms
+// Gains from the measured limit cycle: Tyreus-Luyben PI rules, which
+// overshoot less than Ziegler-Nichols on lag-dominant thermal loads. The
+// derivative is left off: unfiltered on a noisy 1 s sensor it only adds
+// output chatter at these periods.
+static void autotune_finish(pid_controller_t *pid) {
+    pid_autotune_t *t = &pid->tune;
+    float amplitude = t->amplitude_sum / PID_TUNE_CYCLES;
     
-    // Skip if not enough time has passed
-    if (!pid->first_run && (now - pid->last_time) < pid->config.sample_time_ms) {
-        return 0.0f;
+    // The hysteresis band delays each switch; correct the describing function for it
+    if (amplitude > PID_TUNE_HYSTERESIS) {
+        amplitude = sqrtf(amplitude * amplitude - PID_TUNE_HYSTERESIS * PID_TUNE_HYSTERESIS);
     }
+    t->ku = 4.0f * PID_TUNE_RELAY_STEP / ((float)M_PI * amplitude);
+    t->tu = t->period_sum / PID_TUNE_CYCLES;
     
-    float dt = pid->first_run ? (pid->config.sample_time_ms / 1000.0f) : 
-               ((now - pid->last_time) / 1000.0f);
-    
-    // Calculate error
-    float error = setpoint - input;
+    float kp = t->ku / 3.2f;
+    float ti = 2.2f * t->tu;
+    pid_controller_set_tunings(pid, kp, kp / ti, 0.0f);
     
-    // Proportional term
-    float p_term = pid->config.kp * error;
+    // Bumpless: the integral carries the output the relay was centred on
+    pid->integral = (int64_t)pid_q16_from_float(t->bias) * ((int64_t)1 << PID_Q24_SHIFT);
+    t->state = PID_TUNE_DONE;
     
-    // Integral term with anti-windup
-    pid->integral += error * dt;
+    ESP_LOGI(TAG, "Auto-tune done: Ku=%.2f Tu=%.0fs -> kp=%.2f ki=%.4f kd=%.1f",
+             t->ku, t->tu, pid->config.kp, pid->config.ki, pid->config.kd);
+}
+
+// One relay step: heat below the band, back off above it. A cycle runs
+// from one switch to the high level to the next.
+static float autotune_step(pid_controller_t *pid, float setpoint, float input, uint32_t now) {
+    pid_autotune_t *t = &pid->tune;
     
-    // Limit integral to prevent windup
-    float integral_limit = pid->config.output_max / pid->config.ki;
-    if (pid->integral > integral_limit) {
-        pid->integral = integral_limit;
-    } else if (pid->integral < -integral_limit) {
-        pid->integral = -integral_limit;
+    if (now - t->start_time > PID_TUNE_TIMEOUT_MS) {
+        pid_controller_set_tunings(pid, t->saved_kp, t->saved_ki, t->saved_kd);
+        t->state = PID_TUNE_FAILED;
+        ESP_LOGW(TAG, "Auto-tune timed out after %d cycles, gains unchanged", t->cycles);
+        return t->bias;
     }
     
-    float i_term = pid->config.ki * pid->integral;
+    if (input > t->peak_max) {
+        t->peak_max = input;
+    }
+    if (input < t->peak_min) {
+        t->peak_min = input;
+    }
     
-    // Derivative term (on measurement to avoid derivative kick)
-    float d_input = pid->first_run ? 0.0f : (input - pid->last_input) / dt;
-    float d_term = -pid->config.kd * d_input;
+    if (t->relay_high && input > setpoint + PID_TUNE_HYSTERESIS) {
+        t->relay_high = false;
+    } else if (!t->relay_high && input < setpoint - PID_TUNE_HYSTERESIS) {
+        t->relay_high = true;
+        if (t->cycle_started) {
+            // The first cycle still carries the start-up transient
+            if (t->cycles > 0) {
+                t->period_sum += (now - t->cycle_time) / 1000.0f;
+                t->amplitude_sum += (t->peak_max - t->peak_min) / 2.0f;
+            }
+            t->cycles++;
+        }
+        t->cycle_started = true;
+        t->cycle_time = now;
+        t->peak_max = input;
+        t->peak_min = input;
+        
+        if (t->cycles > PID_TUNE_CYCLES) {
+            autotune_finish(pid);
+            return t->bias;
+        }
+    }
     
-    // Calculate total output
-    float output = p_term + i_term + d_term;
+    return t->relay_high ? t->bias + PID_TUNE_RELAY_STEP : t->bias - PID_TUNE_RELAY_STEP;
+}
+
+pid_q16_t pid_controller_compute_q16(pid_controller_t *pid, pid_q16_t setpoint, pid_q16_t input) {
+    pid_q16_t error = sat_q16((int64_t)setpoint - input);
+    pid_q16_t output;
     
-    // Apply output limits
-    if (output > pid->config.output_max) {
-        output = pid->config.output_max;
-        // Back-calculate integral for anti-windup
-        if (pid->config.ki != 0) {
-            pid->integral = (output - p_term - d_term) / pid->config.ki;
+    // Relay auto-tune drives the output until the limit cycle is measured
+    if (pid->tune.state == PID_TUNE_RUNNING) {
+        float relay = autotune_step(pid, pid_q16_to_float(setpoint), pid_q16_to_float(input),
+                                    sample_time_now(pid));
+        output = pid_q16_from_float(relay);
+    } else {
+        // Proportional term
+        pid_q16_t p_term = mul_q16(pid->kp_q, error);
+        
+        // Integral term, accumulated in output units and limited to prevent windup
+        pid->integral += (int64_t)error * pid->ki_dt_q24;
+        clamp_integral(pid);
+        pid_q16_t i_term = (pid_q16_t)(pid->integral >> PID_Q24_SHIFT);
+        
+        // Derivative term (on measurement to avoid derivative kick)
+        pid_q16_t d_term = 0;
+        if (!pid->first_run) {
+            d_term = sat_q16(-(int64_t)mul_q16(pid->kd_dt_q, sat_q16((int64_t)input - pid->last_input)));
         }
-    } else if (output < pid->config.output_min) {
-        output = pid->config.output_min;
-        // Back-calculate integral for anti-windup
-        if (pid->config.ki != 0) {
-            pid->integral = (output - p_term - d_term) / pid->config.ki;
+        
+        // Calculate total output and apply output limits, back-calculating
+        // the integral for anti-windup
+        int64_t sum = (int64_t)p_term + i_term + d_term + pid->feedforward;
+        if (sum > pid->out_max_q || sum < pid->out_min_q) {
+            output = (sum > pid->out_max_q) ? pid->out_max_q : pid->out_min_q;
+            if (pid->ki_dt_q24 != 0) {
+                // Multiplied, not shifted: the difference may be negative
+                pid->integral = ((int64_t)output - p_term - d_term - pid->feedforward) *
+                                ((int64_t)1 << PID_Q24_SHIFT);
+            }
+        } else {
+            output = (pid_q16_t)sum;
         }
     }
     
     // Update state
     pid->last_error = error;
     pid->last_input = input;
-    pid->last_time = now;
+    pid->last_output = output;
+    pid->samples++;
     pid->first_run = false;
     
     return output;
 }
 
+float pid_controller_compute(pid_controller_t *pid, float setpoint, float input) {
+    pid_q16_t output = pid_controller_compute_q16(pid, pid_q16_from_float(setpoint),
+                                                  pid_q16_from_float(input));
+    return pid_q16_to_float(output);
+}
+
 void pid_controller_reset(pid_controller_t *pid) {
-    pid->integral = 0.0f;
-    pid->last_error = 0.0f;
-    pid->last_input = 0.0f;
+    pid->integral = 0;
+    pid->last_error = 0;
+    pid->last_input = 0;
     pid->first_run = true;
+    pid->last_output = 0;
+    pid->feedforward = 0;
+    
+    // A reset breaks the limit cycle: abort a running tune
+    pid_controller_set_auto_tune(pid, false);
 }
 
 void pid_controller_set_tunings(pid_controller_t *pid, float kp, float ki, float kd) {
@@ -85,6 +219,7 @@ void pid_controller_set_tunings(pid_controller_t *pid, float kp, float ki, float
     pid->config.kp = kp;
     pid->config.ki = ki;
     pid->config.kd = kd;
+    update_coefficients(pid);
 }
 
 void pid_controller_set_output_limits(pid_controller_t *pid, float min, float max) {
@@ -92,24 +227,114 @@ void pid_controller_set_output_limits(pid_controller_t *pid, float min, float ma
     
     pid->config.output_min = min;
     pid->config.output_max = max;
+    update_coefficients(pid);
     
     // Apply limits to integral
-    float integral_limit = max / pid->config.ki;
-    if (pid->integral > integral_limit) {
-        pid->integral = integral_limit;
-    } else if (pid->integral < -integral_limit) {
-        pid->integral = -integral_limit;
-    }
+    clamp_integral(pid);
 }
 
 void pid_controller_set_sample_time(pid_controller_t *pid, uint32_t sample_time_ms) {
     if (sample_time_ms > 0) {
         pid->config.sample_time_ms = sample_time_ms;
+        update_coefficients(pid);
     }
 }
 
+void pid_controller_set_feedforward(pid_controller_t *pid, float feedforward) {
+    pid->feedforward = pid_q16_from_float(feedforward);
+}
+
 void pid_controller_get_tunings(pid_controller_t *pid, float *kp, float *ki, float *kd) {
     if (kp) *kp = pid->config.kp;
     if (ki) *ki = pid->config.ki;
     if (kd) *kd = pid->config.kd;
-}
\ No newline at end of file
+}
+
+void pid_controller_set_auto_tune(pid_controller_t *pid, bool enable) {
+    pid_autotune_t *t = &pid->tune;
+    
+    if (!enable) {
+        if (t->state == PID_TUNE_RUNNING) {
+            pid_controller_set_tunings(pid, t->saved_kp, t->saved_ki, t->saved_kd);
+            ESP_LOGI(TAG, "Auto-tune aborted");
+        }
+        t->state = PID_TUNE_IDLE;
+        return;
+    }
+    if (t->state == PID_TUNE_RUNNING) {
+        return;
+    }
+    
+    // Swing around the present output, kept far enough from the limits
+    // for a symmetric relay
+    float bias = pid_q16_to_float(pid->last_output);
+    if (bias > pid->config.output_max - PID_TUNE_RELAY_STEP) {
+        bias = pid->config.output_max - PID_TUNE_RELAY_STEP;
+    }
+    if (bias < pid->config.output_min + PID_TUNE_RELAY_STEP) {
+        bias = pid->config.output_min + PID_TUNE_RELAY_STEP;
+    }
+    
+    *t = (pid_autotune_t) {
+        .state = PID_TUNE_RUNNING,
+        .bias = bias,
+        .saved_kp = pid->config.kp,
+        .saved_ki = pid->config.ki,
+        .saved_kd = pid->config.kd,
+        .relay_high = true,
+        .start_time = sample_time_now(pid),
+        .peak_max = -INFINITY,
+        .peak_min = INFINITY,
+    };
+    
+    ESP_LOGI(TAG, "Auto-tune started: relay %.0f +/- %.0f", bias, PID_TUNE_RELAY_STEP);
+}
+
+pid_tune_state_t pid_controller_get_auto_tune_state(const pid_controller_t *pid) {
+    return pid->tune.state;
+}
+
+esp_err_t pid_controller_save_tunings(const pid_controller_t *pid) {
+    pid_tunings_t tunings = {
+        .kp = pid->config.kp,
+        .ki = pid->config.ki,
+        .kd = pid->config.kd,
+    };
+    
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ret = nvs_set_blob(handle, NVS_KEY_TUNINGS, &tunings, sizeof(tunings));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return ret;
+}
+
+esp_err_t pid_controller_load_tunings(pid_controller_t *pid) {
+    pid_tunings_t tunings;
+    size_t size = sizeof(tunings);
+    
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ret = nvs_get_blob(handle, NVS_KEY_TUNINGS, &tunings, &size);
+    nvs_close(handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (size != sizeof(tunings)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    pid_controller_set_tunings(pid, tunings.kp, tunings.ki, tunings.kd);
+    ESP_LOGI(TAG, "Loaded tunings: kp=%.2f ki=%.4f kd=%.1f", tunings.kp, tunings.ki, tunings.kd);
+    return ESP_OK;
+}
@@ -0,0 +1,60 @@
+#include "pt1000.h"
+#include <math.h>
+
+// R(T) in milliohms from -50C to 150C, every 10C (IEC 60751 coefficients)
+const uint32_t pt1000_table_mohm[PT1000_TABLE_SIZE] = {
+     803063,  842707,  882217,  921599,  960859, 1000000, 1039025,
+    1077935, 1116729, 1155408, 1193971, 1232419, 1270751, 1308968,
+    1347069, 1385055, 1422925, 1460680, 1498319, 1535843, 1573251,
+};
+
+// Linear between two table points, or along an end segment outside them
+static float interpolate(int i, float ohms) {
+    float r0 = pt1000_table_mohm[i] / 1000.0f;
+    float r1 = pt1000_table_mohm[i + 1] / 1000.0f;
+    return PT1000_TABLE_MIN_C + PT1000_TABLE_STEP_C * (i + (ohms - r0) / (r1 - r0));
+}
+
+float pt1000_resistance_to_temperature(float ohms) {
+    if (!(ohms > 0.0f) || isinf(ohms)) {
+        return -273.15f;  // Open or shorted sensor
+    }
+    if (ohms * 1000.0f < pt1000_table_mohm[0]) {
+        return interpolate(0, ohms);
+    }
+    if (ohms * 1000.0f >= pt1000_table_mohm[PT1000_TABLE_SIZE - 1]) {
+        return interpolate(PT1000_TABLE_SIZE - 2, ohms);
+    }
+
+    // Nearly linear: guess the segment from the mean slope, then settle it
+    uint32_t mohm = (uint32_t)(ohms * 1000.0f + 0.5f);
+    uint32_t span = pt1000_table_mohm[PT1000_TABLE_SIZE - 1] - pt1000_table_mohm[0];
+    int i = (int)((uint64_t)(mohm - pt1000_table_mohm[0]) * (PT1000_TABLE_SIZE - 1) / span);
+    if (i > PT1000_TABLE_SIZE - 2) {
+        i = PT1000_TABLE_SIZE - 2;
+    }
+    while (i > 0 && mohm < pt1000_table_mohm[i]) {
+        i--;
+    }
+    while (i < PT1000_TABLE_SIZE - 2 && mohm >= pt1000_table_mohm[i + 1]) {
+        i++;
+    }
+
+    // Millidegrees in integers, then one conversion out
+    uint32_t r0 = pt1000_table_mohm[i];
+    uint32_t r1 = pt1000_table_mohm[i + 1];
+    int32_t milli = (PT1000_TABLE_MIN_C + PT1000_TABLE_STEP_C * i) * 1000 +
+                    (int32_t)(((uint64_t)(mohm - r0) * PT1000_TABLE_STEP_C * 1000 + (r1 - r0) / 2) / (r1 - r0));
+    return milli / 1000.0f;
+}
+
+float pt1000_temperature(float measured_ohms, float lead_ohms) {
+    return pt1000_resistance_to_temperature(measured_ohms - lead_ohms);
+}
+
+float pt1000_lead_resistance(float length_m, float area_mm2) {
+    if (area_mm2 <= 0.0f) {
+        return 0.0f;
+    }
+    return 2.0f * length_m * PT1000_COPPER_OHM_MM2_PER_M / area_mm2;
+}
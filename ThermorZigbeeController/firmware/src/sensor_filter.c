@@ -0,0 +1,142 @@
+#include "sensor_filter.h"
+#include <string.h>
+
+static bool stage_config_valid(const sensor_filter_stage_config_t *config) {
+    switch (config->type) {
+        case SENSOR_FILTER_MOVING_AVERAGE:
+            return config->window >= 1 && config->window <= SENSOR_FILTER_MAX_WINDOW;
+        case SENSOR_FILTER_MEDIAN:
+            return config->window >= 1 && config->window <= SENSOR_FILTER_MAX_MEDIAN &&
+                   (config->window & 1);
+        case SENSOR_FILTER_EXPONENTIAL:
+            return config->alpha > 0.0f && config->alpha <= 1.0f;
+        case SENSOR_FILTER_RATE_LIMIT:
+            return config->max_rate > 0.0f;
+        default:
+            return false;
+    }
+}
+
+esp_err_t sensor_filter_init(sensor_filter_t *filter, const sensor_filter_stage_config_t *stages,
+                             uint8_t count) {
+    if (!filter || count > SENSOR_FILTER_MAX_STAGES || (count > 0 && !stages)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (!stage_config_valid(&stages[i])) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    memset(filter, 0, sizeof(*filter));
+    for (uint8_t i = 0; i < count; i++) {
+        filter->stages[i].config = stages[i];
+    }
+    filter->count = count;
+    return ESP_OK;
+}
+
+void sensor_filter_reset(sensor_filter_t *filter) {
+    for (uint8_t i = 0; i < filter->count; i++) {
+        memset(&filter->stages[i].state, 0, sizeof(filter->stages[i].state));
+    }
+}
+
+// Running sum: one sample in, the oldest out
+static float apply_moving_average(sensor_filter_stage_t *stage, float value) {
+    sensor_filter_average_t *s = &stage->state.average;
+    int32_t milli = (int32_t)(value * 1000.0f + (value >= 0.0f ? 0.5f : -0.5f));
+
+    if (s->count == stage->config.window) {
+        s->sum -= s->samples[s->index];
+    } else {
+        s->count++;
+    }
+    s->samples[s->index] = milli;
+    s->sum += milli;
+    s->index = (s->index + 1) % stage->config.window;
+
+    return (float)(s->sum / s->count) / 1000.0f;
+}
+
+// Sorted copy of the window: the oldest value is taken out and the new
+// one inserted in place, the median read from the middle
+static float apply_median(sensor_filter_stage_t *stage, float value) {
+    sensor_filter_median_t *s = &stage->state.median;
+    uint8_t n = s->count;
+
+    if (n == stage->config.window) {
+        float oldest = s->history[s->index];
+        uint8_t i = 0;
+        while (i < n - 1 && s->sorted[i] != oldest) {
+            i++;
+        }
+        memmove(&s->sorted[i], &s->sorted[i + 1], (n - 1 - i) * sizeof(float));
+        n--;
+    } else {
+        s->count++;
+    }
+    s->history[s->index] = value;
+    s->index = (s->index + 1) % stage->config.window;
+
+    uint8_t i = n;
+    while (i > 0 && s->sorted[i - 1] > value) {
+        s->sorted[i] = s->sorted[i - 1];
+        i--;
+    }
+    s->sorted[i] = value;
+
+    // Until the window fills, the lower middle of what there is
+    return s->sorted[(s->count - 1) / 2];
+}
+
+static float apply_exponential(sensor_filter_stage_t *stage, float value) {
+    sensor_filter_last_t *s = &stage->state.last;
+    if (!s->primed) {
+        s->value = value;
+        s->primed = true;
+    } else {
+        s->value += stage->config.alpha * (value - s->value);
+    }
+    return s->value;
+}
+
+static float apply_rate_limit(sensor_filter_stage_t *stage, float value, uint32_t now_ms) {
+    sensor_filter_last_t *s = &stage->state.last;
+    if (!s->primed) {
+        s->value = value;
+        s->primed = true;
+    } else {
+        float step = stage->config.max_rate * (float)(now_ms - s->time_ms) / 1000.0f;
+        if (value > s->value + step) {
+            s->value += step;
+        } else if (value < s->value - step) {
+            s->value -= step;
+        } else {
+            s->value = value;
+        }
+    }
+    s->time_ms = now_ms;
+    return s->value;
+}
+
+float sensor_filter_apply(sensor_filter_t *filter, float value, uint32_t now_ms) {
+    for (uint8_t i = 0; i < filter->count; i++) {
+        sensor_filter_stage_t *stage = &filter->stages[i];
+        switch (stage->config.type) {
+            case SENSOR_FILTER_MOVING_AVERAGE:
+                value = apply_moving_average(stage, value);
+                break;
+            case SENSOR_FILTER_MEDIAN:
+                value = apply_median(stage, value);
+                break;
+            case SENSOR_FILTER_EXPONENTIAL:
+                value = apply_exponential(stage, value);
+                break;
+            case SENSOR_FILTER_RATE_LIMIT:
+                value = apply_rate_limit(stage, value, now_ms);
+                break;
+        }
+    }
+    return value;
+}
@@ -0,0 +1,101 @@
+#include "setpoint_ramp.h"
+#include "esp_log.h"
+
+static const char *TAG = "SetpointRamp";
+
+void setpoint_ramp_init(setpoint_ramp_t *ramp, float max_rate_c_per_min) {
+    if (max_rate_c_per_min <= 0.0f) {
+        max_rate_c_per_min = SETPOINT_RAMP_MAX_RATE;
+    }
+    ramp->target = 0.0f;
+    ramp->effective = 0.0f;
+    ramp->max_rate = max_rate_c_per_min / 60.0f;
+    ramp->rate = ramp->max_rate;
+    ramp->step_rate = 0.0f;
+    ramp->ramping = false;
+    ramp->valid = false;
+}
+
+float setpoint_ramp_update(setpoint_ramp_t *ramp, float target, float temperature, float dt_s) {
+    ramp->step_rate = 0.0f;
+    if (!ramp->valid) {
+        ramp->effective = temperature < target ? temperature : target;
+        ramp->valid = true;
+    }
+
+    if (target <= ramp->effective) {
+        // Lower setpoints apply at once
+        ramp->effective = target;
+        ramp->ramping = false;
+    } else if (!ramp->ramping && target - ramp->effective <= SETPOINT_RAMP_MIN_STEP) {
+        // Small adjustments too; a running ramp just heads for the new target
+        ramp->effective = target;
+    } else {
+        if (!ramp->ramping) {
+            ramp->ramping = true;
+            ESP_LOGI(TAG, "Ramping %.1f -> %.1fC at %.3fC/min", ramp->effective, target,
+                     ramp->rate * 60.0f);
+        }
+        // Ease into the target: the loop lags a ramp, and a sharp corner
+        // leaves its integral charged
+        float rate = ramp->rate;
+        float landing = (target - ramp->effective) / SETPOINT_RAMP_LANDING_S;
+        if (landing < rate) {
+            rate = landing;
+        }
+        ramp->effective += rate * dt_s;
+        ramp->step_rate = rate;
+
+        // Never hold back a room that is ahead of the ramp
+        if (temperature > ramp->effective) {
+            ramp->effective = temperature;
+        }
+        if (ramp->effective >= target - SETPOINT_RAMP_DONE) {
+            ramp->effective = target;
+            ramp->ramping = false;
+            ramp->step_rate = 0.0f;
+        }
+    }
+
+    ramp->target = target;
+    return ramp->effective;
+}
+
+void setpoint_ramp_track(setpoint_ramp_t *ramp, float temperature) {
+    ramp->effective = temperature;
+    ramp->step_rate = 0.0f;
+    ramp->ramping = false;
+    ramp->valid = true;
+}
+
+// Full power would heat the room at (K * 100 + ambient - T) / tau; ask for
+// a share of that so the loop keeps headroom through the ramp
+void setpoint_ramp_set_model(setpoint_ramp_t *ramp, const thermal_model_params_t *model,
+                             float temperature) {
+    float rate = ramp->max_rate;
+
+    if (model->confidence >= THERMAL_MODEL_MIN_CONFIDENCE && model->tau_s > 0.0f) {
+        float full_power = (model->gain * 100.0f + model->ambient - temperature) / model->tau_s;
+        float model_rate = SETPOINT_RAMP_HEADROOM * full_power;
+        if (model_rate < rate) {
+            rate = model_rate;
+        }
+    }
+    if (rate < SETPOINT_RAMP_MIN_RATE / 60.0f) {
+        rate = SETPOINT_RAMP_MIN_RATE / 60.0f;
+    }
+    ramp->rate = rate;
+}
+
+// Holding a rate r in a first-order room takes r * tau / K on top of the
+// power that holds the temperature, which the integral already carries
+float setpoint_ramp_feedforward(const setpoint_ramp_t *ramp, const thermal_model_params_t *model) {
+    if (!ramp->ramping || model->confidence < THERMAL_MODEL_MIN_CONFIDENCE || model->gain <= 0.0f) {
+        return 0.0f;
+    }
+    return ramp->step_rate * model->tau_s / model->gain;
+}
+
+bool setpoint_ramp_is_active(const setpoint_ramp_t *ramp) {
+    return ramp->ramping;
+}
@@ -1,19 +1,13 @@
 #include "temperature_sensor.h"
+#include "ds18b20.h"
+#include "pt1000.h"
+#include "adc_sampler.h"
+#include "esp_timer.h"
 #include "esp_log.h"
-#include "esp_adc_cal.h"
 #include <math.h>
-#include <stdlib.h>
 
 static const char *TAG = "TempSensor";
 
-// ADC configuration
-#define DEFAULT_VREF    1100        // Default ADC reference voltage in mV
-#define ADC_SAMPLES     64          // Number of samples for averaging
-#define ADC_WIDTH       ADC_WIDTH_BIT_12
-#define ADC_ATTEN       ADC_ATTEN_DB_11  // Full scale 0-3.3V
-
-static esp_adc_cal_characteristics_t adc_chars;
-
 esp_err_t temperature_sensor_init(temp_sensor_t *sensor, const temp_sensor_config_t *config) {
     if (!sensor || !config) {
         return ESP_ERR_INVALID_ARG;
@@ -22,26 +16,34 @@ esp_err_t temperature_sensor_init(temp_sensor_t *sensor, const temp_sensor_confi
     sensor->config = *config;
     sensor->last_temperature = 20.0f;  // Default temperature
     sensor->last_read_time = 0;
-    sensor->filter_buffer = NULL;
-    sensor->filter_size = 0;
-    sensor->filter_index = 0;
-    sensor->filter_full = false;
+    sensor_filter_init(&sensor->filter, NULL, 0);
+    sensor->ntc_table = (ntc_table_t){0};
+    
+    // DS18B20: readings come from the 1-Wire bus task
+    if (config->sensor_type == TEMP_SENSOR_DS18B20) {
+        esp_err_t ret = ds18b20_start(config->onewire_pin);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to start the 1-Wire bus: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+    
+    // NTC: the curve is tabulated once, lookups per reading
+    if (config->sensor_type == TEMP_SENSOR_NTC_10K || config->sensor_type == TEMP_SENSOR_NTC_100K) {
+        esp_err_t ret = ntc_table_build(&sensor->ntc_table, config->beta, config->r_nominal,
+                                        config->t_nominal, config->r_series);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to build the NTC table: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
     
-    // Configure ADC for analog sensors
+    // Analog sensors are sampled by the DMA sampler (started once all are registered)
     if (config->sensor_type != TEMP_SENSOR_DS18B20) {
-        adc1_config_width(ADC_WIDTH);
-        adc1_config_channel_atten(config->adc_channel, ADC_ATTEN);
-        
-        // Characterize ADC
-        esp_adc_cal_value_t val_type = esp_adc_cal_characterize(
-            ADC_UNIT_1, ADC_ATTEN, ADC_WIDTH, DEFAULT_VREF, &adc_chars);
-        
-        if (val_type == ESP_ADC_CAL_VAL_EFUSE_TP) {
-            ESP_LOGI(TAG, "ADC characterized using Two Point Value");
-        } else if (val_type == ESP_ADC_CAL_VAL_EFUSE_VREF) {
-            ESP_LOGI(TAG, "ADC characterized using eFuse Vref");
-        } else {
-            ESP_LOGI(TAG, "ADC characterized using Default Vref");
+        esp_err_t ret = adc_sampler_add_channel(config->adc_channel);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register ADC channel %d", config->adc_channel);
+            return ret;
         }
     }
     
@@ -62,10 +64,7 @@ esp_err_t temperature_sensor_deinit(temp_sensor_t *sensor) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    if (sensor->filter_buffer) {
-        free(sensor->filter_buffer);
-        sensor->filter_buffer = NULL;
-    }
+    ntc_table_free(&sensor->ntc_table);
     
     sensor->initialized = false;
     return ESP_OK;
@@ -92,48 +91,63 @@ float voltage_divider_resistance(float v_out, float v_in, float r_series) {
     return r_series * v_out / (v_in - v_out);
 }
 
+// Latest averaged, calibrated voltage of the sensor's channel (mV)
+static bool read_adc_voltage(temp_sensor_t *sensor, uint32_t *voltage) {
+    if (adc_sampler_get_mv(sensor->config.adc_channel, voltage) != ESP_OK) {
+        ESP_LOGD(TAG, "No fresh ADC value on channel %d", sensor->config.adc_channel);
+        return false;
+    }
+    return true;
+}
+
 static float read_ntc_temperature(temp_sensor_t *sensor) {
-    // Read ADC multiple times for averaging
-    uint32_t adc_reading = 0;
-    for (int i = 0; i < ADC_SAMPLES; i++) {
-        adc_reading += adc1_get_raw(sensor->config.adc_channel);
+    uint32_t voltage;
+    if (!read_adc_voltage(sensor, &voltage)) {
+        return -273.15f;  // Invalid temperature
     }
-    adc_reading /= ADC_SAMPLES;
     
-    // Convert to voltage
-    uint32_t voltage = esp_adc_cal_raw_to_voltage(adc_reading, &adc_chars);
-    float v_thermistor = voltage / 1000.0f;  // Convert mV to V
+    // Divider voltage straight to temperature (see ntc_table.h)
+    int32_t centi = ntc_table_lookup(&sensor->ntc_table, voltage);
+    if (centi == NTC_TABLE_FAULT_CENTI) {
+        return -273.15f;  // Open or shorted NTC
+    }
+    float temperature = centi / 100.0f;
+    
+    // Apply calibration
+    temperature = temperature * sensor->config.scale + sensor->config.offset;
+    
+    ESP_LOGD(TAG, "Voltage: %lumV, Temp: %.2f°C", (unsigned long)voltage, temperature);
     
-    // Calculate thermistor resistance
-    float v_supply = 3.3f;  // Supply voltage
-    float r_thermistor = voltage_divider_resistance(v_thermistor, v_supply, sensor->config.r_series);
+    return temperature;
+}
+
+static float read_pt1000_temperature(temp_sensor_t *sensor) {
+    // Same divider as the NTC, with the RTD on the ADC side
+    uint32_t voltage;
+    if (!read_adc_voltage(sensor, &voltage)) {
+        return -273.15f;  // Invalid temperature
+    }
+    float v_rtd = voltage / 1000.0f;  // Convert mV to V
+    float r_rtd = voltage_divider_resistance(v_rtd, 3.3f, sensor->config.r_series);
     
-    // Convert resistance to temperature
-    float temperature = ntc_resistance_to_temperature(
-        r_thermistor, 
-        sensor->config.beta,
-        sensor->config.r_nominal,
-        sensor->config.t_nominal
-    );
+    // Table lookup, with the lead resistance taken off first
+    float temperature = pt1000_temperature(r_rtd, sensor->config.r_lead);
     
     // Apply calibration
     temperature = temperature * sensor->config.scale + sensor->config.offset;
     
-    ESP_LOGD(TAG, "ADC: %d, Voltage: %.3fV, Resistance: %.0fΩ, Temp: %.1f°C",
-             adc_reading, v_thermistor, r_thermistor, temperature);
+    ESP_LOGD(TAG, "Voltage: %.3fV, Resistance: %.1fΩ, Temp: %.2f°C",
+             v_rtd, r_rtd, temperature);
     
     return temperature;
 }
 
 static float read_lm35_temperature(temp_sensor_t *sensor) {
     // LM35: 10mV/°C, 0°C = 0V
-    uint32_t adc_reading = 0;
-    for (int i = 0; i < ADC_SAMPLES; i++) {
-        adc_reading += adc1_get_raw(sensor->config.adc_channel);
+    uint32_t voltage;
+    if (!read_adc_voltage(sensor, &voltage)) {
+        return -273.15f;  // Invalid temperature
     }
-    adc_reading /= ADC_SAMPLES;
-    
-    uint32_t voltage = esp_adc_cal_raw_to_voltage(adc_reading, &adc_chars);
     float temperature = voltage / 10.0f;  // 10mV per degree
     
     // Apply calibration
@@ -161,15 +175,16 @@ float temperature_sensor_read(temp_sensor_t *sensor) {
             break;
             
         case TEMP_SENSOR_DS18B20:
-            // TODO: Implement OneWire protocol for DS18B20
-            ESP_LOGW(TAG, "DS18B20 not implemented yet");
-            temperature = 20.0f;
+            // Latest conversion; never waits on the bus
+            if (ds18b20_get(sensor->config.onewire_index, &temperature) != ESP_OK) {
+                ESP_LOGD(TAG, "No fresh DS18B20 reading");
+                return -273.15f;  // Invalid temperature
+            }
+            temperature = temperature * sensor->config.scale + sensor->config.offset;
             break;
             
         case TEMP_SENSOR_PT1000:
-            // TODO: Implement PT1000 reading
-            ESP_LOGW(TAG, "PT1000 not implemented yet");
-            temperature = 20.0f;
+            temperature = read_pt1000_temperature(sensor);
             break;
             
         default:
@@ -177,10 +192,16 @@ float temperature_sensor_read(temp_sensor_t *sensor) {
             return -273.15f;
     }
     
-    // Sanity check
+    // No measurement at all (no fresh ADC value, open RTD): not a reading to hold on to
+    if (temperature <= -273.15f) {
+        return -273.15f;
+    }
+    
+    // Sanity check: a reading this far out means a faulty sensor, and a stale
+    // value in its place would hide the fault from the control loops
     if (temperature < -50.0f || temperature > 150.0f) {
         ESP_LOGW(TAG, "Temperature out of range: %.1f°C", temperature);
-        return sensor->last_temperature;  // Return last valid reading
+        return -273.15f;
     }
     
     sensor->last_temperature = temperature;
@@ -195,28 +216,11 @@ float temperature_sensor_read_filtered(temp_sensor_t *sensor) {
     }
     
     float raw_temp = temperature_sensor_read(sensor);
-    
-    if (!sensor->filter_buffer || sensor->filter_size == 0) {
-        return raw_temp;  // No filtering
-    }
-    
-    // Add to filter buffer
-    sensor->filter_buffer[sensor->filter_index] = raw_temp;
-    sensor->filter_index = (sensor->filter_index + 1) % sensor->filter_size;
-    
-    if (!sensor->filter_full && sensor->filter_index == 0) {
-        sensor->filter_full = true;
-    }
-    
-    // Calculate average
-    float sum = 0.0f;
-    int count = sensor->filter_full ? sensor->filter_size : sensor->filter_index;
-    
-    for (int i = 0; i < count; i++) {
-        sum += sensor->filter_buffer[i];
+    if (raw_temp <= -273.15f) {
+        return raw_temp;  // No measurement: kept out of the filter state
     }
     
-    return sum / count;
+    return sensor_filter_apply(&sensor->filter, raw_temp, esp_timer_get_time() / 1000);
 }
 
 esp_err_t temperature_sensor_calibrate(temp_sensor_t *sensor, float offset, float scale) {
@@ -231,33 +235,54 @@ esp_err_t temperature_sensor_calibrate(temp_sensor_t *sensor, float offset, floa
     return ESP_OK;
 }
 
-esp_err_t temperature_sensor_set_filter(temp_sensor_t *sensor, uint8_t filter_size) {
-    if (!sensor) {
+esp_err_t temperature_sensor_set_ntc(temp_sensor_t *sensor, float beta, float r_nominal,
+                                     float t_nominal, float r_series) {
+    if (!sensor || (sensor->config.sensor_type != TEMP_SENSOR_NTC_10K &&
+                    sensor->config.sensor_type != TEMP_SENSOR_NTC_100K)) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    // Free existing buffer
-    if (sensor->filter_buffer) {
-        free(sensor->filter_buffer);
-        sensor->filter_buffer = NULL;
+    esp_err_t ret = ntc_table_build(&sensor->ntc_table, beta, r_nominal, t_nominal, r_series);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to rebuild the NTC table: %s", esp_err_to_name(ret));
+        return ret;
     }
     
+    sensor->config.beta = beta;
+    sensor->config.r_nominal = r_nominal;
+    sensor->config.t_nominal = t_nominal;
+    sensor->config.r_series = r_series;
+    
+    ESP_LOGI(TAG, "NTC curve set: beta=%.0f, R0=%.0f, T0=%.1f, Rs=%.0f",
+             beta, r_nominal, t_nominal, r_series);
+    return ESP_OK;
+}
+
+esp_err_t temperature_sensor_set_filter(temp_sensor_t *sensor, uint8_t filter_size) {
     if (filter_size == 0) {
-        sensor->filter_size = 0;
-        return ESP_OK;
+        return temperature_sensor_set_filter_chain(sensor, NULL, 0);
     }
     
-    // Allocate new buffer
-    sensor->filter_buffer = (float *)calloc(filter_size, sizeof(float));
-    if (!sensor->filter_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate filter buffer");
-        return ESP_ERR_NO_MEM;
+    sensor_filter_stage_config_t average = {
+        .type = SENSOR_FILTER_MOVING_AVERAGE,
+        .window = filter_size,
+    };
+    return temperature_sensor_set_filter_chain(sensor, &average, 1);
+}
+
+esp_err_t temperature_sensor_set_filter_chain(temp_sensor_t *sensor,
+                                              const sensor_filter_stage_config_t *stages,
+                                              uint8_t count) {
+    if (!sensor) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    sensor->filter_size = filter_size;
-    sensor->filter_index = 0;
-    sensor->filter_full = false;
+    esp_err_t ret = sensor_filter_init(&sensor->filter, stages, count);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Invalid filter chain");
+        return ret;
+    }
     
-    ESP_LOGI(TAG, "Filter enabled with size %d", filter_size);
+    ESP_LOGI(TAG, "Filter chain set: %d stage(s)", count);
     return ESP_OK;
-}
\ No newline at end of file
+}
@@ -0,0 +1,218 @@
+#include "thermal_model.h"
+#include "esp_log.h"
+#include <math.h>
+#include <string.h>
+
+static const char *TAG = "ThermalModel";
+
+#define TEMP_REFERENCE      20.0f   // Regressor offset, keeps the columns well scaled
+#define COV_INITIAL         1.0f    // Weak prior
+#define COV_TRACE_MAX       10.0f   // No forgetting above this: no windup without excitation
+#define COV_OFFSET_DRIFT    1e-3f   // Random walk on p2: ambient moves over the day
+
+// Candidate dead times, in model samples
+static const uint8_t s_delays[THERMAL_MODEL_NUM_DELAYS] = { 0, 1, 2, 3, 5, 8 };
+
+void thermal_model_init(thermal_model_t *model) {
+    memset(model, 0, sizeof(*model));
+    for (int i = 0; i < THERMAL_MODEL_NUM_DELAYS; i++) {
+        thermal_rls_t *rls = &model->rls[i];
+        for (int j = 0; j < 3; j++) {
+            rls->cov[j][j] = COV_INITIAL;
+        }
+        rls->error_var = -1.0f;  // None yet
+    }
+}
+
+// Mean power over model sample k - age
+static inline float power_at(const thermal_model_t *model, int age) {
+    int n = THERMAL_MODEL_MAX_DELAY + 2;
+    return model->power_history[(model->history_head - 1 - age + n) % n];
+}
+
+// One recursive least squares step with forgetting
+static void rls_update(thermal_rls_t *rls, const float phi[3], float y) {
+    float cov_phi[3];
+    float denom = THERMAL_MODEL_FORGETTING;
+    float error = y;
+
+    for (int i = 0; i < 3; i++) {
+        cov_phi[i] = rls->cov[i][0] * phi[0] + rls->cov[i][1] * phi[1] + rls->cov[i][2] * phi[2];
+        denom += phi[i] * cov_phi[i];
+        error -= rls->p[i] * phi[i];
+    }
+
+    // A priori error: what this dead time would have predicted
+    if (rls->error_var < 0.0f) {
+        rls->error_var = error * error;
+    } else {
+        rls->error_var = THERMAL_MODEL_FORGETTING * rls->error_var +
+                         (1.0f - THERMAL_MODEL_FORGETTING) * error * error;
+    }
+
+    float trace = rls->cov[0][0] + rls->cov[1][1] + rls->cov[2][2];
+    float lambda = (trace < COV_TRACE_MAX) ? THERMAL_MODEL_FORGETTING : 1.0f;
+
+    for (int i = 0; i < 3; i++) {
+        float gain = cov_phi[i] / denom;
+        rls->p[i] += gain * error;
+    }
+    // Upper triangle, mirrored: stays symmetric in float
+    for (int i = 0; i < 3; i++) {
+        for (int j = i; j < 3; j++) {
+            float c = (rls->cov[i][j] - cov_phi[i] * cov_phi[j] / denom) / lambda;
+            rls->cov[i][j] = c;
+            rls->cov[j][i] = c;
+        }
+    }
+    rls->cov[2][2] += COV_OFFSET_DRIFT;
+}
+
+// Smallest prediction error wins
+static int best_estimator(const thermal_model_t *model) {
+    int best = 0;
+    for (int i = 1; i < THERMAL_MODEL_NUM_DELAYS; i++) {
+        if (model->rls[i].error_var >= 0.0f &&
+            (model->rls[best].error_var < 0.0f || model->rls[i].error_var < model->rls[best].error_var)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool thermal_model_update(thermal_model_t *model, float power_percent, float temperature) {
+    model->power_sum += power_percent;
+    model->temp_sum += temperature;
+    if (++model->count < THERMAL_MODEL_SAMPLE_S) {
+        return false;
+    }
+
+    float power = model->power_sum / model->count;
+    float temp = model->temp_sum / model->count;
+    model->power_sum = 0.0f;
+    model->temp_sum = 0.0f;
+    model->count = 0;
+
+    model->power_history[model->history_head] = power;
+    model->history_head = (model->history_head + 1) % (THERMAL_MODEL_MAX_DELAY + 2);
+
+    // Fit each dead time whose inputs are all known
+    if (model->history_len > 0) {
+        float dy = temp - model->last_temp;
+        for (int i = 0; i < THERMAL_MODEL_NUM_DELAYS; i++) {
+            int d = s_delays[i];
+            if (d + 1 > model->history_len) {
+                continue;
+            }
+            float phi[3] = {
+                model->last_temp - TEMP_REFERENCE,
+                (power_at(model, d) + power_at(model, d + 1)) / 200.0f,
+                1.0f,
+            };
+            rls_update(&model->rls[i], phi, dy);
+        }
+        model->samples++;
+    }
+
+    if (model->history_len < THERMAL_MODEL_MAX_DELAY + 2) {
+        model->history_len++;
+    }
+    model->last_temp = temp;
+    return true;
+}
+
+void thermal_model_hold(thermal_model_t *model) {
+    // The next sample starts a fresh history; the fits themselves are kept
+    model->power_sum = 0.0f;
+    model->temp_sum = 0.0f;
+    model->count = 0;
+    model->history_len = 0;
+}
+
+void thermal_model_get_params(const thermal_model_t *model, thermal_model_params_t *params) {
+    int best = best_estimator(model);
+    const thermal_rls_t *rls = &model->rls[best];
+    float p0 = rls->p[0];
+    float p1 = rls->p[1];
+
+    memset(params, 0, sizeof(*params));
+    params->samples = model->samples;
+    params->dead_time_s = (float)s_delays[best] * THERMAL_MODEL_SAMPLE_S;
+
+    // A room that heats with power and relaxes towards ambient, or nothing
+    if (!(p0 < 0.0f && p0 > -0.5f && p1 > 0.0f) || rls->error_var < 0.0f) {
+        return;
+    }
+
+    params->gain = -p1 / (100.0f * p0);
+    params->tau_s = -THERMAL_MODEL_SAMPLE_S / logf(1.0f + p0);
+    params->ambient = TEMP_REFERENCE - rls->p[2] / p0;
+
+    // Relative standard deviation of the two parameters that set K and tau
+    float rel0 = sqrtf(rls->error_var * rls->cov[0][0]) / -p0;
+    float rel1 = sqrtf(rls->error_var * rls->cov[1][1]) / p1;
+    float confidence = 1.0f - 2.0f * sqrtf(rel0 * rel0 + rel1 * rel1);
+    params->confidence = confidence > 0.0f ? confidence : 0.0f;
+}
+
+// SIMC rules (Skogestad) for a first-order-plus-dead-time plant. The
+// derivative is left off, as for the relay tune.
+bool thermal_model_get_tunings(const thermal_model_t *model, float *kp, float *ki, float *kd) {
+    thermal_model_params_t params;
+    thermal_model_get_params(model, &params);
+
+    if (params.samples < THERMAL_MODEL_MIN_SAMPLES || params.confidence < THERMAL_MODEL_MIN_CONFIDENCE) {
+        return false;
+    }
+
+    float tau_c = params.dead_time_s > THERMAL_MODEL_MIN_TAUC_S ? params.dead_time_s : THERMAL_MODEL_MIN_TAUC_S;
+    float kc = params.tau_s / (params.gain * (tau_c + params.dead_time_s));
+    float ti = 4.0f * (tau_c + params.dead_time_s);
+    if (params.tau_s < ti) {
+        ti = params.tau_s;
+    }
+
+    *kp = kc;
+    *ki = kc / ti;
+    *kd = 0.0f;
+    return true;
+}
+
+static inline float relative_change(float from, float to) {
+    return (from > 0.0f) ? fabsf(to - from) / from : INFINITY;
+}
+
+static inline float limit_change(float from, float to) {
+    // At most a factor of two per retune
+    if (from > 0.0f && to > 2.0f * from) {
+        return 2.0f * from;
+    }
+    if (to < 0.5f * from) {
+        return 0.5f * from;
+    }
+    return to;
+}
+
+bool thermal_model_retune(thermal_model_t *model, pid_controller_t *pid) {
+    float kp, ki, kd;
+
+    if (pid_controller_get_auto_tune_state(pid) == PID_TUNE_RUNNING ||
+        model->samples - model->last_retune < THERMAL_MODEL_RETUNE_HOLDOFF ||
+        !thermal_model_get_tunings(model, &kp, &ki, &kd)) {
+        return false;
+    }
+
+    float drift = fmaxf(relative_change(pid->config.kp, kp), relative_change(pid->config.ki, ki));
+    if (drift < THERMAL_MODEL_DRIFT && pid->config.kd == 0.0f) {
+        return false;
+    }
+
+    kp = limit_change(pid->config.kp, kp);
+    ki = limit_change(pid->config.ki, ki);
+    pid_controller_set_tunings(pid, kp, ki, kd);
+    model->last_retune = model->samples;
+
+    ESP_LOGI(TAG, "Retuned for the identified room: kp=%.2f ki=%.5f kd=%.1f (drift %.0f%%)",
+             kp, ki, kd, drift * 100.0f);
+    return true;
+}
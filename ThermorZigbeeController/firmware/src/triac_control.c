@@ -1,65 +1,588 @@
 #include "triac_control.h"
+#include <stdatomic.h>
+#include "triac_power_table.h"
+#include "zero_cross_tracker.h"
+#include "triac_etm.h"
 #include "esp_log.h"
 #include "esp_timer.h"
-#include "driver/timer.h"
+#include "esp_cpu.h"
+#include "driver/gptimer.h"
+#include "driver/gpio_filter.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
-#include <math.h>
 
 static const char *TAG = "TriacControl";
 
 // Constants
-#define TIMER_GROUP         TIMER_GROUP_0
-#define TIMER_IDX           TIMER_0
-#define TIMER_DIVIDER       80      // 1 microsecond resolution
+#define TIMER_RESOLUTION_HZ 1000000 // 1 microsecond resolution
 #define TRIAC_PULSE_WIDTH   10      // 10 microseconds pulse
+#define ALARM_MIN_LEAD_US   5       // Closer events are handled in the current ISR pass
+#define ALARM_LATE_US       50      // Firing later than this counts as a missed alarm
+#define MIN_FIRING_DELAY_US 100     // Earliest firing point after a zero crossing
+#define HALF_CYCLE_SPLIT_US 9100    // Shorter half-cycles use the 60Hz table
+#define BURST_WINDOW        100     // Burst resolution in mains cycles (1%)
+#define ZC_GLITCH_WINDOW_NS 500     // Shorter zero-cross pulses are filtered in hardware
+#define SYNC_CHATTER_LIMIT  8       // Rejected edges between two good ones before sync is dropped
+#define RAMP_SHIFT          8       // Ramp levels are in 1/256 %
+#define STAGE_ROTATE_S      600     // Element roles move on every 10 minutes
+
+// One firing event of the current half-cycle
+typedef struct {
+    uint16_t delay_us;       // Delay after the zero crossing
+    uint16_t conduction_us;  // Full-power equivalent of the conduction that follows
+    uint8_t channel;         // Triac index
+} firing_entry_t;
 
 // Global state
 static triac_config_t g_config;
-static triac_state_t g_triacs[MAX_TRIACS];
 static SemaphoreHandle_t g_mutex = NULL;
 static volatile bool g_zero_cross_detected = false;
-static esp_timer_handle_t g_firing_timer = NULL;
+static gptimer_handle_t g_timer = NULL;
+
+// Published channel settings. Writers (serialised by g_mutex) fill the
+// spare copy and swap the pointer; the ISRs and the getters never lock.
+// The sequence number lets a task-side reader detect that a later writer
+// reused the copy it was reading, and retry.
+typedef struct {
+    triac_state_t triacs[MAX_TRIACS];
+} firing_table_t;
+
+static firing_table_t g_tables[2];
+static _Atomic(firing_table_t *) g_active_table = &g_tables[0];
+static atomic_uint g_table_seq = 0;
+
+// Per half-cycle firing schedule, sorted by delay (owned by the ISRs)
+static firing_entry_t g_schedule[MAX_TRIACS];
+static uint8_t g_schedule_len = 0;
+static uint8_t g_schedule_next = 0;
+static uint64_t g_pulse_end[MAX_TRIACS];  // Gate pulse end per channel, UINT64_MAX if idle
+static uint64_t g_zero_cross_time = 0;   // Timer count at the current crossing
+static bool g_timer_driven = false;      // Half-cycles clocked by predicted crossings
+static bool g_etm_active = false;        // Firing handed over to the ETM chain
+static gpio_glitch_filter_handle_t g_zc_filter = NULL;
+
+// Mains period and phase tracking
+static zc_tracker_t g_zc;
+
+// Sync supervisor: one missing edge is bridged by the prediction, a second
+// one (or a chattering input) drops every gate and restarts acquisition
+static uint64_t g_sync_deadline = UINT64_MAX;  // Sync is lost without a good edge by then
+static uint8_t g_chatter = 0;                  // Rejected edges since the last good one
+
+// Burst mode distributor state (owned by the zero-cross ISR)
+static uint8_t g_burst_error[MAX_TRIACS];
+static uint8_t g_burst_gate[MAX_TRIACS];   // Gate level held for the running cycle
+static triac_mode_t g_run_mode[MAX_TRIACS]; // Mode the ISR last ran each channel in
+static uint8_t g_cycle_phase = 0;
+
+// Soft-start ramp per channel, one step per half-cycle (owned by the ISRs).
+// A new target starts a segment from the present level; its length is
+// proportional to the swing, so ramp_ms sets a rate, not a fixed duration.
+typedef struct {
+    uint16_t level;          // Output level now (1/256 %)
+    uint16_t from;           // Segment start level
+    uint16_t to;             // Segment target level
+    uint32_t step;           // Half-cycles into the segment
+    uint32_t steps;          // Segment length in half-cycles
+} ramp_state_t;
+
+static ramp_state_t g_ramp[MAX_TRIACS];
+static volatile uint16_t g_ramp_ms = 0;
+static volatile triac_ramp_curve_t g_ramp_curve = TRIAC_RAMP_LINEAR;
 
-// Calculate half-cycle period in microseconds
-static uint32_t get_half_cycle_us(uint8_t frequency) {
-    return (frequency == 60) ? 8333 : 10000;  // 60Hz: 8.33ms, 50Hz: 10ms
+// Power staging: whole elements fully on, at most one modulated. The
+// element order starts at g_stage_lead, which rotates to spread the wear.
+static uint8_t g_stage_lead = 0;
+static int64_t g_stage_since = 0;   // esp_timer time of the last rotation
+
+// Delivered energy per channel, as time at full power (us). Written by the
+// ISRs only; ETM firing is integrated from the task side instead.
+static volatile uint64_t g_energy_us[MAX_TRIACS];
+static int64_t g_etm_energy_since = 0;      // esp_timer time of the last ETM integration
+static uint32_t g_etm_conduction_q15 = 0;   // Conduction fraction of the running ETM angle
+static uint32_t g_etm_mask = 0;             // Channels firing under ETM
+
+// Diagnostics counters
+static volatile uint32_t g_zero_crossings = 0;
+static volatile uint32_t g_fired_pulses = 0;
+static volatile uint32_t g_missed_alarms = 0;
+static volatile uint32_t g_isr_max_cycles = 0;
+static volatile uint32_t g_sync_losses = 0;
+static uint32_t g_sample_latency_us = 0;     // Sensor sample to published table
+static uint32_t g_sample_latency_max_us = 0;
+
+// Current time on the free-running time base
+static inline uint64_t IRAM_ATTR timer_now(void) {
+    uint64_t count = 0;
+    gptimer_get_raw_count(g_timer, &count);
+    return count;
 }
 
-// Zero crossing interrupt handler
-static void IRAM_ATTR zero_cross_isr(void *arg) {
+// Arm the timer alarm at an absolute timer count
+static inline void IRAM_ATTR arm_alarm(uint64_t at) {
+    gptimer_alarm_config_t alarm_config = {
+        .alarm_count = at,
+        .flags.auto_reload_on_alarm = false,
+    };
+    gptimer_set_alarm_action(g_timer, &alarm_config);
+}
+
+// Keep the worst-case time spent in the firing ISRs
+static inline void IRAM_ATTR record_isr_time(uint32_t start_cycles) {
+    uint32_t cycles = esp_cpu_get_cycle_count() - start_cycles;
+    if (cycles > g_isr_max_cycles) {
+        g_isr_max_cycles = cycles;
+    }
+}
+
+// Private copy of the published table to modify (g_mutex held)
+static firing_table_t *table_begin(void) {
+    firing_table_t *active = atomic_load(&g_active_table);
+    firing_table_t *spare = (active == &g_tables[0]) ? &g_tables[1] : &g_tables[0];
+    *spare = *active;
+    return spare;
+}
+
+// Make a table built by table_begin() the one everybody reads
+static void table_publish(firing_table_t *table) {
+    atomic_store(&g_active_table, table);
+    atomic_fetch_add(&g_table_seq, 1);
+}
+
+// Consistent copy of the published table, for task-context readers
+static void table_snapshot(firing_table_t *out) {
+    unsigned seq;
+    do {
+        seq = atomic_load(&g_table_seq);
+        *out = *atomic_load(&g_active_table);
+    } while (seq != atomic_load(&g_table_seq));
+}
+
+// Advance a channel's ramp by one half-cycle toward target (1/256 %)
+static uint16_t IRAM_ATTR ramp_step(ramp_state_t *ramp, uint16_t target, uint32_t half_cycle) {
+    if (target != ramp->to) {
+        uint32_t swing = (target > ramp->level) ? target - ramp->level : ramp->level - target;
+        ramp->from = ramp->level;
+        ramp->to = target;
+        ramp->step = 0;
+        ramp->steps = ((uint64_t)g_ramp_ms * 1000 * swing) / ((uint64_t)half_cycle * (100 << RAMP_SHIFT));
+    }
+    if (ramp->step >= ramp->steps) {
+        ramp->level = ramp->to;
+        return ramp->level;
+    }
+    
+    ramp->step++;
+    uint64_t x = ((uint64_t)ramp->step << 16) / ramp->steps;  // Progress, Q16
+    if (g_ramp_curve == TRIAC_RAMP_S_CURVE) {
+        x = (((x * x) >> 16) * ((3u << 16) - 2 * x)) >> 16;  // 3x^2 - 2x^3
+    }
+    int32_t delta = (int32_t)ramp->to - (int32_t)ramp->from;
+    ramp->level = ramp->from + (int32_t)(((int64_t)delta * (int64_t)x) / 65536);
+    return ramp->level;
+}
+
+// Firing delay for a level in 1/256 %, interpolated between table steps
+static uint16_t IRAM_ATTR level_to_firing_delay(uint16_t level, uint32_t half_cycle) {
+    uint8_t percent = level >> RAMP_SHIFT;
+    int32_t fraction = level & ((1 << RAMP_SHIFT) - 1);
+    int32_t delay = power_to_firing_delay(percent, half_cycle);
+    
+    if (fraction == 0 || percent >= 100) {
+        return delay;
+    }
+    int32_t next = power_to_firing_delay(percent + 1, half_cycle);
+    return delay + ((next - delay) * fraction) / (1 << RAMP_SHIFT);
+}
+
+// Start a half-cycle at the given (true) crossing time
+static void IRAM_ATTR begin_half_cycle(uint64_t crossing) {
+    // Read once: writers only fill the other copy, and never run during this ISR
+    const triac_state_t *triacs = atomic_load(&g_active_table)->triacs;
+    bool locked = zc_tracker_is_locked(&g_zc);
+    uint32_t half_cycle = zc_tracker_half_cycle_us(&g_zc);
+    
     g_zero_cross_detected = true;
+    g_zero_cross_time = crossing;
+    g_zero_crossings++;
     
-    // Schedule firing for all enabled triacs
+    // Events still pending from the previous half-cycle are dropped
+    if (g_schedule_next < g_schedule_len) {
+        g_missed_alarms += g_schedule_len - g_schedule_next;
+    }
+    
+    // Burst channels switch once per full mains cycle so the load never
+    // sees a DC component. The error accumulator spreads the on-cycles
+    // evenly over the window (Bresenham / first-order sigma-delta).
+    g_cycle_phase ^= 1;
+    
+    // Build this half-cycle's schedule, sorted by delay (insertion sort, n <= MAX_TRIACS)
+    uint8_t len = 0;
     for (int i = 0; i < g_config.num_triacs; i++) {
-        if (g_triacs[i].enabled && g_triacs[i].power_level > 0) {
-            // Use hardware timer for precise timing
-            timer_set_counter_value(TIMER_GROUP, TIMER_IDX, 0);
-            timer_set_alarm_value(TIMER_GROUP, TIMER_IDX, g_triacs[i].firing_delay);
-            timer_start(TIMER_GROUP, TIMER_IDX);
+        // A mode change reaches the ISR through the table: a burst channel
+        // may be holding its gate, so restart from a clean state
+        if (triacs[i].mode != g_run_mode[i]) {
+            g_run_mode[i] = triacs[i].mode;
+            g_burst_error[i] = 0;
+            g_burst_gate[i] = 0;
+            gpio_set_level(g_config.triac_pins[i], 0);
         }
+        
+        // An explicit disable cuts at once, even during a ramp-down; level
+        // changes (drops included) ramp
+        if (triacs[i].cut) {
+            g_ramp[i] = (ramp_state_t) {0};
+        }
+        uint16_t target = triacs[i].enabled ? (uint16_t)triacs[i].power_level << RAMP_SHIFT : 0;
+        uint16_t level = locked ? ramp_step(&g_ramp[i], target, half_cycle) : 0;
+        
+        if (triacs[i].mode == TRIAC_MODE_BURST) {
+            if (g_cycle_phase || !locked) {
+                uint8_t gate = 0;
+                if (level > 0) {
+                    g_burst_error[i] += level >> RAMP_SHIFT;
+                    if (g_burst_error[i] >= BURST_WINDOW) {
+                        g_burst_error[i] -= BURST_WINDOW;
+                        gate = 1;
+                    }
+                }
+                gpio_set_level(g_config.triac_pins[i], gate);
+                g_burst_gate[i] = gate;
+            }
+            if (g_burst_gate[i]) {
+                g_energy_us[i] += half_cycle;  // Whole half-cycle conducts
+            }
+            continue;
+        }
+        
+        if (level == 0) {
+            continue;
+        }
+        
+        // Scaled to the tracked period, not the nominal one
+        uint16_t delay = level_to_firing_delay(level, half_cycle);
+        int j = len;
+        while (j > 0 && g_schedule[j - 1].delay_us > delay) {
+            g_schedule[j] = g_schedule[j - 1];
+            j--;
+        }
+        g_schedule[j].delay_us = delay;
+        g_schedule[j].conduction_us = (triac_table_power_q15(delay, half_cycle) * half_cycle) >> 15;
+        g_schedule[j].channel = i;
+        len++;
     }
+    g_schedule_len = len;
+    g_schedule_next = 0;
+    
+    // While phase firing is active the timer clocks the half-cycles from
+    // the predicted crossings; otherwise detector edges do
+    g_timer_driven = (len > 0);
 }
 
-// Timer interrupt for triac firing
-static void IRAM_ATTR timer_isr(void *arg) {
-    // Clear interrupt
-    timer_group_clr_intr_status_in_isr(TIMER_GROUP, TIMER_IDX);
-    
-    // Fire all triacs that need firing
+// A good edge: the next one is due within one mains period plus the window
+static inline void IRAM_ATTR feed_sync_watchdog(uint64_t now) {
+    uint32_t half_cycle = zc_tracker_half_cycle_us(&g_zc);
+    g_sync_deadline = now + 2 * half_cycle + half_cycle / 8;
+    g_chatter = 0;
+}
+
+// Mains sync lost: every gate low at once, then back to lock acquisition
+static void IRAM_ATTR sync_lost(void) {
+    for (int i = 0; i < g_config.num_triacs; i++) {
+        gpio_set_level(g_config.triac_pins[i], 0);
+        g_pulse_end[i] = UINT64_MAX;
+        g_burst_error[i] = 0;
+        g_burst_gate[i] = 0;
+        g_ramp[i] = (ramp_state_t) {0};  // Soft-start again after re-lock
+    }
+    g_schedule_len = 0;
+    g_schedule_next = 0;
+    g_timer_driven = false;
+    g_sync_deadline = UINT64_MAX;
+    g_chatter = 0;
+    g_sync_losses++;
+    zc_tracker_resync(&g_zc);
+}
+
+// Earliest pending gate pulse end
+static inline uint64_t IRAM_ATTR next_pulse_end(void) {
+    uint64_t at = UINT64_MAX;
+    for (int i = 0; i < g_config.num_triacs; i++) {
+        if (g_pulse_end[i] < at) {
+            at = g_pulse_end[i];
+        }
+    }
+    return at;
+}
+
+// Next firing of the running half-cycle
+static inline uint64_t IRAM_ATTR next_firing(void) {
+    if (g_schedule_next < g_schedule_len) {
+        return g_zero_cross_time + g_schedule[g_schedule_next].delay_us;
+    }
+    return UINT64_MAX;
+}
+
+// Next predicted crossing, when the timer clocks the half-cycles
+static inline uint64_t IRAM_ATTR next_crossing(void) {
+    if (g_timer_driven && zc_tracker_is_locked(&g_zc)) {
+        return g_zc.next;
+    }
+    return UINT64_MAX;
+}
+
+// Raise the gate of every firing that is due; the pulse end is a later alarm
+static void IRAM_ATTR fire_due(uint64_t now) {
+    while (g_schedule_next < g_schedule_len) {
+        const firing_entry_t *entry = &g_schedule[g_schedule_next];
+        uint64_t due = g_zero_cross_time + entry->delay_us;
+        if (due > now + ALARM_MIN_LEAD_US) {
+            break;
+        }
+        if (now > due + ALARM_LATE_US) {
+            g_missed_alarms++;
+        }
+        gpio_set_level(g_config.triac_pins[entry->channel], 1);
+        g_pulse_end[entry->channel] = now + TRIAC_PULSE_WIDTH;
+        g_energy_us[entry->channel] += entry->conduction_us;
+        g_fired_pulses++;
+        g_schedule_next++;
+    }
+}
+
+// Drop the gates whose pulse is complete
+static void IRAM_ATTR end_pulses(uint64_t now) {
     for (int i = 0; i < g_config.num_triacs; i++) {
-        if (g_triacs[i].enabled && g_triacs[i].power_level > 0) {
-            gpio_set_level(g_config.triac_pins[i], 1);
+        if (g_pulse_end[i] <= now + ALARM_MIN_LEAD_US) {
+            gpio_set_level(g_config.triac_pins[i], 0);
+            g_pulse_end[i] = UINT64_MAX;
+        }
+    }
+}
+
+// Handle every event that is due, earliest first
+static void IRAM_ATTR process_events(uint64_t now) {
+    while (true) {
+        uint64_t pulse_end = next_pulse_end();
+        uint64_t firing = next_firing();
+        uint64_t crossing = next_crossing();
+        
+        if (g_sync_deadline <= now) {
+            sync_lost();
+        } else if (pulse_end <= now + ALARM_MIN_LEAD_US &&
+            pulse_end <= firing && pulse_end <= crossing) {
+            end_pulses(now);
+        } else if (crossing <= now + ALARM_MIN_LEAD_US && crossing <= firing) {
+            begin_half_cycle(zc_tracker_advance(&g_zc));
+        } else if (firing <= now + ALARM_MIN_LEAD_US) {
+            fire_due(now);
+        } else {
+            break;
         }
     }
+}
+
+// Arm the alarm for the earliest pending event
+static void IRAM_ATTR arm_next_event(void) {
+    uint64_t at = next_pulse_end();
+    uint64_t firing = next_firing();
+    uint64_t crossing = next_crossing();
+    
+    if (firing < at) {
+        at = firing;
+    }
+    if (crossing < at) {
+        at = crossing;
+    }
+    if (g_sync_deadline < at) {
+        at = g_sync_deadline;
+    }
+    if (at != UINT64_MAX) {
+        arm_alarm(at);
+    }
+}
+
+// Zero crossing interrupt handler
+static void IRAM_ATTR zero_cross_isr(void *arg) {
+    (void)arg;
+    uint32_t start = esp_cpu_get_cycle_count();
+    uint64_t now = timer_now();
+    
+    zc_edge_result_t result = zc_tracker_edge(&g_zc, now);
+    
+    switch (result) {
+        case ZC_EDGE_LOCKED:
+            feed_sync_watchdog(now);
+            begin_half_cycle(g_zc.last);
+            break;
+            
+        case ZC_EDGE_NEXT:
+            // Edge-clocked: this edge starts the half-cycle.
+            // Timer-clocked: the prediction was corrected, the alarm follows it.
+            feed_sync_watchdog(now);
+            if (!g_timer_driven) {
+                begin_half_cycle(zc_tracker_advance(&g_zc));
+            }
+            break;
+            
+        case ZC_EDGE_LAST:
+            // Late edge: re-anchor the rest of the running half-cycle
+            feed_sync_watchdog(now);
+            g_zero_cross_time = g_zc.last;
+            break;
+            
+        case ZC_EDGE_REJECTED:
+            // Glitch: nothing changed, so nothing to re-arm, unless the
+            // input chatters too much to be trusted
+            if (++g_chatter <= SYNC_CHATTER_LIMIT) {
+                record_isr_time(start);
+                return;
+            }
+            sync_lost();
+            break;
+            
+        default:
+            // Lock acquisition
+            break;
+    }
     
-    // Schedule pulse end
-    ets_delay_us(TRIAC_PULSE_WIDTH);
+    process_events(now);
+    arm_next_event();
+    record_isr_time(start);
+}
+
+// Timer alarm: gate pulse edges and predicted crossings. Never busy-waits;
+// it only switches outputs and arms the next alarm.
+static bool IRAM_ATTR timer_alarm_cb(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata,
+                                     void *user_ctx) {
+    (void)timer;
+    (void)edata;
+    (void)user_ctx;
+    uint32_t start = esp_cpu_get_cycle_count();
     
-    // Turn off all triacs
+    process_events(timer_now());
+    arm_next_event();
+    record_isr_time(start);
+    
+    return false;  // No task woken
+}
+
+// Free-running time base and alarm for the software firing path
+static esp_err_t start_firing_timer(void) {
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = TIMER_RESOLUTION_HZ,
+    };
+    esp_err_t ret = gptimer_new_timer(&timer_config, &g_timer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    gptimer_event_callbacks_t timer_cbs = {
+        .on_alarm = timer_alarm_cb,
+    };
+    gptimer_register_event_callbacks(g_timer, &timer_cbs, NULL);
+    gptimer_enable(g_timer);
+    return gptimer_start(g_timer);
+}
+
+static void stop_firing_timer(void) {
+    if (g_timer) {
+        gptimer_stop(g_timer);
+        gptimer_disable(g_timer);
+        gptimer_del_timer(g_timer);
+        g_timer = NULL;
+    }
+}
+
+// Hand the firing over to the ETM chain. The software path stays in charge
+// until the tracker has locked, since the chain cannot measure the mains.
+// Both general-purpose timers are needed by the chain, so the software
+// timer is released first and restored if the chain cannot be built.
+static void start_hardware_firing(void) {
+    gpio_intr_disable(g_config.zero_cross_pin);
+    stop_firing_timer();
+    
+    g_schedule_len = 0;
+    g_schedule_next = 0;
+    g_timer_driven = false;
+    g_sync_deadline = UINT64_MAX;
     for (int i = 0; i < g_config.num_triacs; i++) {
         gpio_set_level(g_config.triac_pins[i], 0);
+        g_pulse_end[i] = UINT64_MAX;
+    }
+    
+    if (triac_etm_start(g_config.triac_pins, g_config.num_triacs, g_config.zero_cross_pin) == ESP_OK) {
+        g_etm_active = true;
+        return;
+    }
+    
+    ESP_LOGW(TAG, "ETM firing unavailable, staying on the software path");
+    g_config.backend = TRIAC_BACKEND_ISR;
+    zc_tracker_init(&g_zc, g_config.zero_cross_offset_us);
+    if (start_firing_timer() == ESP_OK) {
+        gpio_intr_enable(g_config.zero_cross_pin);
+    }
+}
+
+// Credit the ETM chain's conduction since the last call (g_mutex held).
+// No interrupt sees those half-cycles, so the angle is integrated over time.
+static void account_hardware_firing(void) {
+    int64_t now = esp_timer_get_time();
+    
+    if (g_etm_active && g_etm_mask) {
+        uint64_t conducted = ((uint64_t)(now - g_etm_energy_since) * g_etm_conduction_q15) >> 15;
+        for (int i = 0; i < g_config.num_triacs; i++) {
+            if (g_etm_mask & (1u << i)) {
+                g_energy_us[i] += conducted;
+            }
+        }
+    }
+    g_etm_energy_since = now;
+}
+
+// Push the requested power to the ETM chain (called with the mutex held).
+// The chain has one angle: the mean level of the enabled channels, which
+// keeps the total output of the heater.
+static void update_hardware_firing(void) {
+    if (g_config.backend != TRIAC_BACKEND_ETM) {
+        return;
+    }
+    if (!g_etm_active) {
+        if (!zc_tracker_is_locked(&g_zc)) {
+            return;
+        }
+        start_hardware_firing();
+        if (!g_etm_active) {
+            return;
+        }
+    }
+    
+    const triac_state_t *triacs = atomic_load(&g_active_table)->triacs;
+    uint32_t mask = 0;
+    uint32_t sum = 0;
+    uint8_t count = 0;
+    for (int i = 0; i < g_config.num_triacs; i++) {
+        if (triacs[i].enabled && triacs[i].power_level > 0) {
+            mask |= 1u << i;
+            sum += triacs[i].power_level;
+            count++;
+        }
+    }
+    
+    uint32_t half_cycle = zc_tracker_half_cycle_us(&g_zc);
+    uint8_t level = count ? (sum + count / 2) / count : 0;
+    uint16_t delay = power_to_firing_delay(level, half_cycle);
+    triac_etm_plan_t plan = triac_etm_compute_plan(delay, g_config.zero_cross_offset_us, half_cycle);
+    
+    account_hardware_firing();
+    g_etm_mask = plan.fire ? mask : 0;
+    g_etm_conduction_q15 = triac_table_power_q15(delay, half_cycle);
+    
+    if (triac_etm_apply(&plan, mask) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to update ETM firing");
     }
 }
 
@@ -103,33 +626,58 @@ esp_err_t triac_control_init(const triac_config_t *config) {
     };
     gpio_config(&zc_conf);
     
-    // Install GPIO ISR service
-    gpio_install_isr_service(0);
-    gpio_isr_handler_add(config->zero_cross_pin, zero_cross_isr, NULL);
-    
-    // Configure hardware timer for phase control
-    timer_config_t timer_config = {
-        .divider = TIMER_DIVIDER,
-        .counter_dir = TIMER_COUNT_UP,
-        .counter_en = TIMER_PAUSE,
-        .alarm_en = TIMER_ALARM_EN,
-        .intr_type = TIMER_INTR_LEVEL,
-        .auto_reload = TIMER_AUTORELOAD_DIS,
+    // Hardware glitch filter ahead of both backends (the ETM chain sees raw edges)
+    gpio_flex_glitch_filter_config_t filter_config = {
+        .clk_src = GLITCH_FILTER_CLK_SRC_DEFAULT,
+        .gpio_num = config->zero_cross_pin,
+        .window_width_ns = ZC_GLITCH_WINDOW_NS,
+        .window_thres_ns = ZC_GLITCH_WINDOW_NS,
     };
-    timer_init(TIMER_GROUP, TIMER_IDX, &timer_config);
-    timer_set_counter_value(TIMER_GROUP, TIMER_IDX, 0);
-    timer_enable_intr(TIMER_GROUP, TIMER_IDX);
-    timer_isr_register(TIMER_GROUP, TIMER_IDX, timer_isr, NULL, ESP_INTR_FLAG_IRAM, NULL);
+    if (gpio_new_flex_glitch_filter(&filter_config, &g_zc_filter) != ESP_OK ||
+        gpio_glitch_filter_enable(g_zc_filter) != ESP_OK) {
+        ESP_LOGW(TAG, "Zero-cross glitch filter unavailable");
+    }
     
     // Initialize triac states
+    zc_tracker_init(&g_zc, config->zero_cross_offset_us);
+    g_timer_driven = false;
+    g_sync_deadline = UINT64_MAX;
+    g_chatter = 0;
+    g_ramp_ms = config->ramp_ms;
+    g_ramp_curve = config->ramp_curve;
+    g_stage_lead = 0;
+    g_stage_since = esp_timer_get_time();
+    firing_table_t *table = &g_tables[0];
     for (int i = 0; i < MAX_TRIACS; i++) {
-        g_triacs[i].power_level = 0;
-        g_triacs[i].firing_delay = get_half_cycle_us(config->mains_frequency);
-        g_triacs[i].enabled = false;
+        table->triacs[i].power_level = 0;
+        table->triacs[i].firing_delay = zc_tracker_half_cycle_us(&g_zc);
+        table->triacs[i].enabled = false;
+        table->triacs[i].cut = false;
+        table->triacs[i].mode = TRIAC_MODE_PHASE;
+        g_run_mode[i] = TRIAC_MODE_PHASE;
+        g_burst_error[i] = 0;
+        g_burst_gate[i] = 0;
+        g_ramp[i] = (ramp_state_t) {0};
+        g_pulse_end[i] = UINT64_MAX;
     }
+    atomic_store(&g_active_table, table);
     
-    ESP_LOGI(TAG, "Triac control initialized with %d triacs, %dHz mains", 
-             config->num_triacs, config->mains_frequency);
+    // Configure hardware timer for phase control
+    esp_err_t ret = start_firing_timer();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create firing timer");
+        vSemaphoreDelete(g_mutex);
+        g_mutex = NULL;
+        return ret;
+    }
+    
+    // Install GPIO ISR service once the time base runs
+    gpio_install_isr_service(0);
+    gpio_isr_handler_add(config->zero_cross_pin, zero_cross_isr, NULL);
+    
+    ESP_LOGI(TAG, "Triac control initialized with %d triacs, zero-cross offset %dus, %s firing", 
+             config->num_triacs, config->zero_cross_offset_us,
+             config->backend == TRIAC_BACKEND_ETM ? "ETM" : "ISR");
     
     return ESP_OK;
 }
@@ -145,9 +693,18 @@ esp_err_t triac_control_deinit(void) {
     gpio_isr_handler_remove(g_config.zero_cross_pin);
     gpio_uninstall_isr_service();
     
-    // Deinit timer
-    timer_disable_intr(TIMER_GROUP, TIMER_IDX);
-    timer_deinit(TIMER_GROUP, TIMER_IDX);
+    if (g_zc_filter) {
+        gpio_glitch_filter_disable(g_zc_filter);
+        gpio_del_glitch_filter(g_zc_filter);
+        g_zc_filter = NULL;
+    }
+    
+    // Release timers
+    if (g_etm_active) {
+        triac_etm_stop();
+        g_etm_active = false;
+    }
+    stop_firing_timer();
     
     // Delete mutex
     if (g_mutex) {
@@ -158,65 +715,125 @@ esp_err_t triac_control_deinit(void) {
     return ESP_OK;
 }
 
-uint16_t power_to_firing_delay(uint8_t power_percent, uint8_t frequency) {
-    if (power_percent >= 100) {
-        return 100;  // Minimum delay for maximum power
-    }
+uint16_t IRAM_ATTR power_to_firing_delay(uint8_t power_percent, uint32_t half_cycle_us) {
     if (power_percent == 0) {
-        return get_half_cycle_us(frequency);  // Maximum delay (no firing)
+        return half_cycle_us;  // Maximum delay (no firing)
     }
     
-    // Convert power percentage to firing angle
-    // 0% power = 180° delay, 100% power = 0° delay
-    // Using sine wave relationship for better linearity
-    float angle_rad = (1.0f - power_percent / 100.0f) * M_PI;
-    float delay_ratio = (1.0f + cos(angle_rad)) / 2.0f;
+    // Exact RMS relationship, precomputed for the nearest nominal frequency
+    // (see triac_power_table.h) and scaled to the measured half-cycle
+    uint8_t frequency = (half_cycle_us < HALF_CYCLE_SPLIT_US) ? 60 : 50;
+    uint32_t nominal = (frequency == 60) ? 8333 : 10000;
+    uint32_t delay = (triac_table_delay_us(power_percent, frequency) * half_cycle_us + nominal / 2) / nominal;
     
-    uint32_t half_cycle = get_half_cycle_us(frequency);
-    return (uint16_t)(delay_ratio * half_cycle);
+    if (delay < MIN_FIRING_DELAY_US) {
+        delay = MIN_FIRING_DELAY_US;  // Let the zero-cross pulse end before firing
+    }
+    return (uint16_t)delay;
 }
 
-uint8_t firing_delay_to_power(uint16_t delay_us, uint8_t frequency) {
-    uint32_t half_cycle = get_half_cycle_us(frequency);
-    
-    if (delay_us >= half_cycle) {
+uint8_t firing_delay_to_power(uint16_t delay_us, uint32_t half_cycle_us) {
+    if (delay_us >= half_cycle_us) {
         return 0;
     }
-    if (delay_us <= 100) {
+    if (delay_us <= MIN_FIRING_DELAY_US) {
         return 100;
     }
     
-    float delay_ratio = (float)delay_us / half_cycle;
-    float angle_rad = acos(2.0f * delay_ratio - 1.0f);
-    float power_ratio = 1.0f - (angle_rad / M_PI);
+    uint32_t power_q15 = triac_table_power_q15(delay_us, half_cycle_us);
+    return (uint8_t)((power_q15 * 100 + TRIAC_POWER_Q15_ONE / 2) / TRIAC_POWER_Q15_ONE);
+}
+
+// Set one channel's level in a table being built
+static void table_set_power(firing_table_t *table, uint8_t triac_num, uint8_t power_percent) {
+    triac_state_t *triac = &table->triacs[triac_num];
+    
+    triac->power_level = power_percent;
+    triac->firing_delay = power_to_firing_delay(power_percent, zc_tracker_half_cycle_us(&g_zc));
+    
+    // A drop to 0 leaves a cut channel cut; any other level lifts the cut
+    if (power_percent > 0) {
+        triac->enabled = true;
+        triac->cut = false;
+    } else {
+        triac->enabled = false;
+    }
+}
+
+// Enable or disable one channel in a table being built
+static void table_enable(firing_table_t *table, uint8_t triac_num, bool enable) {
+    triac_state_t *triac = &table->triacs[triac_num];
+    triac->enabled = enable && triac->power_level > 0;
+    triac->cut = !enable;
+}
+
+// Drive the gates of channels the new table cut. A drop to 0 is not a cut:
+// the ISR ramps it down like any other level change and owns the gate
+// until then.
+static void release_disabled_gates(const firing_table_t *table) {
+    for (int i = 0; i < g_config.num_triacs; i++) {
+        if (table->triacs[i].cut) {
+            gpio_set_level(g_config.triac_pins[i], 0);
+        }
+    }
+}
+
+// Split a heater-wide level across the elements of a table being built:
+// num * percent element-percent, as full elements plus one remainder
+static void table_stage_power(firing_table_t *table, uint8_t power_percent) {
+    uint8_t n = g_config.num_triacs;
+    int64_t now = esp_timer_get_time();
+    
+    if (now - g_stage_since >= (int64_t)STAGE_ROTATE_S * 1000000) {
+        g_stage_lead = (g_stage_lead + 1) % n;
+        g_stage_since = now;
+    }
     
-    return (uint8_t)(power_ratio * 100);
+    uint16_t remaining = power_percent * n;
+    for (int k = 0; k < n; k++) {
+        uint8_t level = remaining > 100 ? 100 : remaining;
+        table_set_power(table, (g_stage_lead + k) % n, level);
+        remaining -= level;
+    }
 }
 
 esp_err_t triac_control_set_power(uint8_t power_percent) {
+    return triac_control_set_power_at(power_percent, 0);
+}
+
+esp_err_t triac_control_set_power_at(uint8_t power_percent, int64_t sample_time_us) {
     if (power_percent > 100) {
         power_percent = 100;
     }
     
     xSemaphoreTake(g_mutex, portMAX_DELAY);
     
-    // Set same power for all triacs
-    for (int i = 0; i < g_config.num_triacs; i++) {
-        g_triacs[i].power_level = power_percent;
-        g_triacs[i].firing_delay = power_to_firing_delay(power_percent, g_config.mains_frequency);
-        
-        if (power_percent > 0 && !g_triacs[i].enabled) {
-            g_triacs[i].enabled = true;
-        } else if (power_percent == 0) {
-            g_triacs[i].enabled = false;
-            gpio_set_level(g_config.triac_pins[i], 0);
+    // Staged across elements, or the same power for all triacs. The ETM
+    // chain has a single angle, so it always gets the uniform split.
+    firing_table_t *table = table_begin();
+    if (g_config.staging && g_config.backend == TRIAC_BACKEND_ISR) {
+        table_stage_power(table, power_percent);
+    } else {
+        for (int i = 0; i < g_config.num_triacs; i++) {
+            table_set_power(table, i, power_percent);
+        }
+    }
+    table_publish(table);
+    release_disabled_gates(table);
+    
+    // From the sample to the table the next half-cycle fires from
+    if (sample_time_us > 0) {
+        g_sample_latency_us = (uint32_t)(esp_timer_get_time() - sample_time_us);
+        if (g_sample_latency_us > g_sample_latency_max_us) {
+            g_sample_latency_max_us = g_sample_latency_us;
         }
     }
     
+    update_hardware_firing();
     xSemaphoreGive(g_mutex);
     
     ESP_LOGD(TAG, "Power set to %d%% (delay: %dus)", 
-             power_percent, g_triacs[0].firing_delay);
+             power_percent, table->triacs[0].firing_delay);
     
     return ESP_OK;
 }
@@ -232,26 +849,27 @@ esp_err_t triac_control_set_triac_power(uint8_t triac_num, uint8_t power_percent
     
     xSemaphoreTake(g_mutex, portMAX_DELAY);
     
-    g_triacs[triac_num].power_level = power_percent;
-    g_triacs[triac_num].firing_delay = power_to_firing_delay(power_percent, g_config.mains_frequency);
-    
-    if (power_percent > 0 && !g_triacs[triac_num].enabled) {
-        g_triacs[triac_num].enabled = true;
-    } else if (power_percent == 0) {
-        g_triacs[triac_num].enabled = false;
-        gpio_set_level(g_config.triac_pins[triac_num], 0);
-    }
+    firing_table_t *table = table_begin();
+    table_set_power(table, triac_num, power_percent);
+    table_publish(table);
+    release_disabled_gates(table);
     
+    update_hardware_firing();
     xSemaphoreGive(g_mutex);
     
     return ESP_OK;
 }
 
 uint8_t triac_control_get_power(void) {
-    xSemaphoreTake(g_mutex, portMAX_DELAY);
-    uint8_t power = g_triacs[0].power_level;  // Return first triac power
-    xSemaphoreGive(g_mutex);
-    return power;
+    firing_table_t table;
+    table_snapshot(&table);
+    
+    // Heater-wide level: the mean over the elements (exact when staged)
+    uint16_t sum = 0;
+    for (int i = 0; i < g_config.num_triacs; i++) {
+        sum += table.triacs[i].power_level;
+    }
+    return g_config.num_triacs ? sum / g_config.num_triacs : 0;
 }
 
 uint8_t triac_control_get_triac_power(uint8_t triac_num) {
@@ -259,24 +877,22 @@ uint8_t triac_control_get_triac_power(uint8_t triac_num) {
         return 0;
     }
     
-    xSemaphoreTake(g_mutex, portMAX_DELAY);
-    uint8_t power = g_triacs[triac_num].power_level;
-    xSemaphoreGive(g_mutex);
-    return power;
+    firing_table_t table;
+    table_snapshot(&table);
+    return table.triacs[triac_num].power_level;
 }
 
 esp_err_t triac_control_enable(bool enable) {
     xSemaphoreTake(g_mutex, portMAX_DELAY);
     
+    firing_table_t *table = table_begin();
     for (int i = 0; i < g_config.num_triacs; i++) {
-        if (enable && g_triacs[i].power_level > 0) {
-            g_triacs[i].enabled = true;
-        } else {
-            g_triacs[i].enabled = false;
-            gpio_set_level(g_config.triac_pins[i], 0);
-        }
+        table_enable(table, i, enable);
     }
+    table_publish(table);
+    release_disabled_gates(table);
     
+    update_hardware_firing();
     xSemaphoreGive(g_mutex);
     return ESP_OK;
 }
@@ -288,45 +904,177 @@ esp_err_t triac_control_enable_triac(uint8_t triac_num, bool enable) {
     
     xSemaphoreTake(g_mutex, portMAX_DELAY);
     
-    if (enable && g_triacs[triac_num].power_level > 0) {
-        g_triacs[triac_num].enabled = true;
-    } else {
-        g_triacs[triac_num].enabled = false;
-        gpio_set_level(g_config.triac_pins[triac_num], 0);
+    firing_table_t *table = table_begin();
+    table_enable(table, triac_num, enable);
+    table_publish(table);
+    release_disabled_gates(table);
+    
+    update_hardware_firing();
+    xSemaphoreGive(g_mutex);
+    return ESP_OK;
+}
+
+esp_err_t triac_control_set_mode(uint8_t triac_num, triac_mode_t mode) {
+    if (triac_num >= g_config.num_triacs ||
+        (mode != TRIAC_MODE_PHASE && mode != TRIAC_MODE_BURST)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (mode == TRIAC_MODE_BURST && g_config.backend == TRIAC_BACKEND_ETM) {
+        return ESP_ERR_NOT_SUPPORTED;  // Needs a per-cycle decision
+    }
+    
+    xSemaphoreTake(g_mutex, portMAX_DELAY);
+    
+    firing_table_t *table = table_begin();
+    if (table->triacs[triac_num].mode != mode) {
+        // The burst state belongs to the ISR: it resets it on the next crossing
+        table->triacs[triac_num].mode = mode;
+        table_publish(table);
     }
     
     xSemaphoreGive(g_mutex);
+    
+    ESP_LOGI(TAG, "Triac %d mode: %s", triac_num,
+             mode == TRIAC_MODE_BURST ? "burst" : "phase");
     return ESP_OK;
 }
 
+esp_err_t triac_control_set_ramp(uint16_t ramp_ms, triac_ramp_curve_t curve) {
+    if (curve != TRIAC_RAMP_LINEAR && curve != TRIAC_RAMP_S_CURVE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Picked up by the next ramp segment
+    g_ramp_curve = curve;
+    g_ramp_ms = ramp_ms;
+    
+    ESP_LOGI(TAG, "Ramp: %dms full swing, %s", ramp_ms,
+             curve == TRIAC_RAMP_S_CURVE ? "S-curve" : "linear");
+    return ESP_OK;
+}
+
+triac_mode_t triac_control_get_mode(uint8_t triac_num) {
+    if (triac_num >= g_config.num_triacs) {
+        return TRIAC_MODE_PHASE;
+    }
+    
+    firing_table_t table;
+    table_snapshot(&table);
+    return table.triacs[triac_num].mode;
+}
+
+// Level the firing path applies now (%), a ramp in progress included; any
+// conduction counts as 1%. The ETM chain has no ramp: it applies the table.
+static uint8_t applied_level(const firing_table_t *table, int i) {
+    if (g_etm_active) {
+        return table->triacs[i].enabled ? table->triacs[i].power_level : 0;
+    }
+    if (table->triacs[i].cut) {
+        return 0;  // Gate off from the next half-cycle
+    }
+    uint16_t level = *(volatile uint16_t *)&g_ramp[i].level;  // One aligned read of ISR state
+    return (level + (1 << RAMP_SHIFT) - 1) >> RAMP_SHIFT;
+}
+
 bool triac_control_is_enabled(void) {
-    xSemaphoreTake(g_mutex, portMAX_DELAY);
-    bool enabled = false;
+    firing_table_t table;
+    table_snapshot(&table);
     
+    // Still firing while a drop to 0 ramps down
     for (int i = 0; i < g_config.num_triacs; i++) {
-        if (g_triacs[i].enabled) {
-            enabled = true;
-            break;
+        if (table.triacs[i].enabled || applied_level(&table, i) > 0) {
+            return true;
         }
     }
-    
-    xSemaphoreGive(g_mutex);
-    return enabled;
+    return false;
 }
 
 uint16_t triac_control_get_actual_power_watts(void) {
-    xSemaphoreTake(g_mutex, portMAX_DELAY);
+    firing_table_t table;
+    table_snapshot(&table);
     
+    // What the gates deliver, not what was commanded
     uint32_t total_power = 0;
     for (int i = 0; i < g_config.num_triacs; i++) {
-        if (g_triacs[i].enabled) {
-            total_power += (g_triacs[i].power_level * g_config.max_power_watts) / 100;
-        }
+        total_power += (applied_level(&table, i) * g_config.max_power_watts) / 100;
     }
     
     // Divide by number of triacs if they share the load
     total_power /= g_config.num_triacs;
     
-    xSemaphoreGive(g_mutex);
     return (uint16_t)total_power;
-}
\ No newline at end of file
+}
+
+uint64_t triac_control_get_energy_us(uint8_t triac_num) {
+    if (triac_num >= g_config.num_triacs) {
+        return 0;
+    }
+    
+    if (g_etm_active) {
+        xSemaphoreTake(g_mutex, portMAX_DELAY);
+        account_hardware_firing();
+        xSemaphoreGive(g_mutex);
+    }
+    
+    // The ISR may update the counter between its two 32-bit halves: read until stable
+    uint64_t energy, check;
+    do {
+        energy = g_energy_us[triac_num];
+        check = g_energy_us[triac_num];
+    } while (energy != check);
+    
+    return energy;
+}
+
+esp_err_t triac_control_get_diagnostics(triac_diagnostics_t *diag) {
+    if (!diag) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    diag->zero_crossings = g_zero_crossings;
+    diag->fired_pulses = g_fired_pulses;
+    diag->missed_alarms = g_missed_alarms;
+    diag->mains_locked = zc_tracker_is_locked(&g_zc);
+    diag->mains_frequency = g_zc.frequency;
+    diag->half_cycle_us = zc_tracker_half_cycle_us(&g_zc);
+    diag->jitter_us = g_zc.jitter_q8 >> 8;
+    diag->isr_max_cycles = g_isr_max_cycles;
+    diag->isr_max_us = g_isr_max_cycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    diag->hardware_firing = g_etm_active;
+    diag->missed_crossings = g_zc.missed;
+    diag->spurious_edges = g_zc.spurious;
+    diag->sync_losses = g_sync_losses;
+    diag->sample_latency_us = g_sample_latency_us;
+    diag->sample_latency_max_us = g_sample_latency_max_us;
+    
+    return ESP_OK;
+}
+
+esp_err_t triac_control_get_duty_report(triac_duty_report_t *report) {
+    if (!report) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    firing_table_t table;
+    table_snapshot(&table);
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed = report->time_us ? now - report->time_us : 0;
+    
+    for (int i = 0; i < g_config.num_triacs; i++) {
+        uint8_t level = table.triacs[i].enabled ? table.triacs[i].power_level : 0;
+        report->level[i] = level;
+        report->role[i] = (level == 0) ? TRIAC_ROLE_OFF :
+                          (level == 100) ? TRIAC_ROLE_FULL : TRIAC_ROLE_MODULATED;
+        
+        uint64_t energy = triac_control_get_energy_us(i);
+        uint64_t duty = 0;
+        if (elapsed > 0) {
+            duty = (energy - report->energy_us[i]) * 100 / (uint64_t)elapsed;
+        }
+        report->duty[i] = duty > 100 ? 100 : (uint8_t)duty;
+        report->energy_us[i] = energy;
+    }
+    report->time_us = now;
+    
+    return ESP_OK;
+}
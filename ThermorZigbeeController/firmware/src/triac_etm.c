@@ -0,0 +1,313 @@
+#include "triac_etm.h"
+#include "esp_log.h"
+#include "esp_etm.h"
+#include "driver/gptimer.h"
+#include "driver/gptimer_etm.h"
+#include "driver/gpio_etm.h"
+
+static const char *TAG = "TriacETM";
+
+#define TIMER_RESOLUTION_HZ 1000000 // 1 tick = 1 microsecond
+
+// Event -> task routes of the firing chain
+typedef enum {
+    ROUTE_EDGE_PHASE_ARM,
+    ROUTE_EDGE_PHASE_START,
+    ROUTE_EDGE_GATES_CLR,
+    ROUTE_PHASE_STOP,
+    ROUTE_PHASE_GATES_SET,
+    ROUTE_PHASE_PULSE_ARM,
+    ROUTE_PHASE_PULSE_START,
+    ROUTE_PULSE_STOP,
+    ROUTE_PULSE_GATES_CLR,
+    ROUTE_COUNT
+} etm_route_t;
+
+// Hardware resources
+static gptimer_handle_t g_phase_timer = NULL;
+static gptimer_handle_t g_pulse_timer = NULL;
+static esp_etm_event_handle_t g_edge_event = NULL;
+static esp_etm_event_handle_t g_phase_event = NULL;
+static esp_etm_event_handle_t g_pulse_event = NULL;
+static esp_etm_task_handle_t g_phase_arm = NULL;
+static esp_etm_task_handle_t g_phase_start = NULL;
+static esp_etm_task_handle_t g_phase_stop = NULL;
+static esp_etm_task_handle_t g_pulse_arm = NULL;
+static esp_etm_task_handle_t g_pulse_start = NULL;
+static esp_etm_task_handle_t g_pulse_stop = NULL;
+static esp_etm_task_handle_t g_gates_set = NULL;
+static esp_etm_task_handle_t g_gates_clr = NULL;
+static esp_etm_channel_handle_t g_routes[ROUTE_COUNT];
+
+static gpio_num_t g_pins[32];
+static uint8_t g_num_pins = 0;
+static uint32_t g_set_mask = 0;     // Channels currently attached to the gate tasks
+static bool g_running = false;
+
+// Timer that rests stopped at 0 and reloads to 0 on its alarm
+static esp_err_t new_oneshot_timer(uint32_t alarm_count, gptimer_handle_t *timer) {
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = TIMER_RESOLUTION_HZ,
+    };
+    esp_err_t ret = gptimer_new_timer(&timer_config, timer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    gptimer_alarm_config_t alarm_config = {
+        .alarm_count = alarm_count,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    ret = gptimer_set_alarm_action(*timer, &alarm_config);
+    if (ret == ESP_OK) {
+        ret = gptimer_enable(*timer);  // Counting is started by the matrix
+    }
+    return ret;
+}
+
+static esp_err_t new_timer_event(gptimer_handle_t timer, esp_etm_event_handle_t *event) {
+    gptimer_etm_event_config_t config = {
+        .event_type = GPTIMER_ETM_EVENT_ALARM_MATCH,
+    };
+    return gptimer_new_etm_event(timer, &config, event);
+}
+
+static esp_err_t new_timer_task(gptimer_handle_t timer, gptimer_etm_task_type_t type,
+                                esp_etm_task_handle_t *task) {
+    gptimer_etm_task_config_t config = {
+        .task_type = type,
+    };
+    return gptimer_new_etm_task(timer, &config, task);
+}
+
+// Set and clear share one GPIO channel: a pin can only belong to one
+static esp_err_t new_gates_tasks(void) {
+    gpio_etm_task_config_t config = {
+        .actions = {GPIO_ETM_TASK_ACTION_SET, GPIO_ETM_TASK_ACTION_CLR},
+    };
+    return gpio_new_etm_task(&config, &g_gates_set, &g_gates_clr);
+}
+
+static esp_err_t new_route(etm_route_t route, esp_etm_event_handle_t event, esp_etm_task_handle_t task) {
+    esp_etm_channel_config_t config = {};
+    esp_err_t ret = esp_etm_new_channel(&config, &g_routes[route]);
+    if (ret == ESP_OK) {
+        ret = esp_etm_channel_connect(g_routes[route], event, task);
+    }
+    return ret;
+}
+
+// Release whatever has been created so far
+static void release_all(void) {
+    for (int i = 0; i < ROUTE_COUNT; i++) {
+        if (g_routes[i]) {
+            esp_etm_channel_disable(g_routes[i]);
+            esp_etm_del_channel(g_routes[i]);
+            g_routes[i] = NULL;
+        }
+    }
+
+    // Pins must be detached before their task can be deleted
+    for (int i = 0; i < g_num_pins; i++) {
+        if (g_set_mask & (1u << i)) {
+            gpio_etm_task_rm_gpio(g_gates_set, g_pins[i]);
+            gpio_set_level(g_pins[i], 0);
+        }
+    }
+    g_set_mask = 0;
+
+    esp_etm_task_handle_t *tasks[] = {
+        &g_phase_arm, &g_phase_start, &g_phase_stop,
+        &g_pulse_arm, &g_pulse_start, &g_pulse_stop,
+        &g_gates_set, &g_gates_clr,
+    };
+    for (size_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); i++) {
+        if (*tasks[i]) {
+            esp_etm_del_task(*tasks[i]);
+            *tasks[i] = NULL;
+        }
+    }
+
+    esp_etm_event_handle_t *events[] = { &g_edge_event, &g_phase_event, &g_pulse_event };
+    for (size_t i = 0; i < sizeof(events) / sizeof(events[0]); i++) {
+        if (*events[i]) {
+            esp_etm_del_event(*events[i]);
+            *events[i] = NULL;
+        }
+    }
+
+    gptimer_handle_t *timers[] = { &g_phase_timer, &g_pulse_timer };
+    for (size_t i = 0; i < sizeof(timers) / sizeof(timers[0]); i++) {
+        if (*timers[i]) {
+            gptimer_stop(*timers[i]);
+            gptimer_disable(*timers[i]);
+            gptimer_del_timer(*timers[i]);
+            *timers[i] = NULL;
+        }
+    }
+}
+
+esp_err_t triac_etm_start(const gpio_num_t *triac_pins, uint8_t num_triacs, gpio_num_t zero_cross_pin) {
+    if (!triac_pins || num_triacs == 0 || num_triacs > sizeof(g_pins) / sizeof(g_pins[0])) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    for (int i = 0; i < num_triacs; i++) {
+        g_pins[i] = triac_pins[i];
+    }
+    g_num_pins = num_triacs;
+
+    // Gates stay off until the first plan is applied
+    esp_err_t ret = new_oneshot_timer(UINT16_MAX, &g_phase_timer);
+    if (ret == ESP_OK) {
+        ret = new_oneshot_timer(TRIAC_ETM_PULSE_US, &g_pulse_timer);
+    }
+
+    // Events
+    gpio_etm_event_config_t edge_config = {
+        .edge = GPIO_ETM_EVENT_EDGE_POS,
+    };
+    if (ret == ESP_OK) {
+        ret = gpio_new_etm_event(&edge_config, &g_edge_event);
+    }
+    if (ret == ESP_OK) {
+        ret = gpio_etm_event_bind_gpio(g_edge_event, zero_cross_pin);
+    }
+    if (ret == ESP_OK) {
+        ret = new_timer_event(g_phase_timer, &g_phase_event);
+    }
+    if (ret == ESP_OK) {
+        ret = new_timer_event(g_pulse_timer, &g_pulse_event);
+    }
+
+    // Tasks
+    if (ret == ESP_OK) {
+        ret = new_timer_task(g_phase_timer, GPTIMER_ETM_TASK_EN_ALARM, &g_phase_arm);
+    }
+    if (ret == ESP_OK) {
+        ret = new_timer_task(g_phase_timer, GPTIMER_ETM_TASK_START_COUNT, &g_phase_start);
+    }
+    if (ret == ESP_OK) {
+        ret = new_timer_task(g_phase_timer, GPTIMER_ETM_TASK_STOP_COUNT, &g_phase_stop);
+    }
+    if (ret == ESP_OK) {
+        ret = new_timer_task(g_pulse_timer, GPTIMER_ETM_TASK_EN_ALARM, &g_pulse_arm);
+    }
+    if (ret == ESP_OK) {
+        ret = new_timer_task(g_pulse_timer, GPTIMER_ETM_TASK_START_COUNT, &g_pulse_start);
+    }
+    if (ret == ESP_OK) {
+        ret = new_timer_task(g_pulse_timer, GPTIMER_ETM_TASK_STOP_COUNT, &g_pulse_stop);
+    }
+    if (ret == ESP_OK) {
+        ret = new_gates_tasks();
+    }
+
+    // Routes
+    if (ret == ESP_OK) {
+        ret = new_route(ROUTE_EDGE_PHASE_ARM, g_edge_event, g_phase_arm);
+    }
+    if (ret == ESP_OK) {
+        ret = new_route(ROUTE_EDGE_PHASE_START, g_edge_event, g_phase_start);
+    }
+    if (ret == ESP_OK) {
+        ret = new_route(ROUTE_EDGE_GATES_CLR, g_edge_event, g_gates_clr);
+    }
+    if (ret == ESP_OK) {
+        ret = new_route(ROUTE_PHASE_STOP, g_phase_event, g_phase_stop);
+    }
+    if (ret == ESP_OK) {
+        ret = new_route(ROUTE_PHASE_GATES_SET, g_phase_event, g_gates_set);
+    }
+    if (ret == ESP_OK) {
+        ret = new_route(ROUTE_PHASE_PULSE_ARM, g_phase_event, g_pulse_arm);
+    }
+    if (ret == ESP_OK) {
+        ret = new_route(ROUTE_PHASE_PULSE_START, g_phase_event, g_pulse_start);
+    }
+    if (ret == ESP_OK) {
+        ret = new_route(ROUTE_PULSE_STOP, g_pulse_event, g_pulse_stop);
+    }
+    if (ret == ESP_OK) {
+        ret = new_route(ROUTE_PULSE_GATES_CLR, g_pulse_event, g_gates_clr);
+    }
+
+    // Everything but the gate set route runs from the start
+    for (int i = 0; ret == ESP_OK && i < ROUTE_COUNT; i++) {
+        if (i != ROUTE_PHASE_GATES_SET) {
+            ret = esp_etm_channel_enable(g_routes[i]);
+        }
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set up the firing chain: %s", esp_err_to_name(ret));
+        release_all();
+        return ret;
+    }
+
+    g_running = true;
+    ESP_LOGI(TAG, "Hardware firing chain running on %d channels", num_triacs);
+    return ESP_OK;
+}
+
+esp_err_t triac_etm_apply(const triac_etm_plan_t *plan, uint32_t channel_mask) {
+    if (!plan) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!g_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Detach the gates while the alarm moves: an alarm set below a running
+    // count matches at once, and must not fire mid half-cycle
+    esp_etm_channel_disable(g_routes[ROUTE_PHASE_GATES_SET]);
+
+    for (int i = 0; i < g_num_pins; i++) {
+        uint32_t bit = 1u << i;
+        if ((channel_mask & bit) && !(g_set_mask & bit)) {
+            gpio_etm_task_add_gpio(g_gates_set, g_pins[i]);
+        } else if (!(channel_mask & bit) && (g_set_mask & bit)) {
+            gpio_etm_task_rm_gpio(g_gates_set, g_pins[i]);
+            gpio_set_level(g_pins[i], 0);  // Detached pins are driven by software
+        }
+    }
+    g_set_mask = channel_mask & ((1u << g_num_pins) - 1);
+
+    if (!plan->fire || g_set_mask == 0) {
+        return ESP_OK;
+    }
+
+    gptimer_alarm_config_t alarm_config = {
+        .alarm_count = plan->phase_alarm,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    esp_err_t ret = gptimer_set_alarm_action(g_phase_timer, &alarm_config);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    return esp_etm_channel_enable(g_routes[ROUTE_PHASE_GATES_SET]);
+}
+
+esp_err_t triac_etm_stop(void) {
+    if (!g_running) {
+        return ESP_OK;
+    }
+
+    release_all();
+    g_running = false;
+
+    ESP_LOGI(TAG, "Hardware firing chain stopped");
+    return ESP_OK;
+}
+
+bool triac_etm_is_running(void) {
+    return g_running;
+}
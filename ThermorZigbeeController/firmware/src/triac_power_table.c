@@ -0,0 +1,47 @@
+// Generated by scripts/gen_triac_power_table.py - do not edit.
+// P(a) = 1 - a/pi + sin(2a)/(2*pi), a = firing angle
+
+#include "triac_power_table.h"
+
+// Firing delay (us) for 0..100% power, 50Hz mains (10000us half-cycle)
+const uint16_t DRAM_ATTR triac_delay_50hz_us[TRIAC_POWER_STEPS + 1] = {
+    10000,  8840,  8531,  8310,  8132,  7980,  7846,  7724,  7612,  7508,
+     7411,  7319,  7231,  7147,  7067,  6990,  6915,  6842,  6772,  6704,
+     6637,  6572,  6508,  6445,  6384,  6324,  6264,  6206,  6149,  6092,
+     6036,  5980,  5926,  5871,  5818,  5765,  5712,  5659,  5607,  5556,
+     5504,  5453,  5402,  5351,  5301,  5251,  5200,  5150,  5100,  5050,
+     5000,  4950,  4900,  4850,  4800,  4749,  4699,  4649,  4598,  4547,
+     4496,  4444,  4393,  4341,  4288,  4235,  4182,  4129,  4074,  4020,
+     3964,  3908,  3851,  3794,  3736,  3676,  3616,  3555,  3492,  3428,
+     3363,  3296,  3228,  3158,  3085,  3010,  2933,  2853,  2769,  2681,
+     2589,  2492,  2388,  2276,  2154,  2020,  1868,  1690,  1469,  1160,
+        0,
+};
+
+// Firing delay (us) for 0..100% power, 60Hz mains (8333us half-cycle)
+const uint16_t DRAM_ATTR triac_delay_60hz_us[TRIAC_POWER_STEPS + 1] = {
+     8333,  7367,  7109,  6925,  6777,  6650,  6538,  6437,  6344,  6257,
+     6176,  6099,  6026,  5956,  5889,  5825,  5762,  5702,  5643,  5586,
+     5531,  5476,  5423,  5371,  5320,  5270,  5220,  5172,  5124,  5077,
+     5030,  4984,  4938,  4893,  4848,  4804,  4760,  4716,  4673,  4630,
+     4587,  4544,  4502,  4460,  4417,  4375,  4334,  4292,  4250,  4208,
+     4167,  4125,  4083,  4042,  4000,  3958,  3916,  3874,  3832,  3789,
+     3747,  3704,  3661,  3617,  3574,  3530,  3485,  3440,  3395,  3350,
+     3304,  3257,  3210,  3162,  3113,  3064,  3013,  2962,  2910,  2857,
+     2803,  2747,  2690,  2631,  2571,  2509,  2444,  2377,  2307,  2234,
+     2158,  2076,  1990,  1896,  1795,  1683,  1556,  1408,  1224,   967,
+        0,
+};
+
+// Relative power (Q15) at angle pi * i / TRIAC_ANGLE_SEGMENTS
+const uint16_t DRAM_ATTR triac_power_by_angle_q15[TRIAC_ANGLE_SEGMENTS + 1] = {
+    32768, 32767, 32761, 32746, 32716, 32666, 32593, 32492,
+    32360, 32191, 31984, 31735, 31442, 31103, 30715, 30278,
+    29791, 29254, 28667, 28031, 27346, 26615, 25840, 25023,
+    24168, 23276, 22353, 21402, 20428, 19434, 18425, 17407,
+    16384, 15361, 14343, 13334, 12340, 11366, 10415,  9492,
+     8600,  7745,  6928,  6153,  5422,  4737,  4101,  3514,
+     2977,  2490,  2053,  1665,  1326,  1033,   784,   577,
+      408,   276,   175,   102,    52,    22,     7,     1,
+        0,
+};
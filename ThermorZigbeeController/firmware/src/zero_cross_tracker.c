@@ -0,0 +1,150 @@
+#include "zero_cross_tracker.h"
+#include <string.h>
+
+// Loop gains as divisors: phase Kp = 1/4, period Ki = 1/32.
+// Closed-loop poles at |z| = 0.87, settling in ~8 half-cycles.
+#define PLL_PHASE_DIV       4
+#define PLL_PERIOD_DIV      32
+#define JITTER_SHIFT        4       // Jitter averaging over 16 crossings
+#define ACQ_TOLERANCE_SHIFT 4       // Lock intervals must agree within 1/16
+#define WINDOW_SHIFT        3       // Acceptance window: period / 8
+#define FREQ_SPLIT_US       9100    // Half-cycle boundary between 60Hz and 50Hz
+
+static inline int32_t ZC_TRACKER_ATTR abs32(int32_t v) {
+    return v < 0 ? -v : v;
+}
+
+static void ZC_TRACKER_ATTR restart_acquisition(zc_tracker_t *t) {
+    t->state = ZC_STATE_SEARCHING;
+    t->acq_last_edge = 0;
+    t->acq_first = 0;
+    t->acq_sum = 0;
+    t->acq_count = 0;
+    t->coasted = 0;
+}
+
+void zc_tracker_init(zc_tracker_t *t, int32_t offset_us) {
+    memset(t, 0, sizeof(*t));
+    t->offset_us = offset_us;
+    t->period_q8 = 10000u << 8;
+    restart_acquisition(t);
+}
+
+// Drop the lock and acquire again, keeping offset and counters
+void ZC_TRACKER_ATTR zc_tracker_resync(zc_tracker_t *t) {
+    restart_acquisition(t);
+}
+
+// Measure raw edge intervals until ZC_LOCK_EDGES consecutive ones agree
+static zc_edge_result_t ZC_TRACKER_ATTR acquire(zc_tracker_t *t, uint64_t edge_time) {
+    if (t->acq_last_edge == 0) {
+        t->acq_last_edge = edge_time;
+        return ZC_EDGE_ACQUIRING;
+    }
+
+    uint32_t interval = (uint32_t)(edge_time - t->acq_last_edge);
+    t->acq_last_edge = edge_time;
+
+    if (interval < ZC_MIN_HALF_CYCLE_US || interval > ZC_MAX_HALF_CYCLE_US) {
+        t->acq_count = 0;
+        return ZC_EDGE_ACQUIRING;
+    }
+    if (t->acq_count == 0 ||
+        abs32((int32_t)interval - (int32_t)t->acq_first) > (int32_t)(t->acq_first >> ACQ_TOLERANCE_SHIFT)) {
+        t->acq_first = interval;
+        t->acq_sum = 0;
+        t->acq_count = 0;
+    }
+    t->acq_sum += interval;
+    t->acq_count++;
+
+    if (t->acq_count < ZC_LOCK_EDGES) {
+        return ZC_EDGE_ACQUIRING;
+    }
+
+    // Lock: seed the loop with the mean interval and this edge's crossing
+    t->period_q8 = (t->acq_sum << 8) / t->acq_count;
+    t->frequency = (t->acq_sum / t->acq_count < FREQ_SPLIT_US) ? 60 : 50;
+    t->jitter_q8 = 0;
+    t->last = edge_time + t->offset_us;
+    t->last_matched = true;
+    t->next = t->last + (t->period_q8 >> 8);
+    t->next_matched = false;
+    t->coasted = 0;
+    t->state = ZC_STATE_LOCKED;
+    return ZC_EDGE_LOCKED;
+}
+
+// Apply one phase error measurement to the period and jitter estimates
+static void ZC_TRACKER_ATTR correct_period(zc_tracker_t *t, int32_t error) {
+    int32_t period = (int32_t)t->period_q8 + (error * 256) / PLL_PERIOD_DIV;
+
+    if (period < (ZC_MIN_HALF_CYCLE_US << 8)) {
+        period = ZC_MIN_HALF_CYCLE_US << 8;
+    } else if (period > (ZC_MAX_HALF_CYCLE_US << 8)) {
+        period = ZC_MAX_HALF_CYCLE_US << 8;
+    }
+    t->period_q8 = (uint32_t)period;
+
+    int32_t jitter = (int32_t)t->jitter_q8;
+    jitter += ((abs32(error) << 8) - jitter) >> JITTER_SHIFT;
+    t->jitter_q8 = (uint32_t)jitter;
+}
+
+zc_edge_result_t ZC_TRACKER_ATTR zc_tracker_edge(zc_tracker_t *t, uint64_t edge_time) {
+    if (t->state != ZC_STATE_LOCKED) {
+        return acquire(t, edge_time);
+    }
+
+    uint64_t crossing = edge_time + t->offset_us;
+    int32_t window = (int32_t)(t->period_q8 >> (8 + WINDOW_SHIFT));
+
+    // Nobody advanced past crossings that went by without an edge
+    while (t->state == ZC_STATE_LOCKED && crossing > t->next + window) {
+        zc_tracker_advance(t);
+    }
+    if (t->state != ZC_STATE_LOCKED) {
+        return acquire(t, edge_time);
+    }
+
+    int32_t to_next = (int32_t)(int64_t)(crossing - t->next);
+    int32_t to_last = (int32_t)(int64_t)(crossing - t->last);
+
+    if (!t->next_matched && abs32(to_next) <= window) {
+        t->next += to_next / PLL_PHASE_DIV;
+        t->next_matched = true;
+        correct_period(t, to_next);
+        return ZC_EDGE_NEXT;
+    }
+
+    if (!t->last_matched && abs32(to_last) <= window) {
+        t->last += to_last / PLL_PHASE_DIV;
+        t->last_matched = true;
+        correct_period(t, to_last);
+        t->next = t->last + (t->period_q8 >> 8);
+        return ZC_EDGE_LAST;
+    }
+
+    t->spurious++;
+    return ZC_EDGE_REJECTED;
+}
+
+uint64_t ZC_TRACKER_ATTR zc_tracker_advance(zc_tracker_t *t) {
+    // The crossing being left has closed its acceptance window
+    if (t->last_matched) {
+        t->coasted = 0;
+    } else {
+        t->coasted++;
+        t->missed++;
+    }
+
+    t->last = t->next;
+    t->last_matched = t->next_matched;
+    t->next = t->last + (t->period_q8 >> 8);
+    t->next_matched = false;
+
+    if (t->coasted > ZC_COAST_LIMIT) {
+        restart_acquisition(t);
+    }
+    return t->last;
+}
@@ -84,6 +84,22 @@ static esp_zb_cluster_list_t *create_thermostat_cluster_list(zigbee_thermostat_t
     };
     esp_zb_attribute_list_t *power_cluster = esp_zb_power_config_cluster_create(&power_cfg);
     
+    // Metering cluster: delivered energy in Wh (kWh with a divisor of 1000)
+    esp_zb_metering_cluster_cfg_t metering_cfg = {
+        .current_summation_delivered = {0},
+        .status = 0,
+        .uint_of_measure = ESP_ZB_ZCL_METERING_UNIT_KW_KWH_BINARY,
+        .summation_formatting = 0x33,  // 3 decimals
+        .metering_device_type = ESP_ZB_ZCL_METERING_ELECTRIC_METERING,
+    };
+    esp_zb_attribute_list_t *metering_cluster = esp_zb_metering_cluster_create(&metering_cfg);
+    uint32_t metering_multiplier = 1;
+    uint32_t metering_divisor = 1000;
+    esp_zb_metering_cluster_add_attr(metering_cluster, ESP_ZB_ZCL_ATTR_METERING_MULTIPLIER_ID,
+                                     &metering_multiplier);
+    esp_zb_metering_cluster_add_attr(metering_cluster, ESP_ZB_ZCL_ATTR_METERING_DIVISOR_ID,
+                                     &metering_divisor);
+    
     // Add clusters to list
     ESP_ERROR_CHECK(esp_zb_cluster_list_add_basic_cluster(cluster_list, basic_cluster, 
                     ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
@@ -95,6 +111,8 @@ static esp_zb_cluster_list_t *create_thermostat_cluster_list(zigbee_thermostat_t
                     ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
     ESP_ERROR_CHECK(esp_zb_cluster_list_add_power_config_cluster(cluster_list, power_cluster, 
                     ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+    ESP_ERROR_CHECK(esp_zb_cluster_list_add_metering_cluster(cluster_list, metering_cluster, 
+                    ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
     
     return cluster_list;
 }
@@ -395,6 +413,27 @@ esp_err_t zigbee_thermostat_update_mode(zigbee_thermostat_t *device, thermor_mod
     return ESP_OK;
 }
 
+esp_err_t zigbee_thermostat_update_energy(zigbee_thermostat_t *device, uint32_t energy_wh) {
+    if (!device || !device->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    device->custom.energy_consumption = energy_wh;
+    
+    esp_zb_uint48_t summation = {
+        .low = energy_wh,
+        .high = 0,
+    };
+    esp_zb_zcl_set_attribute_val(device->endpoint,
+                                ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                                ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID,
+                                &summation,
+                                false);
+    
+    return ESP_OK;
+}
+
 void zigbee_thermostat_factory_reset(void) {
     ESP_LOGI(TAG, "Performing factory reset");
     esp_zb_factory_reset();
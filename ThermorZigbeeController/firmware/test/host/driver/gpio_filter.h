@@ -0,0 +1,36 @@
+// Host stand-in for driver/gpio_filter.h: no glitch filter off target
+#ifndef HOST_DRIVER_GPIO_FILTER_H
+#define HOST_DRIVER_GPIO_FILTER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+typedef struct gpio_glitch_filter_t *gpio_glitch_filter_handle_t;
+
+typedef enum {
+    GLITCH_FILTER_CLK_SRC_DEFAULT
+} glitch_filter_clock_source_t;
+
+typedef struct {
+    glitch_filter_clock_source_t clk_src;
+    gpio_num_t gpio_num;
+    uint32_t window_width_ns;
+    uint32_t window_thres_ns;
+} gpio_flex_glitch_filter_config_t;
+
+static inline esp_err_t gpio_new_flex_glitch_filter(const gpio_flex_glitch_filter_config_t *config,
+                                                    gpio_glitch_filter_handle_t *ret_filter) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+static inline esp_err_t gpio_glitch_filter_enable(gpio_glitch_filter_handle_t filter) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+static inline esp_err_t gpio_glitch_filter_disable(gpio_glitch_filter_handle_t filter) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+static inline esp_err_t gpio_del_glitch_filter(gpio_glitch_filter_handle_t filter) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // HOST_DRIVER_GPIO_FILTER_H
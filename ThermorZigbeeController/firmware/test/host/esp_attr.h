@@ -0,0 +1,8 @@
+// Host stand-in for esp_attr.h: placement attributes mean nothing off target
+#ifndef HOST_ESP_ATTR_H
+#define HOST_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#endif // HOST_ESP_ATTR_H
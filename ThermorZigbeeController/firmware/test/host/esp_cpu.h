@@ -0,0 +1,9 @@
+// Host stand-in for esp_cpu.h: the test provides the cycle counter
+#ifndef HOST_ESP_CPU_H
+#define HOST_ESP_CPU_H
+
+#include <stdint.h>
+
+uint32_t esp_cpu_get_cycle_count(void);
+
+#endif // HOST_ESP_CPU_H
@@ -0,0 +1,9 @@
+// Host stand-in for esp_timer.h: the test provides the time base
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
+
+#endif // HOST_ESP_TIMER_H
@@ -0,0 +1,23 @@
+// Host stand-in for FreeRTOS semphr.h. Host tests run on one thread, so
+// a mutex never blocks.
+#ifndef HOST_FREERTOS_SEMPHR_H
+#define HOST_FREERTOS_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    static int mutex;
+    return &mutex;
+}
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks) {
+    return pdTRUE;
+}
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+    return pdTRUE;
+}
+static inline void vSemaphoreDelete(SemaphoreHandle_t mutex) {
+}
+
+#endif // HOST_FREERTOS_SEMPHR_H
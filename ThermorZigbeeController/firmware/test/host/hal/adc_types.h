@@ -0,0 +1,22 @@
+// Host stand-in for hal/adc_types.h, for building pure modules off target
+#ifndef HOST_HAL_ADC_TYPES_H
+#define HOST_HAL_ADC_TYPES_H
+
+typedef enum {
+    ADC_CHANNEL_0,
+    ADC_CHANNEL_1,
+    ADC_CHANNEL_2,
+    ADC_CHANNEL_3,
+    ADC_CHANNEL_4,
+    ADC_CHANNEL_5,
+    ADC_CHANNEL_6
+} adc_channel_t;
+
+typedef enum {
+    ADC_ATTEN_DB_0,
+    ADC_ATTEN_DB_2_5,
+    ADC_ATTEN_DB_6,
+    ADC_ATTEN_DB_12
+} adc_atten_t;
+
+#endif // HOST_HAL_ADC_TYPES_H
@@ -0,0 +1,12 @@
+// Host NVS with no storage behind it: every access fails, so nothing a
+// module tries to persist or restore survives. Linked by the host builds
+// that do not check persistence; the others provide their own storage.
+#include "nvs.h"
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) { return ESP_FAIL; }
+void nvs_close(nvs_handle_t handle) {}
+esp_err_t nvs_commit(nvs_handle_t handle) { return ESP_FAIL; }
+esp_err_t nvs_set_u64(nvs_handle_t handle, const char *key, uint64_t value) { return ESP_FAIL; }
+esp_err_t nvs_get_u64(nvs_handle_t handle, const char *key, uint64_t *out_value) { return ESP_FAIL; }
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) { return ESP_FAIL; }
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) { return ESP_FAIL; }
@@ -0,0 +1,7 @@
+// Host stand-in for the generated sdkconfig.h (ESP32-C6 defaults)
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ 160
+
+#endif // HOST_SDKCONFIG_H
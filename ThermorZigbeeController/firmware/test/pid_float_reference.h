@@ -0,0 +1,57 @@
+// Float PID reference shared by the fixed-point PID test and benchmark
+#ifndef PID_FLOAT_REFERENCE_H
+#define PID_FLOAT_REFERENCE_H
+
+#include <string.h>
+#include "pid_controller.h"
+
+// The float controller the fixed-point one replaced, with dt = sample time
+typedef struct {
+    pid_config_t config;
+    float integral;
+    float last_input;
+    bool first_run;
+} float_pid_t;
+
+static inline void float_pid_init(float_pid_t *pid, const pid_config_t *config) {
+    memset(pid, 0, sizeof(*pid));
+    pid->config = *config;
+    pid->first_run = true;
+}
+
+static inline float float_pid_compute(float_pid_t *pid, float setpoint, float input) {
+    float dt = pid->config.sample_time_ms / 1000.0f;
+    float error = setpoint - input;
+    float p_term = pid->config.kp * error;
+
+    pid->integral += error * dt;
+    float integral_limit = pid->config.output_max / pid->config.ki;
+    if (pid->integral > integral_limit) {
+        pid->integral = integral_limit;
+    } else if (pid->integral < -integral_limit) {
+        pid->integral = -integral_limit;
+    }
+    float i_term = pid->config.ki * pid->integral;
+
+    float d_input = pid->first_run ? 0.0f : (input - pid->last_input) / dt;
+    float d_term = -pid->config.kd * d_input;
+
+    float output = p_term + i_term + d_term;
+    if (output > pid->config.output_max) {
+        output = pid->config.output_max;
+        if (pid->config.ki != 0) {
+            pid->integral = (output - p_term - d_term) / pid->config.ki;
+        }
+    } else if (output < pid->config.output_min) {
+        output = pid->config.output_min;
+        if (pid->config.ki != 0) {
+            pid->integral = (output - p_term - d_term) / pid->config.ki;
+        }
+    }
+
+    pid->last_input = input;
+    pid->first_run = false;
+    return output;
+}
+
+#endif // PID_FLOAT_REFERENCE_H
@@ -0,0 +1,271 @@
+/**
+ * Host test for cascade control with the heater surface limit
+ * Two-node plant: the heater body warms from the element and gives its
+ * heat to the room, the room loses heat to the outside. Compares a warm-up
+ * under the single room loop and under the cascade, then checks that the
+ * surface never passes the ceiling and that a faulty surface NTC cuts the
+ * power, both fed straight in and read through temperature_sensor_read
+ * from a shorted, open or out-of-range divider.
+ *
+ * Build and run from firmware/:
+ *   gcc -Iinclude -Itest/host test/test_cascade_control.c src/cascade_control.c src/pid_controller.c \
+ *       src/temperature_sensor.c src/ntc_table.c src/ntc_table_default.c src/sensor_filter.c src/pt1000.c \
+ *       test/host/nvs_stub.c -lm -o /tmp/test_cascade_control
+ *   /tmp/test_cascade_control
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+#include "cascade_control.h"
+#include "temperature_sensor.h"
+#include "adc_sampler.h"
+#include "ds18b20.h"
+#include "esp_timer.h"
+
+#define HEATER_WATTS        2000.0
+#define BODY_J_PER_K        2700.0  // 3 kg of aluminium
+#define BODY_W_PER_K        20.0    // Body to room
+#define ROOM_J_PER_K        180000.0
+#define ROOM_W_PER_K        50.0    // Room to outside
+#define OUTSIDE             5.0
+#define ROOM_DELAY_S        60      // Warm air reaching the room sensor
+#define CEILING             80.0f
+#define OVERSHOOT_LIMIT     0.3
+
+static int failures = 0;
+
+// The surface NTC's divider, as the sampler would report it
+static uint32_t adc_mv = 0;
+static int64_t now_us = 0;
+
+esp_err_t adc_sampler_add_channel(adc_channel_t channel) { return ESP_OK; }
+esp_err_t adc_sampler_get_mv(adc_channel_t channel, uint32_t *mv) { *mv = adc_mv; return ESP_OK; }
+esp_err_t ds18b20_start(gpio_num_t pin) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t ds18b20_get(uint8_t index, float *celsius) { return ESP_ERR_INVALID_STATE; }
+int64_t esp_timer_get_time(void) { return now_us; }
+const char *esp_err_to_name(esp_err_t code) { return "error"; }
+
+typedef struct {
+    double body;
+    double room;
+    float room_history[ROOM_DELAY_S];
+    int head;
+} plant_t;
+
+static void plant_init(plant_t *plant, double temperature) {
+    plant->body = temperature;
+    plant->room = temperature;
+    for (int i = 0; i < ROOM_DELAY_S; i++) {
+        plant->room_history[i] = (float)temperature;
+    }
+    plant->head = 0;
+}
+
+// One second at the given power (%)
+static void plant_step(plant_t *plant, float power) {
+    double to_room = BODY_W_PER_K * (plant->body - plant->room);
+    plant->body += (HEATER_WATTS * power / 100.0 - to_room) / BODY_J_PER_K;
+    plant->room += (to_room - ROOM_W_PER_K * (plant->room - OUTSIDE)) / ROOM_J_PER_K;
+    plant->room_history[plant->head] = (float)(round(plant->room * 100.0) / 100.0);
+    plant->head = (plant->head + 1) % ROOM_DELAY_S;
+}
+
+static float room_sensor(const plant_t *plant) {
+    return plant->room_history[plant->head];
+}
+
+static float surface_sensor(const plant_t *plant) {
+    return (float)(round(plant->body * 10.0) / 10.0);
+}
+
+static const cascade_config_t cascade_config = {
+    .outer = { .kp = 80.0f, .ki = 0.2f, .kd = 0.0f,
+               .output_min = 0.0f, .output_max = 100.0f, .sample_time_ms = 5000 },
+    .inner = { .kp = 8.0f, .ki = 0.1f, .kd = 0.0f,
+               .output_min = 0.0f, .output_max = 100.0f, .sample_time_ms = 1000 },
+    .surface_ceiling = CEILING,
+};
+
+typedef struct {
+    double overshoot;
+    int reach_s;             // First time within 0.2 of the setpoint
+    double body_max;
+} warmup_t;
+
+// Settle at the starting setpoint, then step to 20
+static void warmup(bool cascade_mode, float from, warmup_t *result) {
+    const pid_config_t single = {
+        .kp = 25.0f, .ki = 0.01f, .kd = 0.0f,
+        .output_min = 0.0f, .output_max = 100.0f, .sample_time_ms = 1000,
+    };
+    pid_controller_t pid;
+    cascade_controller_t cascade;
+    plant_t plant;
+
+    pid_controller_init(&pid, &single);
+    cascade_controller_init(&cascade, &cascade_config);
+    plant_init(&plant, from);
+    memset(result, 0, sizeof(*result));
+    result->reach_s = -1;
+
+    for (int s = 0; s < 4 * 3600; s++) {
+        float power = cascade_mode
+            ? cascade_controller_compute(&cascade, from, room_sensor(&plant), surface_sensor(&plant))
+            : pid_controller_compute(&pid, from, room_sensor(&plant));
+        plant_step(&plant, (float)(int)power);
+    }
+    for (int s = 0; s < 6 * 3600; s++) {
+        float power = cascade_mode
+            ? cascade_controller_compute(&cascade, 20.0f, room_sensor(&plant), surface_sensor(&plant))
+            : pid_controller_compute(&pid, 20.0f, room_sensor(&plant));
+        plant_step(&plant, (float)(int)power);
+
+        if (plant.room - 20.0 > result->overshoot) {
+            result->overshoot = plant.room - 20.0;
+        }
+        if (result->reach_s < 0 && plant.room > 19.8) {
+            result->reach_s = s;
+        }
+        if (plant.body > result->body_max) {
+            result->body_max = plant.body;
+        }
+    }
+}
+
+static void check_warmup(float from) {
+    warmup_t single, cascade;
+    warmup(false, from, &single);
+    warmup(true, from, &cascade);
+
+    printf("Single loop: %.0f->20C in %d min, overshoot %.2f, heater body up to %.1fC\n",
+           from, single.reach_s / 60, single.overshoot, single.body_max);
+    printf("Cascade:     %.0f->20C in %d min, overshoot %.2f, heater body up to %.1fC\n",
+           from, cascade.reach_s / 60, cascade.overshoot, cascade.body_max);
+
+    // No slower, no more overshoot, and the body kept below the ceiling
+    if (cascade.reach_s < 0 || cascade.reach_s > single.reach_s * 3 / 2 ||
+        cascade.overshoot > OVERSHOOT_LIMIT || cascade.overshoot > single.overshoot + 0.02 ||
+        cascade.body_max > CEILING) {
+        printf("FAIL cascade warm-up: reached at %d s, overshoot %.2f, body %.1f\n",
+               cascade.reach_s, cascade.overshoot, cascade.body_max);
+        failures++;
+    }
+}
+
+// A cold room asks for all the power; the body must stop at the ceiling
+static void check_ceiling(void) {
+    cascade_config_t config = cascade_config;
+    cascade_controller_t cascade;
+    plant_t plant;
+    double body_max = 0.0;
+
+    config.surface_ceiling = 50.0f;
+    cascade_controller_init(&cascade, &config);
+    plant_init(&plant, 5.0);
+    for (int s = 0; s < 4 * 3600; s++) {
+        float power = cascade_controller_compute(&cascade, 22.0f, room_sensor(&plant), surface_sensor(&plant));
+        plant_step(&plant, (float)(int)power);
+        if (plant.body > body_max) {
+            body_max = plant.body;
+        }
+    }
+
+    printf("Ceiling 50C from a cold room: body up to %.1fC, %" PRIu32 " trips\n", body_max, cascade.trips);
+    if (body_max > config.surface_ceiling) {
+        printf("FAIL ceiling: body reached %.1fC\n", body_max);
+        failures++;
+    }
+}
+
+// An open or shorted surface NTC cuts the power until it reads sensibly again
+static void check_sensor_fault(void) {
+    cascade_controller_t cascade;
+    cascade_controller_init(&cascade, &cascade_config);
+
+    float power = cascade_controller_compute(&cascade, 20.0f, 15.0f, -60.0f);
+    float again = cascade_controller_compute(&cascade, 20.0f, 15.0f, NAN);
+    if (power != 0.0f || again != 0.0f || !cascade.tripped || cascade.trips != 1) {
+        printf("FAIL sensor fault: power %.1f/%.1f, tripped %d, trips %" PRIu32 "\n",
+               power, again, cascade.tripped, cascade.trips);
+        failures++;
+    }
+
+    power = cascade_controller_compute(&cascade, 20.0f, 15.0f, 30.0f);
+    if (power <= 0.0f || cascade.tripped) {
+        printf("FAIL sensor recovery: power %.1f, tripped %d\n", power, cascade.tripped);
+        failures++;
+    }
+    printf("Surface sensor fault: checked\n");
+}
+
+// Same, from the divider voltage: a sensor that fails mid-run must not
+// leave its last good reading (70C, under the ceiling) in the loop
+static void check_sensor_read_fault(void) {
+    temp_sensor_config_t config = {
+        .adc_channel = ADC_CHANNEL_1,
+        .sensor_type = TEMP_SENSOR_NTC_100K,
+        .beta = NTC_DEFAULT_BETA,
+        .r_nominal = 100000,
+        .t_nominal = NTC_DEFAULT_T_NOMINAL,
+        .r_series = 100000
+    };
+    static const sensor_filter_stage_config_t median = { .type = SENSOR_FILTER_MEDIAN, .window = 3 };
+    struct {
+        const char *name;
+        uint32_t mv;
+    } faults[] = {
+        { "shorted", 0 },
+        { "near short", NTC_TABLE_FAULT_MV - 5 },
+        { "above 150C", 60 },
+        { "open", NTC_TABLE_SUPPLY_MV - 5 },
+    };
+    temp_sensor_t sensor;
+    cascade_controller_t cascade;
+
+    if (temperature_sensor_init(&sensor, &config) != ESP_OK ||
+        temperature_sensor_set_filter_chain(&sensor, &median, 1) != ESP_OK) {
+        printf("FAIL sensor read fault: init\n");
+        failures++;
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(faults) / sizeof(faults[0]); i++) {
+        cascade_controller_init(&cascade, &cascade_config);
+
+        // Settle on a good reading first
+        adc_mv = 500;
+        float good = 0.0f;
+        for (int n = 0; n < 3; n++, now_us += 100000) {
+            good = temperature_sensor_read_filtered(&sensor);
+        }
+        float power = cascade_controller_compute(&cascade, 20.0f, 15.0f, good);
+
+        adc_mv = faults[i].mv;
+        float raw = temperature_sensor_read(&sensor);
+        float filtered = temperature_sensor_read_filtered(&sensor);
+        float cut = cascade_controller_compute(&cascade, 20.0f, 15.0f, filtered);
+
+        printf("Surface NTC %s at %" PRIu32 " mV after %.1fC: read %.2f/%.2f, power %.1f -> %.1f\n",
+               faults[i].name, faults[i].mv, good, raw, filtered, power, cut);
+        if (good < 60.0f || good > CEILING || power <= 0.0f ||
+            raw != -273.15f || filtered != -273.15f || cut != 0.0f || !cascade.tripped) {
+            printf("FAIL sensor read fault: %s\n", faults[i].name);
+            failures++;
+        }
+    }
+    temperature_sensor_deinit(&sensor);
+}
+
+int main(void) {
+    check_warmup(19.0f);
+    check_warmup(15.0f);
+    check_ceiling();
+    check_sensor_fault();
+    check_sensor_read_fault();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,145 @@
+/**
+ * Host test for the NTC conversion tables
+ * Checks the generated flash table and RAM-built tables for other curves
+ * against the exact divider and beta equations at every whole mV over
+ * -40..120C, and the table selection when the parameters change.
+ *
+ * Build and run from firmware/:
+ *   gcc -Iinclude -Itest/host test/test_ntc_table.c src/ntc_table.c src/ntc_table_default.c -lm -o /tmp/test_ntc_table
+ *   /tmp/test_ntc_table
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include "ntc_table.h"
+
+#define TABLE_TOLERANCE_C   0.005   // Rounding of the entries
+#define TOLERANCE_C         0.05    // Interpolated against exact
+#define SWEEP_MIN_C         -40.0
+#define SWEEP_MAX_C         120.0
+
+static int failures = 0;
+
+// Exact temperature for a divider voltage
+static double exact_temperature(double mv, double beta, double r_nominal,
+                                double t_nominal, double r_series) {
+    double r = r_series * mv / (NTC_TABLE_SUPPLY_MV - mv);
+    return 1.0 / (1.0 / (t_nominal + 273.15) + log(r / r_nominal) / beta) - 273.15;
+}
+
+static void check_entries(void) {
+    int checked = 0;
+    for (int i = 1; i < NTC_TABLE_SIZE - 1; i++) {
+        double exact = exact_temperature(i * NTC_TABLE_STEP_MV, NTC_DEFAULT_BETA, 1.0,
+                                         NTC_DEFAULT_T_NOMINAL, NTC_DEFAULT_SERIES_RATIO);
+        if (exact * 100.0 < NTC_TABLE_MIN_CENTI || exact * 100.0 > NTC_TABLE_MAX_CENTI) {
+            continue;  // Clamped
+        }
+        if (fabs(ntc_default_centi[i] / 100.0 - exact) > TABLE_TOLERANCE_C) {
+            printf("FAIL entry %d: %d, expected %.3fC\n", i, ntc_default_centi[i], exact);
+            failures++;
+        }
+        checked++;
+    }
+    printf("Flash table: %d entries checked\n", checked);
+}
+
+static void check_sweep(const char *name, float beta, float r_nominal, float t_nominal, float r_series) {
+    ntc_table_t table = {0};
+    if (ntc_table_build(&table, beta, r_nominal, t_nominal, r_series) != ESP_OK) {
+        printf("FAIL %s: build\n", name);
+        failures++;
+        return;
+    }
+
+    double worst = 0.0, worst_at = 0.0;
+    for (uint32_t mv = 1; mv < NTC_TABLE_SUPPLY_MV; mv++) {
+        double exact = exact_temperature(mv, beta, r_nominal, t_nominal, r_series);
+        if (exact < SWEEP_MIN_C || exact > SWEEP_MAX_C) {
+            continue;
+        }
+        double error = fabs(ntc_table_lookup(&table, mv) / 100.0 - exact);
+        if (error > worst) {
+            worst = error;
+            worst_at = exact;
+        }
+    }
+    printf("%s (%s): worst error %.4fC at %.2fC\n", name,
+           table.centi == ntc_default_centi ? "flash" : "RAM", worst, worst_at);
+    if (worst > TOLERANCE_C) {
+        printf("FAIL %s: %.4fC off at %.2fC\n", name, worst, worst_at);
+        failures++;
+    }
+    ntc_table_free(&table);
+}
+
+static void check_selection(void) {
+    ntc_table_t table = {0};
+
+    // The 100K sensor on a 100K divider shares the default curve
+    ntc_table_build(&table, 3950, 100000, 25, 100000);
+    bool shared = table.centi == ntc_default_centi && !table.built;
+
+    // Recalibrated beta: rebuilt in RAM, back to flash once it is restored
+    ntc_table_build(&table, 3977, 100000, 25, 100000);
+    bool rebuilt = table.built && table.centi == table.built;
+    int32_t recalibrated = ntc_table_lookup(&table, 1000);
+    ntc_table_build(&table, 3950, 100000, 25, 100000);
+    bool restored = table.centi == ntc_default_centi && !table.built;
+
+    if (!shared || !rebuilt || !restored || recalibrated == ntc_table_lookup(&table, 1000)) {
+        printf("FAIL selection: shared %d, rebuilt %d, restored %d\n", shared, rebuilt, restored);
+        failures++;
+    }
+    if (ntc_table_build(&table, 0.0f, 10000, 25, 10000) != ESP_ERR_INVALID_ARG) {
+        printf("FAIL selection: zero beta accepted\n");
+        failures++;
+    }
+    ntc_table_free(&table);
+    printf("Table selection: checked\n");
+}
+
+static void check_faults(void) {
+    ntc_table_t table = {0};
+    ntc_table_build(&table, NTC_DEFAULT_BETA, 10000, NTC_DEFAULT_T_NOMINAL, 10000);
+
+    // A shorted or open NTC leaves the divider within a few mV of a rail
+    int32_t shorted = ntc_table_lookup(&table, 0);
+    int32_t low_short = ntc_table_lookup(&table, NTC_TABLE_FAULT_MV - 1);
+    int32_t open = ntc_table_lookup(&table, NTC_TABLE_SUPPLY_MV);
+    int32_t near_open = ntc_table_lookup(&table, NTC_TABLE_SUPPLY_MV - NTC_TABLE_FAULT_MV + 1);
+    int32_t beyond = ntc_table_lookup(&table, NTC_TABLE_SUPPLY_MV + 200);
+    int32_t hottest = ntc_table_lookup(&table, NTC_TABLE_FAULT_MV);
+    int32_t coldest = ntc_table_lookup(&table, NTC_TABLE_SUPPLY_MV - NTC_TABLE_FAULT_MV);
+
+    if (shorted != NTC_TABLE_FAULT_CENTI || low_short != NTC_TABLE_FAULT_CENTI ||
+        open != NTC_TABLE_FAULT_CENTI || near_open != NTC_TABLE_FAULT_CENTI ||
+        beyond != NTC_TABLE_FAULT_CENTI) {
+        printf("FAIL faults: short %d/%d, open %d/%d, beyond %d\n",
+               shorted, low_short, open, near_open, beyond);
+        failures++;
+    }
+
+    // The band only covers readings no sensor in range produces
+    if (hottest < 15000 || coldest > -4000 || hottest == NTC_TABLE_FAULT_CENTI ||
+        coldest == NTC_TABLE_FAULT_CENTI) {
+        printf("FAIL fault band: band edges read %d and %d centi\n", hottest, coldest);
+        failures++;
+    }
+    printf("Faults: band edges at %.1fC and %.1fC\n", hottest / 100.0, coldest / 100.0);
+}
+
+int main(void) {
+    check_entries();
+    check_sweep("10K beta 3950", 3950, 10000, 25, 10000);
+    check_sweep("100K beta 3950", 3950, 100000, 25, 100000);
+    check_sweep("10K beta 3435 on 4.7K", 3435, 10000, 25, 4700);
+    check_sweep("10K beta 3977", 3977, 10000, 25, 10000);
+    check_selection();
+    check_faults();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+/**
+ * Host test for the 1-Wire protocol helpers and the DS18B20 decoding
+ * Checks the CRC against the Maxim reference ROM, runs the ROM search on a
+ * simulated wired-AND bus with several devices (every ROM found once, in
+ * any order) and decodes datasheet scratchpads at each resolution.
+ *
+ * Build and run from firmware/:
+ *   gcc -Iinclude -Itest/host test/test_onewire.c src/onewire.c -o /tmp/test_onewire
+ *   /tmp/test_onewire
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "onewire.h"
+#include "ds18b20.h"
+
+#define MAX_DEVICES     16
+
+static int failures = 0;
+
+// Simulated bus: each active device drives its bit, the line is the AND
+typedef struct {
+    onewire_rom_t roms[MAX_DEVICES];
+    bool active[MAX_DEVICES];
+    int count;
+} bus_t;
+
+static bool rom_bit(const onewire_rom_t *rom, int bit) {
+    return (rom->bytes[bit / 8] >> (bit % 8)) & 1;
+}
+
+// One search pass over the simulated bus
+static bool search_pass(bus_t *bus, onewire_search_t *search) {
+    for (int d = 0; d < bus->count; d++) {
+        bus->active[d] = true;
+    }
+    for (int bit = 0; bit < ONEWIRE_ROM_BITS; bit++) {
+        bool id_bit = true, cmp_bit = true, direction;
+        for (int d = 0; d < bus->count; d++) {
+            if (bus->active[d]) {
+                id_bit &= rom_bit(&bus->roms[d], bit);
+                cmp_bit &= !rom_bit(&bus->roms[d], bit);
+            }
+        }
+        if (!onewire_search_step(search, bit, id_bit, cmp_bit, &direction)) {
+            return false;
+        }
+        // Devices that do not match the branch go quiet until the next reset
+        for (int d = 0; d < bus->count; d++) {
+            if (rom_bit(&bus->roms[d], bit) != direction) {
+                bus->active[d] = false;
+            }
+        }
+    }
+    return onewire_search_finish(search);
+}
+
+static void random_rom(onewire_rom_t *rom, uint8_t family) {
+    rom->bytes[0] = family;
+    for (int i = 1; i < 7; i++) {
+        rom->bytes[i] = rand() & 0xFF;
+    }
+    rom->bytes[7] = onewire_crc8(rom->bytes, 7);
+}
+
+static void check_crc(void) {
+    // Maxim AN27 example ROM
+    const uint8_t rom[ONEWIRE_ROM_LEN] = { 0x02, 0x1C, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xA2 };
+    if (onewire_crc8(rom, 7) != 0xA2 || onewire_crc8(rom, 8) != 0) {
+        printf("FAIL CRC: %02X over the reference ROM\n", onewire_crc8(rom, 7));
+        failures++;
+    }
+    printf("CRC: checked\n");
+}
+
+static void check_search(int count) {
+    bus_t bus = { .count = count };
+    bool seen[MAX_DEVICES] = { false };
+    onewire_search_t search;
+    int found = 0;
+
+    for (int d = 0; d < count; d++) {
+        random_rom(&bus.roms[d], d % 3 ? DS18B20_FAMILY : 0x10);
+    }
+    // Two ROMs a single bit apart, deep in the serial
+    if (count >= 2) {
+        bus.roms[1] = bus.roms[0];
+        bus.roms[1].bytes[5] ^= 0x40;
+        bus.roms[1].bytes[7] = onewire_crc8(bus.roms[1].bytes, 7);
+    }
+
+    onewire_search_init(&search);
+    while (onewire_search_pending(&search) && found <= count) {
+        if (!search_pass(&bus, &search)) {
+            printf("FAIL search (%d devices): pass %d failed\n", count, found);
+            failures++;
+            return;
+        }
+        found++;
+        int match = -1;
+        for (int d = 0; d < count; d++) {
+            if (memcmp(&bus.roms[d], &search.rom, sizeof(onewire_rom_t)) == 0) {
+                match = d;
+            }
+        }
+        if (match < 0 || seen[match]) {
+            printf("FAIL search (%d devices): pass %d gave an %s ROM\n", count, found,
+                   match < 0 ? "unknown" : "already found");
+            failures++;
+            return;
+        }
+        seen[match] = true;
+    }
+    if (found != count) {
+        printf("FAIL search: %d of %d devices found\n", found, count);
+        failures++;
+    }
+    printf("Search, %d devices: %d found\n", count, found);
+}
+
+// An empty bus answers 1 and 1: no device
+static void check_empty_bus(void) {
+    bus_t bus = { .count = 0 };
+    onewire_search_t search;
+    onewire_search_init(&search);
+    if (search_pass(&bus, &search)) {
+        printf("FAIL empty bus: a ROM was found\n");
+        failures++;
+    }
+    printf("Empty bus: checked\n");
+}
+
+static void scratchpad(uint8_t pad[DS18B20_SCRATCHPAD_LEN], uint16_t raw, int bits) {
+    memset(pad, 0, DS18B20_SCRATCHPAD_LEN);
+    pad[0] = raw & 0xFF;
+    pad[1] = raw >> 8;
+    pad[2] = 0x4B;  // TH, TL at their defaults
+    pad[3] = 0x46;
+    pad[4] = 0x1F | ((bits - 9) << 5);
+    pad[5] = 0xFF;
+    pad[7] = 0x10;
+    pad[8] = onewire_crc8(pad, 8);
+}
+
+static void check_decode(void) {
+    // Datasheet table 1, 12 bits
+    const struct { uint16_t raw; float celsius; } table[] = {
+        { 0x07D0, 125.0f }, { 0x0550, 85.0f }, { 0x0191, 25.0625f }, { 0x00A2, 10.125f },
+        { 0x0008, 0.5f }, { 0x0000, 0.0f }, { 0xFFF8, -0.5f }, { 0xFF5E, -10.125f },
+        { 0xFE6F, -25.0625f }, { 0xFC90, -55.0f },
+    };
+    uint8_t pad[DS18B20_SCRATCHPAD_LEN];
+    int16_t raw;
+    float celsius;
+
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        scratchpad(pad, table[i].raw, 12);
+        if (!ds18b20_decode(pad, &raw, &celsius) || celsius != table[i].celsius) {
+            printf("FAIL decode %04X: %.4f, expected %.4f\n", table[i].raw, celsius, table[i].celsius);
+            failures++;
+        }
+    }
+
+    // 9 bits: the three low bits are undefined
+    scratchpad(pad, 0x0197, 9);
+    if (!ds18b20_decode(pad, &raw, &celsius) || celsius != 25.0f) {
+        printf("FAIL decode at 9 bits: %.4f\n", celsius);
+        failures++;
+    }
+
+    // Corrupt byte, and an all-zero read that passes the CRC
+    scratchpad(pad, 0x0191, 12);
+    pad[0] ^= 0x01;
+    bool corrupt = ds18b20_decode(pad, &raw, &celsius);
+    memset(pad, 0, sizeof(pad));
+    bool zeros = ds18b20_decode(pad, &raw, &celsius);
+    if (corrupt || zeros) {
+        printf("FAIL decode accepted a bad scratchpad (corrupt %d, zeros %d)\n", corrupt, zeros);
+        failures++;
+    }
+    printf("Decode: checked\n");
+}
+
+int main(void) {
+    srand(1);
+    check_crc();
+    check_empty_bus();
+    check_search(1);
+    check_search(2);
+    check_search(5);
+    check_search(MAX_DEVICES);
+    check_decode();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,198 @@
+/**
+ * Host test for the PID relay auto-tune
+ * Tunes against a first-order-plus-dead-time room model, then checks the
+ * new gains on a setpoint step, the abort path and the NVS round trip.
+ *
+ * Build and run from firmware/:
+ *   gcc -Iinclude -Itest/host test/test_pid_autotune.c src/pid_controller.c -lm -o /tmp/test_pid_autotune
+ *   /tmp/test_pid_autotune
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pid_controller.h"
+#include "nvs.h"
+
+#define SAMPLE_MS           1000
+#define MAX_DEAD_TIME_S     600
+#define OVERSHOOT_LIMIT     0.3     // After a 1 degree setpoint step
+#define SETTLE_BAND         0.1     // Within this of the setpoint...
+#define SETTLE_LIMIT_S      14400   // ...this long after the step
+
+static int failures = 0;
+
+// One-blob NVS, enough for the tunings
+static uint8_t nvs_blob[64];
+static size_t nvs_blob_size = 0;
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    *out_handle = 1;
+    return ESP_OK;
+}
+void nvs_close(nvs_handle_t handle) {}
+esp_err_t nvs_commit(nvs_handle_t handle) { return ESP_OK; }
+esp_err_t nvs_set_u64(nvs_handle_t handle, const char *key, uint64_t value) { return ESP_FAIL; }
+esp_err_t nvs_get_u64(nvs_handle_t handle, const char *key, uint64_t *out_value) { return ESP_FAIL; }
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    memcpy(nvs_blob, value, length);
+    nvs_blob_size = length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    if (nvs_blob_size == 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    memcpy(out_value, nvs_blob, nvs_blob_size < *length ? nvs_blob_size : *length);
+    *length = nvs_blob_size;
+    return ESP_OK;
+}
+
+// Room: first order with dead time, heater gain in degrees per percent
+typedef struct {
+    double gain;
+    double tau_s;
+    int dead_time_s;
+    double ambient;
+    double temperature;
+    float history[MAX_DEAD_TIME_S];
+    int head;
+} room_t;
+
+static float room_step(room_t *room, float output) {
+    float delayed = room->history[room->head];
+    room->history[room->head] = output;
+    room->head = (room->head + 1) % room->dead_time_s;
+
+    double target = room->ambient + room->gain * delayed;
+    room->temperature += (target - room->temperature) / room->tau_s;
+
+    // Sensor: 0.01 degree quantisation plus a little noise
+    double noise = ((rand() % 5) - 2) * 0.01;
+    return (float)(round(room->temperature * 100.0) / 100.0 + noise);
+}
+
+static float run(pid_controller_t *pid, room_t *room, float setpoint, int seconds) {
+    float input = (float)room->temperature;
+    float output = 0.0f;
+    for (int s = 0; s < seconds; s++) {
+        output = pid_controller_compute(pid, setpoint, input);
+        input = room_step(room, output);
+    }
+    return input;
+}
+
+static void room_init(room_t *room, double gain, double tau_s, int dead_time_s, float output) {
+    memset(room, 0, sizeof(*room));
+    room->gain = gain;
+    room->tau_s = tau_s;
+    room->dead_time_s = dead_time_s;
+    room->ambient = 10.0;
+    room->temperature = 20.0;
+    for (int i = 0; i < dead_time_s; i++) {
+        room->history[i] = output;
+    }
+}
+
+static void check_room(const char *name, double gain, double tau_s, int dead_time_s) {
+    const pid_config_t config = {
+        .kp = 25.0f, .ki = 0.5f, .kd = 10.0f,
+        .output_min = 0.0f, .output_max = 100.0f,
+        .sample_time_ms = SAMPLE_MS,
+    };
+    pid_controller_t pid;
+    room_t room;
+
+    // Start settled at 20 degrees on the output that holds it
+    float holding = (float)((20.0 - 10.0) / gain);
+    room_init(&room, gain, tau_s, dead_time_s, holding);
+    pid_controller_init(&pid, &config);
+    pid.last_output = pid_q16_from_float(holding);
+    pid.integral = (int64_t)pid_q16_from_float(holding) << PID_Q24_SHIFT;
+
+    pid_controller_set_auto_tune(&pid, true);
+    int elapsed = 0;
+    while (pid_controller_get_auto_tune_state(&pid) == PID_TUNE_RUNNING && elapsed < 8 * 3600) {
+        run(&pid, &room, 20.0f, 60);
+        elapsed += 60;
+    }
+    if (pid_controller_get_auto_tune_state(&pid) != PID_TUNE_DONE) {
+        printf("FAIL %s: auto-tune state %d after %d s\n", name, pid_controller_get_auto_tune_state(&pid), elapsed);
+        failures++;
+        return;
+    }
+
+    // Let the tuned loop settle, then step the setpoint by one degree
+    run(&pid, &room, 20.0f, 4 * 3600);
+    double peak = 0.0;
+    int settled_at = -1;
+    for (int s = 0; s < 6 * 3600; s++) {
+        float input = run(&pid, &room, 21.0f, 1);
+        if (input - 21.0 > peak) {
+            peak = input - 21.0;
+        }
+        if (fabs(input - 21.0) > SETTLE_BAND) {
+            settled_at = -1;
+        } else if (settled_at < 0) {
+            settled_at = s;
+        }
+    }
+
+    printf("%s: tuned in %d min, Ku=%.2f Tu=%.0fs, kp=%.2f ki=%.4f kd=%.1f, "
+           "overshoot %.2f, settled after %d min\n", name, elapsed / 60, pid.tune.ku, pid.tune.tu,
+           pid.config.kp, pid.config.ki, pid.config.kd, peak, settled_at / 60);
+    if (peak > OVERSHOOT_LIMIT || settled_at < 0 || settled_at > SETTLE_LIMIT_S) {
+        printf("FAIL %s: overshoot %.2f, settled at %d s\n", name, peak, settled_at);
+        failures++;
+    }
+}
+
+static void check_abort_and_persistence(void) {
+    const pid_config_t config = {
+        .kp = 25.0f, .ki = 0.5f, .kd = 10.0f,
+        .output_min = 0.0f, .output_max = 100.0f,
+        .sample_time_ms = SAMPLE_MS,
+    };
+    pid_controller_t pid;
+    room_t room;
+
+    // A reset mid-tune restores the previous gains
+    room_init(&room, 0.15, 1800.0, 120, 100.0f);
+    pid_controller_init(&pid, &config);
+    pid_controller_set_auto_tune(&pid, true);
+    run(&pid, &room, 20.0f, 600);
+    pid_controller_reset(&pid);
+    if (pid_controller_get_auto_tune_state(&pid) != PID_TUNE_IDLE || pid.config.kp != config.kp) {
+        printf("FAIL abort: state %d, kp %.2f\n", pid_controller_get_auto_tune_state(&pid), pid.config.kp);
+        failures++;
+    }
+
+    // Round trip through NVS
+    if (pid_controller_load_tunings(&pid) != ESP_ERR_NVS_NOT_FOUND) {
+        printf("FAIL load without saved tunings\n");
+        failures++;
+    }
+    pid_controller_set_tunings(&pid, 3.5f, 0.002f, 400.0f);
+    pid_controller_save_tunings(&pid);
+    pid_controller_init(&pid, &config);
+    if (pid_controller_load_tunings(&pid) != ESP_OK ||
+        pid.config.kp != 3.5f || pid.config.ki != 0.002f || pid.config.kd != 400.0f) {
+        printf("FAIL NVS round trip: kp %.2f ki %.4f kd %.1f\n", pid.config.kp, pid.config.ki, pid.config.kd);
+        failures++;
+    }
+    printf("Abort and persistence: checked\n");
+}
+
+int main(void) {
+    srand(3);
+    check_room("Small room", 0.25, 1200.0, 60);
+    check_room("Large room", 0.20, 3600.0, 240);
+    check_room("Sluggish room", 0.15, 5400.0, 480);
+    check_abort_and_persistence();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
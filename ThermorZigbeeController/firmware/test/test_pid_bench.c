@@ -0,0 +1,122 @@
+/**
+ * On-target benchmark for the fixed-point PID
+ * Cycles per call on the ESP32-C6, which has no FPU, for three paths:
+ *   - the float control law the Q16.16 one replaced
+ *   - the float wrapper: the Q16.16 law plus two conversions in, one out
+ *   - the Q16.16 entry point that the control task calls
+ * All three replay the same closed-loop trace. test_pid_fixed.c compares
+ * them on the host's FPU; this file gives the numbers for the target.
+ *
+ * Runs in place of the firmware's app_main; the results are in the log.
+ * The best of several rounds is kept, since interrupts only add cycles.
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "pid_controller.h"
+#include "pid_float_reference.h"
+
+#define BENCH_SAMPLES   2048    // 34 min at 1 s
+#define BENCH_ROUNDS    5
+
+static const char *TAG = "PID_BENCH";
+
+typedef enum {
+    PATH_FLOAT,
+    PATH_WRAPPER,
+    PATH_Q16,
+    PATH_COUNT
+} bench_path_t;
+
+static const char *const path_names[PATH_COUNT] = {
+    "float law",
+    "float wrapper",
+    "Q16.16 entry point",
+};
+
+// Recorded trace, in both representations
+static float setpoint[BENCH_SAMPLES];
+static float input[BENCH_SAMPLES];
+static pid_q16_t setpoint_q[BENCH_SAMPLES];
+static pid_q16_t input_q[BENCH_SAMPLES];
+
+static volatile float sink;
+static volatile pid_q16_t sink_q;
+
+// Closed loop on a first-order room: cold start, then a setpoint step up
+static void record_trace(const pid_config_t *config) {
+    float_pid_t pid;
+    double temperature = 15.0;
+
+    float_pid_init(&pid, config);
+    for (int s = 0; s < BENCH_SAMPLES; s++) {
+        setpoint[s] = (s < BENCH_SAMPLES / 2) ? 20.0f : 21.5f;
+        input[s] = (float)(round(temperature * 100.0) / 100.0);
+        setpoint_q[s] = pid_q16_from_float(setpoint[s]);
+        input_q[s] = pid_q16_from_float(input[s]);
+
+        float output = float_pid_compute(&pid, setpoint[s], input[s]);
+        temperature += (8.0 + 0.2 * output - temperature) / 600.0;
+    }
+}
+
+// Cycles for one pass over the trace
+static uint32_t run(bench_path_t path, const pid_config_t *config) {
+    float_pid_t reference;
+    pid_controller_t pid;
+
+    float_pid_init(&reference, config);
+    pid_controller_init(&pid, config);
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    switch (path) {
+    case PATH_FLOAT:
+        for (int s = 0; s < BENCH_SAMPLES; s++) {
+            sink = float_pid_compute(&reference, setpoint[s], input[s]);
+        }
+        break;
+    case PATH_WRAPPER:
+        for (int s = 0; s < BENCH_SAMPLES; s++) {
+            sink = pid_controller_compute(&pid, setpoint[s], input[s]);
+        }
+        break;
+    default:
+        for (int s = 0; s < BENCH_SAMPLES; s++) {
+            sink_q = pid_controller_compute_q16(&pid, setpoint_q[s], input_q[s]);
+        }
+        break;
+    }
+    return esp_cpu_get_cycle_count() - start;  // Unsigned: a wrap still subtracts right
+}
+
+void app_main(void) {
+    const pid_config_t config = {
+        .kp = 25.0f, .ki = 0.5f, .kd = 10.0f,
+        .output_min = 0.0f, .output_max = 100.0f, .sample_time_ms = 1000,
+    };
+
+    record_trace(&config);
+    ESP_LOGI(TAG, "%d calls per round at %d MHz, best of %d rounds", BENCH_SAMPLES,
+             CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, BENCH_ROUNDS);
+
+    uint32_t best[PATH_COUNT];
+    for (int p = 0; p < PATH_COUNT; p++) {
+        best[p] = UINT32_MAX;
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            uint32_t cycles = run((bench_path_t)p, &config);
+            if (cycles < best[p]) {
+                best[p] = cycles;
+            }
+            vTaskDelay(1);  // Let the idle task feed the watchdog
+        }
+        ESP_LOGI(TAG, "%-20s %6" PRIu32 " cycles/call", path_names[p], best[p] / BENCH_SAMPLES);
+    }
+    ESP_LOGI(TAG, "Q16.16 entry point: %.1fx faster than the float law, %.1fx than the wrapper",
+             (double)best[PATH_FLOAT] / best[PATH_Q16], (double)best[PATH_WRAPPER] / best[PATH_Q16]);
+}
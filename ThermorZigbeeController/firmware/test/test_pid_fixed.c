@@ -0,0 +1,153 @@
+/**
+ * Host test and benchmark for the fixed-point PID
+ * Records closed-loop traces (setpoint, measurement) against a room model,
+ * replays them through the Q16.16 controller and through the float
+ * reference it replaced, and checks the outputs agree. Also times both.
+ * Host timings only compare the two; on the ESP32-C6 (no FPU) the float
+ * version runs every operation in software, see test_pid_bench.c for the
+ * cycle counts there.
+ *
+ * Build and run from firmware/:
+ *   gcc -O2 -Iinclude -Itest/host test/test_pid_fixed.c src/pid_controller.c test/host/nvs_stub.c -lm -o /tmp/test_pid_fixed
+ *   /tmp/test_pid_fixed
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "pid_controller.h"
+#include "pid_float_reference.h"
+
+#define TRACE_SAMPLES       (12 * 3600)     // 12 h at 1 s
+#define OUTPUT_TOLERANCE    0.05f           // Output points (%)
+#define BENCH_PASSES        20
+
+static int failures = 0;
+
+// Recorded trace: what the controller saw
+typedef struct {
+    float setpoint[TRACE_SAMPLES];
+    float input[TRACE_SAMPLES];
+} trace_t;
+
+static trace_t trace;
+
+// Closed loop on a first-order room with dead time: cold start, setpoint
+// steps both ways, and an open window (heat loss) for half an hour
+static void record_trace(const pid_config_t *config, double gain, double tau_s, int dead_time_s) {
+    float_pid_t pid;
+    float history[600] = {0};
+    double temperature = 12.0;
+    int head = 0;
+
+    float_pid_init(&pid, config);
+    srand(11);
+    for (int s = 0; s < TRACE_SAMPLES; s++) {
+        float setpoint = (s < 4 * 3600) ? 20.0f : (s < 8 * 3600) ? 21.5f : 17.0f;
+        double ambient = (s >= 6 * 3600 && s < 6 * 3600 + 1800) ? -5.0 : 8.0;
+        float input = (float)(round(temperature * 100.0) / 100.0 + ((rand() % 5) - 2) * 0.01);
+
+        trace.setpoint[s] = setpoint;
+        trace.input[s] = input;
+        float output = float_pid_compute(&pid, setpoint, input);
+
+        float delayed = history[head];
+        history[head] = output;
+        head = (head + 1) % dead_time_s;
+        temperature += (ambient + gain * delayed - temperature) / tau_s;
+    }
+}
+
+static void check_trace(const char *name, const pid_config_t *config) {
+    float_pid_t reference;
+    pid_controller_t pid;
+    float worst = 0.0f;
+    int worst_at = 0, saturated = 0;
+
+    record_trace(config, 0.2, 2400.0, 180);
+    float_pid_init(&reference, config);
+    pid_controller_init(&pid, config);
+
+    for (int s = 0; s < TRACE_SAMPLES; s++) {
+        float expected = float_pid_compute(&reference, trace.setpoint[s], trace.input[s]);
+        float output = pid_controller_compute(&pid, trace.setpoint[s], trace.input[s]);
+        if (fabsf(output - expected) > worst) {
+            worst = fabsf(output - expected);
+            worst_at = s;
+        }
+        if (expected <= config->output_min || expected >= config->output_max) {
+            saturated++;
+        }
+    }
+
+    printf("%s: worst output difference %.4f%% at sample %d, %d%% of samples saturated\n",
+           name, worst, worst_at, saturated * 100 / TRACE_SAMPLES);
+    if (worst > OUTPUT_TOLERANCE) {
+        printf("FAIL %s: outputs differ by %.4f%%\n", name, worst);
+        failures++;
+    }
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+static void benchmark(const pid_config_t *config) {
+    float_pid_t reference;
+    pid_controller_t pid;
+    struct timespec t0, t1, t2;
+    volatile float sink = 0.0f;
+    volatile int64_t sink_q = 0;
+
+    static pid_q16_t setpoint_q[TRACE_SAMPLES];
+    static pid_q16_t input_q[TRACE_SAMPLES];
+    for (int s = 0; s < TRACE_SAMPLES; s++) {
+        setpoint_q[s] = pid_q16_from_float(trace.setpoint[s]);
+        input_q[s] = pid_q16_from_float(trace.input[s]);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        float_pid_init(&reference, config);
+        for (int s = 0; s < TRACE_SAMPLES; s++) {
+            sink += float_pid_compute(&reference, trace.setpoint[s], trace.input[s]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        pid_controller_init(&pid, config);
+        for (int s = 0; s < TRACE_SAMPLES; s++) {
+            sink_q += pid_controller_compute_q16(&pid, setpoint_q[s], input_q[s]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+
+    double calls = (double)BENCH_PASSES * TRACE_SAMPLES;
+    printf("Benchmark (host): float %.1f ns/call, Q16.16 %.1f ns/call\n",
+           elapsed_ns(&t0, &t1) / calls, elapsed_ns(&t1, &t2) / calls);
+}
+
+int main(void) {
+    const pid_config_t defaults = {
+        .kp = 25.0f, .ki = 0.5f, .kd = 10.0f,
+        .output_min = 0.0f, .output_max = 100.0f, .sample_time_ms = 1000,
+    };
+    const pid_config_t tuned = {
+        .kp = 25.5f, .ki = 0.0104f, .kd = 0.0f,
+        .output_min = 0.0f, .output_max = 100.0f, .sample_time_ms = 1000,
+    };
+    const pid_config_t derivative = {
+        .kp = 12.0f, .ki = 0.004f, .kd = 900.0f,
+        .output_min = 0.0f, .output_max = 100.0f, .sample_time_ms = 2000,
+    };
+
+    check_trace("Default gains", &defaults);
+    check_trace("Auto-tuned gains", &tuned);
+    check_trace("Strong derivative", &derivative);
+    benchmark(&defaults);
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
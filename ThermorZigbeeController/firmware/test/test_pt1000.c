@@ -0,0 +1,111 @@
+/**
+ * Host test for the PT1000 table conversion
+ * Checks the table entries and the interpolated inverse against the exact
+ * Callendar-Van Dusen equation (solved by bisection) over -50..150C, and
+ * the two-wire lead compensation.
+ *
+ * Build and run from firmware/:
+ *   gcc -Iinclude test/test_pt1000.c src/pt1000.c -lm -o /tmp/test_pt1000
+ *   /tmp/test_pt1000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "pt1000.h"
+
+#define TABLE_TOLERANCE_MOHM    1       // Rounding of the entries
+#define TOLERANCE_C             0.01    // Interpolated against exact
+#define SWEEP_STEP_C            0.01
+
+static int failures = 0;
+
+// Exact resistance at a temperature
+static double cvd_resistance(double t) {
+    double r = 1.0 + PT1000_CVD_A * t + PT1000_CVD_B * t * t;
+    if (t < 0.0) {
+        r += PT1000_CVD_C * (t - 100.0) * t * t * t;
+    }
+    return PT1000_R0 * r;
+}
+
+// Exact temperature for a resistance; R(T) is monotonic over the range
+static double cvd_temperature(double ohms) {
+    double lo = -200.0, hi = 850.0;
+    for (int i = 0; i < 100; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (cvd_resistance(mid) < ohms) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return 0.5 * (lo + hi);
+}
+
+static void check_table(void) {
+    for (int i = 0; i < PT1000_TABLE_SIZE; i++) {
+        double expected = cvd_resistance(PT1000_TABLE_MIN_C + i * PT1000_TABLE_STEP_C) * 1000.0;
+        if (fabs(pt1000_table_mohm[i] - expected) > TABLE_TOLERANCE_MOHM) {
+            printf("FAIL table[%d]: %u mohm, expected %.1f\n", i, pt1000_table_mohm[i], expected);
+            failures++;
+        }
+    }
+    printf("Table: %d entries checked\n", PT1000_TABLE_SIZE);
+}
+
+static void check_sweep(void) {
+    double worst = 0.0, worst_at = 0.0;
+
+    for (double t = PT1000_TABLE_MIN_C; t <= PT1000_TABLE_MAX_C + 1e-9; t += SWEEP_STEP_C) {
+        double ohms = cvd_resistance(t);
+        double exact = cvd_temperature(ohms);
+        double error = fabs(pt1000_resistance_to_temperature((float)ohms) - exact);
+        if (error > worst) {
+            worst = error;
+            worst_at = t;
+        }
+    }
+    printf("Sweep -50..150C: worst error %.4fC at %.2fC\n", worst, worst_at);
+    if (worst > TOLERANCE_C) {
+        printf("FAIL sweep: %.4fC off at %.2fC\n", worst, worst_at);
+        failures++;
+    }
+}
+
+static void check_leads(void) {
+    // 10 m of 0.5 mm2 twin cable: about 0.69 ohm, 0.18C if ignored
+    float lead = pt1000_lead_resistance(10.0f, 0.5f);
+    float measured = (float)cvd_resistance(21.0) + lead;
+    float raw = pt1000_resistance_to_temperature(measured);
+    float compensated = pt1000_temperature(measured, lead);
+
+    printf("Leads %.3f ohm: %.3fC raw, %.3fC compensated (21C)\n", lead, raw, compensated);
+    if (fabsf(lead - 0.688f) > 0.001f || fabsf(compensated - 21.0f) > TOLERANCE_C ||
+        fabsf(raw - 21.0f) < 0.1f) {
+        printf("FAIL lead compensation\n");
+        failures++;
+    }
+}
+
+static void check_faults(void) {
+    float open = pt1000_resistance_to_temperature(INFINITY);
+    float shorted = pt1000_resistance_to_temperature(0.0f);
+    float beyond = pt1000_resistance_to_temperature((float)cvd_resistance(160.0));
+
+    if (open > -200.0f || shorted > -200.0f || fabsf(beyond - 160.0f) > 0.1f) {
+        printf("FAIL faults: open %.1f, short %.1f, 160C read as %.2f\n", open, shorted, beyond);
+        failures++;
+    }
+    printf("Faults and range ends: checked\n");
+}
+
+int main(void) {
+    check_table();
+    check_sweep();
+    check_leads();
+    check_faults();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+/**
+ * Host test for the sensor filter chain
+ * Checks each stage against a brute-force reference on random sequences
+ * (moving average and median recomputed over the whole window), the
+ * running sum over a long run, spike rejection, the exponential step
+ * response, the rate limiter's slope, chaining and configuration checks.
+ *
+ * Build and run from firmware/:
+ *   gcc -Iinclude -Itest/host test/test_sensor_filter.c src/sensor_filter.c -lm -o /tmp/test_sensor_filter
+ *   /tmp/test_sensor_filter
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "sensor_filter.h"
+
+#define RANDOM_SAMPLES      20000
+#define AVERAGE_TOLERANCE   0.0011  // Millidegree rounding and truncation
+#define SAMPLE_MS           100
+
+static int failures = 0;
+
+static float random_temperature(void) {
+    // Quantised so the median sees repeated values
+    return 15.0f + (rand() % 2000) / 100.0f;
+}
+
+static int compare_float(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static void check_moving_average(uint8_t window) {
+    sensor_filter_stage_config_t config = { .type = SENSOR_FILTER_MOVING_AVERAGE, .window = window };
+    sensor_filter_t filter;
+    float history[RANDOM_SAMPLES];
+    double worst = 0.0;
+
+    sensor_filter_init(&filter, &config, 1);
+    srand(window);
+    for (int n = 0; n < RANDOM_SAMPLES; n++) {
+        history[n] = random_temperature();
+        float out = sensor_filter_apply(&filter, history[n], n * SAMPLE_MS);
+
+        int first = n + 1 > window ? n + 1 - window : 0;
+        double sum = 0.0;
+        for (int i = first; i <= n; i++) {
+            sum += history[i];
+        }
+        double error = fabs(out - sum / (n + 1 - first));
+        if (error > worst) {
+            worst = error;
+        }
+    }
+    printf("Moving average %2d: worst error %.4fC over %d samples\n", window, worst, RANDOM_SAMPLES);
+    if (worst > AVERAGE_TOLERANCE) {
+        printf("FAIL moving average %d: %.4fC off\n", window, worst);
+        failures++;
+    }
+}
+
+static void check_median(uint8_t window) {
+    sensor_filter_stage_config_t config = { .type = SENSOR_FILTER_MEDIAN, .window = window };
+    sensor_filter_t filter;
+    float history[RANDOM_SAMPLES];
+    int wrong = 0;
+
+    sensor_filter_init(&filter, &config, 1);
+    srand(100 + window);
+    for (int n = 0; n < RANDOM_SAMPLES; n++) {
+        history[n] = random_temperature();
+        float out = sensor_filter_apply(&filter, history[n], n * SAMPLE_MS);
+
+        int first = n + 1 > window ? n + 1 - window : 0;
+        float sorted[SENSOR_FILTER_MAX_MEDIAN];
+        int count = n + 1 - first;
+        for (int i = 0; i < count; i++) {
+            sorted[i] = history[first + i];
+        }
+        qsort(sorted, count, sizeof(float), compare_float);
+        if (out != sorted[(count - 1) / 2]) {
+            wrong++;
+        }
+    }
+    printf("Median %d: %d of %d outputs differ from the reference\n", window, wrong, RANDOM_SAMPLES);
+    if (wrong) {
+        printf("FAIL median %d\n", window);
+        failures++;
+    }
+}
+
+static void check_spike(void) {
+    sensor_filter_stage_config_t config = { .type = SENSOR_FILTER_MEDIAN, .window = 3 };
+    sensor_filter_t filter;
+    float worst = 0.0f;
+
+    sensor_filter_init(&filter, &config, 1);
+    for (int n = 0; n < 20; n++) {
+        float in = (n == 10) ? 71.0f : 21.0f;  // One bad reading
+        float out = sensor_filter_apply(&filter, in, n * SAMPLE_MS);
+        if (fabsf(out - 21.0f) > worst) {
+            worst = fabsf(out - 21.0f);
+        }
+    }
+    printf("Spike of 50C through median 3: %.2fC left\n", worst);
+    if (worst != 0.0f) {
+        printf("FAIL spike rejection\n");
+        failures++;
+    }
+}
+
+static void check_exponential(void) {
+    sensor_filter_stage_config_t config = { .type = SENSOR_FILTER_EXPONENTIAL, .alpha = 0.25f };
+    sensor_filter_t filter;
+    double worst = 0.0;
+
+    sensor_filter_init(&filter, &config, 1);
+    sensor_filter_apply(&filter, 20.0f, 0);  // Primes on the first sample
+    for (int n = 1; n <= 30; n++) {
+        float out = sensor_filter_apply(&filter, 30.0f, n * SAMPLE_MS);
+        double expected = 30.0 - 10.0 * pow(0.75, n);
+        if (fabs(out - expected) > worst) {
+            worst = fabs(out - expected);
+        }
+    }
+    printf("Exponential 0.25 step: worst error %.5fC\n", worst);
+    if (worst > 1e-4) {
+        printf("FAIL exponential\n");
+        failures++;
+    }
+}
+
+static void check_rate_limit(void) {
+    sensor_filter_stage_config_t config = { .type = SENSOR_FILTER_RATE_LIMIT, .max_rate = 0.5f };
+    sensor_filter_t filter;
+    int reached = -1;
+    float at_one_second = 0.0f;
+
+    sensor_filter_init(&filter, &config, 1);
+    sensor_filter_apply(&filter, 20.0f, 0);
+    for (int n = 1; n <= 300; n++) {
+        float out = sensor_filter_apply(&filter, 30.0f, n * SAMPLE_MS);
+        if (n == 10) {
+            at_one_second = out;
+        }
+        if (reached < 0 && out >= 30.0f) {
+            reached = n;
+        }
+    }
+
+    // 10C at 0.5C/s: 20s, 200 samples
+    printf("Rate limit 0.5C/s: %.3fC after 1s, step reached after %d samples\n", at_one_second, reached);
+    if (fabsf(at_one_second - 20.5f) > 1e-4f || reached < 199 || reached > 201) {
+        printf("FAIL rate limit\n");
+        failures++;
+    }
+}
+
+static void check_chain(void) {
+    sensor_filter_stage_config_t stages[] = {
+        { .type = SENSOR_FILTER_MEDIAN, .window = 5 },
+        { .type = SENSOR_FILTER_MOVING_AVERAGE, .window = 4 },
+        { .type = SENSOR_FILTER_EXPONENTIAL, .alpha = 0.5f },
+        { .type = SENSOR_FILTER_RATE_LIMIT, .max_rate = 1.0f },
+    };
+    sensor_filter_t filter, passthrough;
+    float worst = 0.0f;
+
+    sensor_filter_init(&filter, stages, 4);
+    sensor_filter_init(&passthrough, NULL, 0);
+    for (int n = 0; n < 100; n++) {
+        float in = (n % 17 == 5) ? -40.0f : 21.5f;  // Periodic single spikes
+        float out = sensor_filter_apply(&filter, in, n * SAMPLE_MS);
+        if (fabsf(out - 21.5f) > worst) {
+            worst = fabsf(out - 21.5f);
+        }
+    }
+    bool passes = sensor_filter_apply(&passthrough, 12.34f, 0) == 12.34f;
+
+    printf("Four-stage chain with spikes: %.3fC off; empty chain passes through: %s\n",
+           worst, passes ? "yes" : "no");
+    if (worst != 0.0f || !passes) {
+        printf("FAIL chain\n");
+        failures++;
+    }
+}
+
+static void check_config(void) {
+    sensor_filter_t filter;
+    sensor_filter_stage_config_t even_median = { .type = SENSOR_FILTER_MEDIAN, .window = 4 };
+    sensor_filter_stage_config_t wide_average = { .type = SENSOR_FILTER_MOVING_AVERAGE,
+                                                  .window = SENSOR_FILTER_MAX_WINDOW + 1 };
+    sensor_filter_stage_config_t zero_alpha = { .type = SENSOR_FILTER_EXPONENTIAL, .alpha = 0.0f };
+    sensor_filter_stage_config_t no_rate = { .type = SENSOR_FILTER_RATE_LIMIT, .max_rate = 0.0f };
+    sensor_filter_stage_config_t many[SENSOR_FILTER_MAX_STAGES + 1];
+    for (int i = 0; i <= SENSOR_FILTER_MAX_STAGES; i++) {
+        many[i] = (sensor_filter_stage_config_t){ .type = SENSOR_FILTER_EXPONENTIAL, .alpha = 0.5f };
+    }
+
+    if (sensor_filter_init(&filter, &even_median, 1) != ESP_ERR_INVALID_ARG ||
+        sensor_filter_init(&filter, &wide_average, 1) != ESP_ERR_INVALID_ARG ||
+        sensor_filter_init(&filter, &zero_alpha, 1) != ESP_ERR_INVALID_ARG ||
+        sensor_filter_init(&filter, &no_rate, 1) != ESP_ERR_INVALID_ARG ||
+        sensor_filter_init(&filter, many, SENSOR_FILTER_MAX_STAGES + 1) != ESP_ERR_INVALID_ARG ||
+        sensor_filter_init(&filter, many, SENSOR_FILTER_MAX_STAGES) != ESP_OK) {
+        printf("FAIL configuration checks\n");
+        failures++;
+    }
+    printf("Configuration checks: done\n");
+}
+
+int main(void) {
+    check_moving_average(1);
+    check_moving_average(5);
+    check_moving_average(SENSOR_FILTER_MAX_WINDOW);
+    check_median(1);
+    check_median(3);
+    check_median(5);
+    check_median(SENSOR_FILTER_MAX_MEDIAN);
+    check_spike();
+    check_exponential();
+    check_rate_limit();
+    check_chain();
+    check_config();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
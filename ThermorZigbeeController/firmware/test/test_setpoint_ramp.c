@@ -0,0 +1,175 @@
+/**
+ * Host test for the setpoint trajectory
+ * Runs an eco to comfort transition on a first-order-plus-dead-time room,
+ * once with the setpoint stepped and once through the ramp, and compares
+ * overshoot, peak power, time at full power and arrival (the ramp with
+ * the model feedforward). Also checks that small adjustments do not
+ * restart a running ramp and that falls apply at once.
+ *
+ * Build and run from firmware/:
+ *   gcc -Iinclude -Itest/host test/test_setpoint_ramp.c src/setpoint_ramp.c src/pid_controller.c test/host/nvs_stub.c -lm -o /tmp/test_setpoint_ramp
+ *   /tmp/test_setpoint_ramp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "setpoint_ramp.h"
+
+#define MAX_DEAD_TIME_S     600
+#define ECO                 17.0f
+#define COMFORT             20.0f
+
+static int failures = 0;
+
+typedef struct {
+    double gain;
+    double tau_s;
+    int dead_time_s;
+    double ambient;
+    double temperature;
+    float history[MAX_DEAD_TIME_S];
+    int head;
+} room_t;
+
+static float room_step(room_t *room, float output) {
+    float delayed = room->history[room->head];
+    room->history[room->head] = output;
+    room->head = (room->head + 1) % room->dead_time_s;
+    room->temperature += (room->ambient + room->gain * delayed - room->temperature) / room->tau_s;
+    return (float)(round(room->temperature * 100.0) / 100.0);
+}
+
+typedef struct {
+    double overshoot;
+    float peak_power;
+    int saturated_s;         // Seconds at 100%
+    int reach_s;             // First time within 0.2 of comfort
+} transition_t;
+
+static void transition(const pid_config_t *config, bool use_ramp, transition_t *result) {
+    pid_controller_t pid;
+    setpoint_ramp_t ramp;
+    room_t room = { .gain = 0.2, .tau_s = 3600.0, .dead_time_s = 180, .ambient = 8.0 };
+    thermal_model_params_t model = {
+        .gain = 0.2f, .tau_s = 3600.0f, .dead_time_s = 180.0f, .ambient = 8.0f,
+        .confidence = 0.9f, .samples = 1000,
+    };
+
+    // Settled at eco on the output that holds it
+    float holding = (float)((ECO - room.ambient) / room.gain);
+    room.temperature = ECO;
+    for (int i = 0; i < room.dead_time_s; i++) {
+        room.history[i] = holding;
+    }
+    pid_controller_init(&pid, config);
+    pid.last_output = pid_q16_from_float(holding);
+    pid.integral = (int64_t)pid_q16_from_float(holding) << PID_Q24_SHIFT;
+    pid.last_input = pid_q16_from_float(ECO);
+    pid.first_run = false;
+    setpoint_ramp_init(&ramp, SETPOINT_RAMP_MAX_RATE);
+    setpoint_ramp_update(&ramp, ECO, ECO, 1.0f);
+
+    memset(result, 0, sizeof(*result));
+    result->reach_s = -1;
+    float input = ECO;
+    for (int s = 0; s < 6 * 3600; s++) {
+        float setpoint = COMFORT;
+        if (use_ramp) {
+            setpoint_ramp_set_model(&ramp, &model, input);
+            setpoint = setpoint_ramp_update(&ramp, COMFORT, input, 1.0f);
+            pid_controller_set_feedforward(&pid, setpoint_ramp_feedforward(&ramp, &model));
+        }
+        float output = pid_controller_compute(&pid, setpoint, input);
+        input = room_step(&room, output);
+
+        if (output > result->peak_power) {
+            result->peak_power = output;
+        }
+        if (output >= 100.0f) {
+            result->saturated_s++;
+        }
+        if (room.temperature - COMFORT > result->overshoot) {
+            result->overshoot = room.temperature - COMFORT;
+        }
+        if (result->reach_s < 0 && room.temperature > COMFORT - 0.2) {
+            result->reach_s = s;
+        }
+    }
+}
+
+static void check_transition(const char *name, const pid_config_t *config) {
+    transition_t step, ramped;
+    transition(config, false, &step);
+    transition(config, true, &ramped);
+
+    printf("%s, step: overshoot %.2f, peak %.0f%%, %d min at 100%%, comfort after %d min\n",
+           name, step.overshoot, step.peak_power, step.saturated_s / 60, step.reach_s / 60);
+    printf("%s, ramp: overshoot %.2f, peak %.0f%%, %d min at 100%%, comfort after %d min\n",
+           name, ramped.overshoot, ramped.peak_power, ramped.saturated_s / 60, ramped.reach_s / 60);
+
+    // Gentler and no later than half as long again as the step
+    if (ramped.reach_s < 0 || ramped.reach_s > step.reach_s * 3 / 2 ||
+        ramped.overshoot > step.overshoot ||
+        ramped.peak_power > step.peak_power || ramped.saturated_s > step.saturated_s) {
+        printf("FAIL %s: the ramp made the transition worse\n", name);
+        failures++;
+    }
+    if (ramped.overshoot > 0.3) {
+        printf("FAIL %s: overshoot %.2f through the ramp\n", name, ramped.overshoot);
+        failures++;
+    }
+}
+
+static void check_adjustments(void) {
+    setpoint_ramp_t ramp;
+    setpoint_ramp_init(&ramp, 0.1f);
+    setpoint_ramp_update(&ramp, ECO, ECO, 1.0f);
+
+    // Ten minutes into a ramp to comfort, the user nudges the target up
+    float effective = 0.0f;
+    for (int s = 0; s < 600; s++) {
+        effective = setpoint_ramp_update(&ramp, COMFORT, ECO, 1.0f);
+    }
+    float nudged = setpoint_ramp_update(&ramp, COMFORT + 0.5f, ECO, 1.0f);
+    if (!setpoint_ramp_is_active(&ramp) || nudged < effective || nudged > effective + 0.01f) {
+        printf("FAIL adjustment: effective %.2f -> %.2f, ramping %d\n", effective, nudged,
+               setpoint_ramp_is_active(&ramp));
+        failures++;
+    }
+
+    // A room ahead of the ramp pulls it along
+    float ahead = setpoint_ramp_update(&ramp, COMFORT + 0.5f, 19.0f, 1.0f);
+    if (ahead < 19.0f) {
+        printf("FAIL catch-up: effective %.2f with the room at 19.0\n", ahead);
+        failures++;
+    }
+
+    // Falls apply at once, small rises too
+    float fallen = setpoint_ramp_update(&ramp, ECO, 19.0f, 1.0f);
+    float small = setpoint_ramp_update(&ramp, ECO + 0.5f, 19.0f, 1.0f);
+    if (fallen != ECO || small != ECO + 0.5f || setpoint_ramp_is_active(&ramp)) {
+        printf("FAIL fall %.2f / small rise %.2f\n", fallen, small);
+        failures++;
+    }
+    printf("Adjustments: checked\n");
+}
+
+int main(void) {
+    const pid_config_t simc = {
+        .kp = 37.5f, .ki = 0.0195f, .kd = 0.0f,
+        .output_min = 0.0f, .output_max = 100.0f, .sample_time_ms = 1000,
+    };
+    const pid_config_t tuned = {
+        .kp = 25.5f, .ki = 0.0104f, .kd = 0.0f,
+        .output_min = 0.0f, .output_max = 100.0f, .sample_time_ms = 1000,
+    };
+
+    check_transition("Model (SIMC) gains", &simc);
+    check_transition("Auto-tuned gains", &tuned);
+    check_adjustments();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,175 @@
+/**
+ * Host test for the online thermal-model identification
+ * Runs the PID loop against first-order-plus-dead-time rooms through two
+ * days of setpoint changes, with the identified model retuning the gains
+ * as it goes. Checks the identified gain, time constant and dead time,
+ * then the retuned loop on a setpoint step.
+ *
+ * Build and run from firmware/:
+ *   gcc -Iinclude -Itest/host test/test_thermal_model.c src/thermal_model.c src/pid_controller.c test/host/nvs_stub.c -lm -o /tmp/test_thermal_model
+ *   /tmp/test_thermal_model
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "thermal_model.h"
+
+#define MAX_DEAD_TIME_S     600
+#define GAIN_TOLERANCE      0.15    // Relative
+#define TAU_TOLERANCE       0.2     // Relative
+#define DEAD_TIME_TOLERANCE 150     // Seconds: candidates are a minute or more apart
+#define OVERSHOOT_LIMIT     0.3     // After a 1 degree setpoint step
+#define SETTLE_BAND         0.1
+#define SETTLE_LIMIT_S      (4 * 3600)
+
+static int failures = 0;
+
+// Room: first order with dead time, heater gain in degrees per percent,
+// ambient drifting over the day
+typedef struct {
+    double gain;
+    double tau_s;
+    int dead_time_s;
+    double temperature;
+    float history[MAX_DEAD_TIME_S];
+    int head;
+    long seconds;
+} room_t;
+
+static float room_step(room_t *room, float output) {
+    float delayed = output;
+    if (room->dead_time_s > 0) {
+        delayed = room->history[room->head];
+        room->history[room->head] = output;
+        room->head = (room->head + 1) % room->dead_time_s;
+    }
+
+    double ambient = 8.0 + 2.0 * sin(2.0 * M_PI * room->seconds / 86400.0);
+    room->temperature += (ambient + room->gain * delayed - room->temperature) / room->tau_s;
+    room->seconds++;
+
+    // Sensor: 0.01 degree quantisation plus a little noise
+    double noise = ((rand() % 5) - 2) * 0.01;
+    return (float)(round(room->temperature * 100.0) / 100.0 + noise);
+}
+
+static float run(pid_controller_t *pid, thermal_model_t *model, room_t *room, float setpoint,
+                 int seconds, int *retunes) {
+    float input = (float)room->temperature;
+    for (int s = 0; s < seconds; s++) {
+        float output = pid_controller_compute(pid, setpoint, input);
+        uint8_t power = (uint8_t)output;
+        if (thermal_model_update(model, power, input) && retunes && thermal_model_retune(model, pid)) {
+            (*retunes)++;
+        }
+        input = room_step(room, power);
+    }
+    return input;
+}
+
+static void check_room(const char *name, double gain, double tau_s, int dead_time_s) {
+    static const float setpoints[] = { 19.0f, 21.0f, 17.5f, 22.0f, 18.0f, 20.5f };
+    const pid_config_t config = {
+        .kp = 25.0f, .ki = 0.5f, .kd = 10.0f,
+        .output_min = 0.0f, .output_max = 100.0f, .sample_time_ms = 1000,
+    };
+    pid_controller_t pid;
+    thermal_model_t model;
+    thermal_model_params_t params;
+    room_t room = {
+        .gain = gain, .tau_s = tau_s, .dead_time_s = dead_time_s, .temperature = 15.0,
+    };
+    int retunes = 0;
+
+    pid_controller_init(&pid, &config);
+    thermal_model_init(&model);
+
+    // Two days of setpoint changes every four hours, retuning as it goes
+    for (int block = 0; block < 12; block++) {
+        run(&pid, &model, &room, setpoints[block % 6], 4 * 3600, &retunes);
+    }
+
+    thermal_model_get_params(&model, &params);
+    printf("%s: K=%.3f tau=%.0fs theta=%.0fs ambient=%.1f confidence %.2f, %d retunes -> kp=%.2f ki=%.5f\n",
+           name, params.gain, params.tau_s, params.dead_time_s, params.ambient, params.confidence,
+           retunes, pid.config.kp, pid.config.ki);
+
+    if (fabs(params.gain - gain) > GAIN_TOLERANCE * gain ||
+        fabs(params.tau_s - tau_s) > TAU_TOLERANCE * tau_s ||
+        fabs(params.dead_time_s - dead_time_s) > DEAD_TIME_TOLERANCE ||
+        params.confidence < THERMAL_MODEL_MIN_CONFIDENCE) {
+        printf("FAIL %s: model K=%.3f tau=%.0f theta=%.0f confidence %.2f, expected K=%.3f tau=%.0f theta=%d\n",
+               name, params.gain, params.tau_s, params.dead_time_s, params.confidence, gain, tau_s, dead_time_s);
+        failures++;
+    }
+    if (retunes == 0 || pid.config.kd != 0.0f) {
+        printf("FAIL %s: gains were never re-derived\n", name);
+        failures++;
+    }
+
+    // The retuned loop on a one degree step
+    run(&pid, &model, &room, 20.0f, 4 * 3600, NULL);
+    double peak = 0.0;
+    int settled_at = -1;
+    for (int s = 0; s < 6 * 3600; s++) {
+        float input = run(&pid, &model, &room, 21.0f, 1, NULL);
+        if (input - 21.0 > peak) {
+            peak = input - 21.0;
+        }
+        if (fabs(input - 21.0) > SETTLE_BAND) {
+            settled_at = -1;
+        } else if (settled_at < 0) {
+            settled_at = s;
+        }
+    }
+    printf("%s: step overshoot %.2f, settled after %d min\n", name, peak, settled_at / 60);
+    if (peak > OVERSHOOT_LIMIT || settled_at < 0 || settled_at > SETTLE_LIMIT_S) {
+        printf("FAIL %s: overshoot %.2f, settled at %d s\n", name, peak, settled_at);
+        failures++;
+    }
+}
+
+// Without excitation the covariance must stay bounded and the fit must not wander
+static void check_steady_state(void) {
+    thermal_model_t model;
+    thermal_model_params_t before, after;
+
+    thermal_model_init(&model);
+    room_t room = { .gain = 0.2, .tau_s = 3600.0, .dead_time_s = 180, .temperature = 15.0 };
+    pid_controller_t pid;
+    const pid_config_t config = {
+        .kp = 20.0f, .ki = 0.01f, .kd = 0.0f,
+        .output_min = 0.0f, .output_max = 100.0f, .sample_time_ms = 1000,
+    };
+    pid_controller_init(&pid, &config);
+    for (int block = 0; block < 6; block++) {
+        run(&pid, &model, &room, (block & 1) ? 21.0f : 18.0f, 4 * 3600, NULL);
+    }
+    thermal_model_get_params(&model, &before);
+
+    // A day at constant power and temperature: nothing to learn from
+    for (int s = 0; s < 86400; s++) {
+        thermal_model_update(&model, 50.0f, 18.0f + ((s / 60) % 3 - 1) * 0.01f);
+    }
+    thermal_model_get_params(&model, &after);
+
+    printf("Steady state: K %.3f -> %.3f, tau %.0f -> %.0f, confidence %.2f -> %.2f\n",
+           before.gain, after.gain, before.tau_s, after.tau_s, before.confidence, after.confidence);
+    if (!isfinite(after.confidence) || after.confidence > before.confidence + 0.05f) {
+        printf("FAIL steady state: confidence grew without excitation\n");
+        failures++;
+    }
+}
+
+int main(void) {
+    srand(5);
+    check_room("Small room", 0.25, 1200.0, 60);
+    check_room("Large room", 0.20, 3600.0, 180);
+    check_room("Sluggish room", 0.15, 5400.0, 480);
+    check_steady_state();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
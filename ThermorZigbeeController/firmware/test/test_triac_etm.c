@@ -0,0 +1,285 @@
+/**
+ * Host test for the ETM firing backend
+ * Runs the register values from triac_etm_compute_plan() through a tick
+ * model of the event chain (two timers, gate set/clear) and checks where
+ * the gate pulses land relative to the true zero crossings.
+ *
+ * Build and run from firmware/:
+ *   gcc -Iinclude -Itest/host test/test_triac_etm.c src/triac_power_table.c -o /tmp/test_triac_etm
+ *   /tmp/test_triac_etm
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "triac_etm.h"
+#include "triac_power_table.h"
+
+#define TIMING_TOLERANCE_US 1       // Task delivery inside one tick
+#define HALF_CYCLES         6       // Simulated per operating point
+
+static int failures = 0;
+
+// One general-purpose timer, as far as the chain uses it
+typedef struct {
+    uint32_t count;
+    uint32_t alarm;
+    bool running;
+    bool alarm_enabled;
+} model_timer_t;
+
+typedef struct {
+    model_timer_t phase;
+    model_timer_t pulse;
+    bool fire;              // Phase alarm -> gates SET route enabled
+    bool gate;
+    long rise[HALF_CYCLES * 2];
+    long fall[HALF_CYCLES * 2];
+    int rises;
+    int falls;
+} model_t;
+
+static void gate_set(model_t *m, long t) {
+    if (!m->gate) {
+        m->gate = true;
+        m->rise[m->rises++] = t;
+    }
+}
+
+static void gate_clr(model_t *m, long t) {
+    if (m->gate) {
+        m->gate = false;
+        m->fall[m->falls++] = t;
+    }
+}
+
+// The comparator matches when the count has reached the alarm
+static bool alarm_due(const model_timer_t *timer) {
+    return timer->alarm_enabled && timer->count >= timer->alarm;
+}
+
+// Alarm with auto-reload to 0; the alarm disarms until re-enabled
+static void alarm_taken(model_timer_t *timer) {
+    timer->count = 0;
+    timer->alarm_enabled = false;
+}
+
+static void pulse_alarm(model_t *m, long t) {
+    alarm_taken(&m->pulse);
+    m->pulse.running = false;   // STOP
+    gate_clr(m, t);             // CLR
+}
+
+static void phase_alarm(model_t *m, long t) {
+    alarm_taken(&m->phase);
+    m->phase.running = false;   // STOP
+    if (m->fire) {
+        gate_set(m, t);         // SET
+    }
+    // Pulse EN_ALARM and START, in the given order
+    m->pulse.alarm_enabled = true;
+    if (alarm_due(&m->pulse)) {
+        pulse_alarm(m, t);
+    }
+    m->pulse.running = true;
+}
+
+// Zero-cross edge: phase EN_ALARM, START and gate CLR, in either order
+static void edge(model_t *m, long t, bool start_first) {
+    if (start_first) {
+        m->phase.running = true;
+    }
+    m->phase.alarm_enabled = true;
+    if (alarm_due(&m->phase)) {
+        phase_alarm(m, t);
+    }
+    if (!start_first) {
+        m->phase.running = true;
+    }
+    gate_clr(m, t);
+}
+
+static void tick(model_t *m, long t) {
+    if (m->phase.running) {
+        m->phase.count++;
+        if (alarm_due(&m->phase)) {
+            phase_alarm(m, t);
+        }
+    }
+    if (m->pulse.running) {
+        m->pulse.count++;
+        if (alarm_due(&m->pulse)) {
+            pulse_alarm(m, t);
+        }
+    }
+}
+
+// Simulate HALF_CYCLES crossings; a crossing index in 'skip' has no edge,
+// and a noise edge can be injected 'noise_at' after every detector edge
+static void run(model_t *m, const triac_etm_plan_t *plan, uint32_t half_cycle, int32_t offset,
+                int skip, long noise_at, bool start_first) {
+    *m = (model_t) {
+        .phase = { .alarm = plan->phase_alarm },
+        .pulse = { .alarm = plan->pulse_alarm },
+        .fire = plan->fire,
+    };
+
+    long first_crossing = 1000;
+    long end = first_crossing + (long)half_cycle * HALF_CYCLES;
+    for (long t = 0; t < end; t++) {
+        tick(m, t);
+        long since = t - first_crossing + offset;    // Detector edge is offset before the crossing
+        if (since >= 0) {
+            int n = since / half_cycle;
+            long in_cycle = since % half_cycle;
+            if (in_cycle == 0 && n != skip) {
+                edge(m, t, start_first);
+            } else if (noise_at > 0 && in_cycle == noise_at && n != skip) {
+                edge(m, t, start_first);
+            }
+        }
+    }
+}
+
+static void check_point(uint8_t frequency, uint8_t percent, int32_t offset, bool start_first) {
+    uint32_t half_cycle = (frequency == 60) ? 8333 : 10000;
+    uint32_t delay = triac_table_delay_us(percent, frequency);
+    triac_etm_plan_t plan = triac_etm_compute_plan(delay, offset, half_cycle);
+    model_t m;
+
+    run(&m, &plan, half_cycle, offset, -1, 0, start_first);
+
+    if (!plan.fire) {
+        if (m.rises != 0) {
+            printf("FAIL %dHz %d%%: gate raised with firing disabled\n", frequency, percent);
+            failures++;
+        }
+        if (delay + TRIAC_ETM_PULSE_US + TRIAC_ETM_END_GUARD_US <= half_cycle) {
+            printf("FAIL %dHz %d%%: firing disabled for a reachable delay %u us\n",
+                   frequency, percent, delay);
+            failures++;
+        }
+        return;
+    }
+
+    // Every simulated half-cycle fires exactly once
+    int expected_rises = HALF_CYCLES;
+    if (m.rises != expected_rises || m.falls != m.rises) {
+        printf("FAIL %dHz %d%% offset %d: %d rises, %d falls, expected %d\n",
+               frequency, percent, offset, m.rises, m.falls, expected_rises);
+        failures++;
+        return;
+    }
+
+    for (int i = 0; i < m.rises; i++) {
+        long crossing = 1000 + (long)half_cycle * i;
+        long angle = m.rise[i] - crossing;
+        long width = m.fall[i] - m.rise[i];
+        long wanted = (long)delay;
+        if ((long)plan.phase_alarm - offset > wanted) {
+            wanted = (long)plan.phase_alarm - offset;   // Clamped to the earliest alarm
+        }
+        if (labs(angle - wanted) > TIMING_TOLERANCE_US) {
+            printf("FAIL %dHz %d%% offset %d: fired %ld us after the crossing, expected %ld\n",
+                   frequency, percent, offset, angle, wanted);
+            failures++;
+        }
+        if (labs(width - TRIAC_ETM_PULSE_US) > TIMING_TOLERANCE_US) {
+            printf("FAIL %dHz %d%%: pulse width %ld us\n", frequency, percent, width);
+            failures++;
+        }
+        if (m.fall[i] > crossing + (long)half_cycle - TRIAC_ETM_END_GUARD_US) {
+            printf("FAIL %dHz %d%%: gate still high %ld us before the next crossing\n",
+                   frequency, percent, crossing + (long)half_cycle - m.fall[i]);
+            failures++;
+        }
+    }
+}
+
+static void check_operating_points(void) {
+    const int32_t offsets[] = { -150, 0, 150, 400 };
+    int points = 0;
+
+    for (int f = 0; f < 2; f++) {
+        uint8_t frequency = f ? 60 : 50;
+        for (int o = 0; o < 4; o++) {
+            for (int p = 0; p <= TRIAC_POWER_STEPS; p++) {
+                check_point(frequency, p, offsets[o], true);
+                check_point(frequency, p, offsets[o], false);
+                points += 2;
+            }
+        }
+    }
+    printf("Operating points: %d simulated\n", points);
+}
+
+static void check_register_values(void) {
+    // Alarm is delay plus offset, clamped to the earliest alarm
+    triac_etm_plan_t plan = triac_etm_compute_plan(5000, 200, 10000);
+    if (!plan.fire || plan.phase_alarm != 5200 || plan.pulse_alarm != TRIAC_ETM_PULSE_US) {
+        printf("FAIL plan(5000, 200): fire %d alarm %u pulse %u\n",
+               plan.fire, plan.phase_alarm, plan.pulse_alarm);
+        failures++;
+    }
+    plan = triac_etm_compute_plan(100, -300, 10000);
+    if (!plan.fire || plan.phase_alarm != TRIAC_ETM_MIN_ALARM) {
+        printf("FAIL plan(100, -300): alarm %u, expected %u\n", plan.phase_alarm, TRIAC_ETM_MIN_ALARM);
+        failures++;
+    }
+
+    // Last delay that still ends the pulse in time, and the first that does not
+    uint32_t last = 10000 - TRIAC_ETM_PULSE_US - TRIAC_ETM_END_GUARD_US;
+    if (!triac_etm_compute_plan(last, 0, 10000).fire || triac_etm_compute_plan(last + 1, 0, 10000).fire) {
+        printf("FAIL end guard boundary at %u us\n", last);
+        failures++;
+    }
+    if (triac_etm_compute_plan(10000, 0, 10000).fire) {
+        printf("FAIL zero power fires\n");
+        failures++;
+    }
+    printf("Register values: checked\n");
+}
+
+static void check_missing_edge(void) {
+    triac_etm_plan_t plan = triac_etm_compute_plan(4000, 0, 10000);
+    model_t m;
+
+    // No edge for crossing 2: that half-cycle must not fire at all
+    run(&m, &plan, 10000, 0, 2, 0, true);
+    for (int i = 0; i < m.rises; i++) {
+        if (m.rise[i] >= 21000 && m.rise[i] < 31000) {
+            printf("FAIL fired at %ld without a zero-cross edge\n", m.rise[i]);
+            failures++;
+        }
+    }
+    if (m.rises != HALF_CYCLES - 1) {
+        printf("FAIL missing edge: %d pulses, expected %d\n", m.rises, HALF_CYCLES - 1);
+        failures++;
+    }
+    printf("Missing edge: %d pulses over %d half-cycles\n", m.rises, HALF_CYCLES);
+}
+
+static void check_noise_before_firing(void) {
+    triac_etm_plan_t plan = triac_etm_compute_plan(6000, 0, 10000);
+    model_t m;
+
+    // A noise edge while the phase timer counts must not move the firing
+    run(&m, &plan, 10000, 0, -1, 2500, false);
+    for (int i = 0; i < m.rises; i++) {
+        long angle = m.rise[i] - (1000 + 10000L * i);
+        if (labs(angle - 6000) > TIMING_TOLERANCE_US) {
+            printf("FAIL noise moved firing to %ld us\n", angle);
+            failures++;
+        }
+    }
+    printf("Noise while counting: %d pulses checked\n", m.rises);
+}
+
+int main(void) {
+    check_register_values();
+    check_operating_points();
+    check_missing_edge();
+    check_noise_before_firing();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
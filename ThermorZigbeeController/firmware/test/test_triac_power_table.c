@@ -0,0 +1,100 @@
+/**
+ * Host test for the phase-control power tables
+ * Checks the generated tables against a numerical reference of the RMS
+ * power integral (no closed form used on the reference side).
+ *
+ * Build and run from firmware/:
+ *   gcc -Iinclude test/test_triac_power_table.c src/triac_power_table.c -lm -o /tmp/test_triac_power_table
+ *   /tmp/test_triac_power_table
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "triac_power_table.h"
+
+#define INTEGRATION_STEPS   2000    // Simpson intervals over the conduction window
+#define DELAY_TOLERANCE_US  1       // Table rounding
+#define POWER_TOLERANCE     0.0005  // 0.05% of full power
+
+static int failures = 0;
+
+// Relative power when firing at angle a: (2/pi) * integral of sin^2 over [a, pi]
+static double reference_power(double angle) {
+    double h = (M_PI - angle) / INTEGRATION_STEPS;
+    double sum = 0.0;
+    
+    for (int i = 0; i <= INTEGRATION_STEPS; i++) {
+        double s = sin(angle + i * h);
+        double w = (i == 0 || i == INTEGRATION_STEPS) ? 1.0 : ((i & 1) ? 4.0 : 2.0);
+        sum += w * s * s;
+    }
+    return (2.0 / M_PI) * sum * h / 3.0;
+}
+
+static double reference_angle(double power) {
+    double lo = 0.0, hi = M_PI;
+    for (int i = 0; i < 60; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (reference_power(mid) > power) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return 0.5 * (lo + hi);
+}
+
+static void check_delay_table(uint8_t frequency, double half_cycle_us) {
+    int worst = 0;
+    
+    for (int p = 0; p <= TRIAC_POWER_STEPS; p++) {
+        double expected = reference_angle(p / 100.0) / M_PI * half_cycle_us;
+        int error = abs((int)triac_table_delay_us(p, frequency) - (int)lround(expected));
+        if (error > worst) {
+            worst = error;
+        }
+        if (error > DELAY_TOLERANCE_US) {
+            printf("FAIL %dHz %d%%: table %u us, reference %.1f us\n",
+                   frequency, p, triac_table_delay_us(p, frequency), expected);
+            failures++;
+        }
+    }
+    printf("%dHz delay table: worst error %d us\n", frequency, worst);
+}
+
+static void check_power_lookup(double half_cycle_us) {
+    double worst = 0.0;
+    uint16_t last = TRIAC_POWER_Q15_ONE;
+    
+    for (uint32_t delay = 0; delay <= (uint32_t)half_cycle_us; delay += 5) {
+        uint16_t q15 = triac_table_power_q15(delay, (uint32_t)half_cycle_us);
+        double expected = reference_power(M_PI * delay / half_cycle_us);
+        double error = fabs(q15 / (double)TRIAC_POWER_Q15_ONE - expected);
+        
+        if (error > worst) {
+            worst = error;
+        }
+        if (error > POWER_TOLERANCE) {
+            printf("FAIL %.0fus half-cycle, delay %u us: lookup %.5f, reference %.5f\n",
+                   half_cycle_us, delay, q15 / (double)TRIAC_POWER_Q15_ONE, expected);
+            failures++;
+        }
+        if (q15 > last) {
+            printf("FAIL power lookup not monotonic at %u us\n", delay);
+            failures++;
+        }
+        last = q15;
+    }
+    printf("%.0fus power lookup: worst error %.5f%%\n", half_cycle_us, worst * 100.0);
+}
+
+int main(void) {
+    check_delay_table(50, 10000.0);
+    check_delay_table(60, 1000000.0 / 120.0);
+    check_power_lookup(10000.0);
+    check_power_lookup(8333.0);
+    
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,498 @@
+/**
+ * Host simulator for the triac firing path
+ * Runs the real triac_control.c interrupt handlers against virtual mains:
+ * zero-cross edges with drift, jitter, missing edges and glitches drive
+ * the GPIO interrupt, a virtual gptimer delivers the alarms, and every
+ * gate pulse is recorded. Checks firing angle, missed pulses and delivered
+ * RMS power against the requested levels, how the gates stop on a drop
+ * to 0 (ramped) and on a disable (next half-cycle), and a switch from burst
+ * back to phase control.
+ *
+ * Build and run from firmware/:
+ *   gcc -Iinclude -Itest/host test/test_triac_timing.c src/triac_control.c src/zero_cross_tracker.c src/triac_power_table.c -lm -o /tmp/test_triac_timing
+ *   /tmp/test_triac_timing
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "triac_control.h"
+#include "triac_etm.h"
+#include "driver/gptimer.h"
+
+#define ZC_PIN              10
+#define DETECTOR_LEAD_US    150     // Detector edge ahead of the true crossing
+#define SIM_TIME_US         3000000 // Simulated time per scenario
+#define SETTLE_US           500000  // Lock acquisition, not scored
+#define MAX_CROSSINGS       400
+#define MAX_PULSES          400
+
+#define ANGLE_TOLERANCE_US  40      // Worst firing-angle error against the true crossing
+#define WIDTH_TOLERANCE_US  2       // Gate pulse width error
+#define POWER_TOLERANCE     0.01    // Delivered RMS power, fraction of full power
+
+static const gpio_num_t pins[MAX_TRIACS] = { 1, 2, 3 };
+static int failures = 0;
+
+// Virtual time base: gptimer count and esp_timer in microseconds
+static uint64_t now_us = 0;
+static uint64_t alarm_at = 0;
+static bool alarm_armed = false;
+static gptimer_alarm_cb_t alarm_cb = NULL;
+static gpio_isr_t zc_isr = NULL;
+static uint32_t cycles = 0;
+
+// Recorded gate activity per channel
+typedef struct {
+    bool level;
+    uint64_t rise[MAX_PULSES];
+    uint32_t width[MAX_PULSES];
+    int pulses;
+} gate_t;
+
+static gate_t gates[MAX_TRIACS];
+
+// Mains scenario
+typedef struct {
+    const char *name;
+    double frequency;       // Hz at the start
+    double drift;           // Hz per second
+    int jitter_us;          // Detector edge noise (+/-)
+    int missing_every;      // Drop one edge in this many, 0 = none
+    int glitch_every;       // Add a glitch after one edge in this many, 0 = none
+    uint8_t power[MAX_TRIACS];
+} scenario_t;
+
+static double crossings[MAX_CROSSINGS];
+static int num_crossings = 0;
+
+// Called once from the mains loop at the first crossing after action_at
+static void (*action)(void) = NULL;
+static uint64_t action_at = 0;
+
+// --- Shims: GPIO, gptimer, clocks ---
+
+esp_err_t gpio_config(const gpio_config_t *config) { return ESP_OK; }
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num) { return ESP_OK; }
+int gpio_get_level(gpio_num_t gpio_num) { return 0; }
+esp_err_t gpio_install_isr_service(int flags) { return ESP_OK; }
+void gpio_uninstall_isr_service(void) {}
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num) { zc_isr = NULL; return ESP_OK; }
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num) { return ESP_OK; }
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num) { return ESP_OK; }
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t handler, void *arg) {
+    if (gpio_num == ZC_PIN) {
+        zc_isr = handler;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    for (int i = 0; i < MAX_TRIACS; i++) {
+        gate_t *g = &gates[i];
+        if (pins[i] != gpio_num) {
+            continue;
+        }
+        if (level && !g->level && g->pulses < MAX_PULSES) {
+            g->rise[g->pulses] = now_us;
+        } else if (!level && g->level && g->pulses < MAX_PULSES) {
+            g->width[g->pulses] = now_us - g->rise[g->pulses];
+            g->pulses++;
+        }
+        g->level = level;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gptimer_new_timer(const gptimer_config_t *config, gptimer_handle_t *ret_timer) {
+    *ret_timer = (gptimer_handle_t)&alarm_cb;
+    return ESP_OK;
+}
+esp_err_t gptimer_del_timer(gptimer_handle_t timer) { return ESP_OK; }
+esp_err_t gptimer_enable(gptimer_handle_t timer) { return ESP_OK; }
+esp_err_t gptimer_disable(gptimer_handle_t timer) { return ESP_OK; }
+esp_err_t gptimer_start(gptimer_handle_t timer) { return ESP_OK; }
+esp_err_t gptimer_stop(gptimer_handle_t timer) { alarm_armed = false; return ESP_OK; }
+
+esp_err_t gptimer_get_raw_count(gptimer_handle_t timer, uint64_t *value) {
+    *value = now_us;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_set_alarm_action(gptimer_handle_t timer, const gptimer_alarm_config_t *config) {
+    alarm_at = config->alarm_count;
+    alarm_armed = true;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_register_event_callbacks(gptimer_handle_t timer, const gptimer_event_callbacks_t *cbs,
+                                           void *user_data) {
+    alarm_cb = cbs->on_alarm;
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void) { return (int64_t)now_us; }
+uint32_t esp_cpu_get_cycle_count(void) { return cycles += 16; }
+
+// The ETM backend is not simulated here (see test_triac_etm.c)
+esp_err_t triac_etm_start(const gpio_num_t *gate_pins, uint8_t num_pins, gpio_num_t zero_cross_pin) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+esp_err_t triac_etm_apply(const triac_etm_plan_t *plan, uint32_t pin_mask) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t triac_etm_stop(void) { return ESP_OK; }
+bool triac_etm_is_running(void) { return false; }
+
+// --- Simulation ---
+
+// Relative power of a resistive load fired at angle a until the next crossing
+static double conduction_power(double angle) {
+    return 1.0 - angle / M_PI + sin(2.0 * angle) / (2.0 * M_PI);
+}
+
+static double uniform_noise(int amplitude) {
+    return amplitude ? (rand() % (2 * amplitude + 1)) - amplitude : 0.0;
+}
+
+// Advance virtual time to 'until', delivering timer alarms on the way
+static void run_timer_until(uint64_t until) {
+    while (alarm_armed && alarm_at <= until) {
+        if (alarm_at > now_us) {
+            now_us = alarm_at;
+        }
+        alarm_armed = false;
+        gptimer_alarm_event_data_t event = { .count_value = now_us, .alarm_value = alarm_at };
+        alarm_cb(NULL, &event, NULL);
+    }
+    now_us = until;
+}
+
+static void edge_at(double t) {
+    run_timer_until((uint64_t)t);
+    zc_isr(NULL);
+}
+
+// True crossings and detector edges; 'gap' silences the detector for a window
+static void run_mains(const scenario_t *s, uint64_t gap_start, uint64_t gap_end) {
+    double t = 5000.0;
+    int k = 0;
+
+    num_crossings = 0;
+    while (t < SIM_TIME_US && num_crossings < MAX_CROSSINGS) {
+        double frequency = s->frequency + s->drift * t / 1e6;
+        double half_cycle = 1e6 / (2.0 * frequency);
+        crossings[num_crossings++] = t;
+        if (action && t >= action_at) {
+            void (*run)(void) = action;
+            action = NULL;  // The action may schedule the next one
+            run_timer_until((uint64_t)t);
+            run();
+        }
+
+        double edge = t - DETECTOR_LEAD_US + uniform_noise(s->jitter_us);
+        bool silent = (t >= gap_start && t < gap_end) ||
+                      (s->missing_every && k % s->missing_every == s->missing_every / 2);
+        if (!silent) {
+            edge_at(edge);
+            if (s->glitch_every && k % s->glitch_every == s->glitch_every / 2) {
+                edge_at(edge + half_cycle / 3);
+            }
+        }
+        t += half_cycle;
+        k++;
+    }
+    run_timer_until(SIM_TIME_US);
+}
+
+static void start(const scenario_t *s) {
+    triac_config_t config = {
+        .triac_pins = { pins[0], pins[1], pins[2] },
+        .num_triacs = MAX_TRIACS,
+        .zero_cross_pin = ZC_PIN,
+        .max_power_watts = 2000,
+        .zero_cross_offset_us = DETECTOR_LEAD_US,
+        .backend = TRIAC_BACKEND_ISR,
+    };
+
+    now_us = 0;
+    alarm_armed = false;
+    memset(gates, 0, sizeof(gates));
+    srand(7);
+
+    triac_control_init(&config);
+    for (int i = 0; i < MAX_TRIACS; i++) {
+        triac_control_set_triac_power(i, s->power[i]);
+    }
+}
+
+// Crossing index of the half-cycle containing t, -1 if outside
+static int crossing_before(double t) {
+    for (int k = num_crossings - 2; k >= 0; k--) {
+        if (crossings[k] <= t) {
+            return (t < crossings[k + 1]) ? k : -1;
+        }
+    }
+    return -1;
+}
+
+static void score_channel(const scenario_t *s, int ch) {
+    const gate_t *g = &gates[ch];
+    static int pulses_in[MAX_CROSSINGS];
+    double worst_angle = 0.0, sum_angle = 0.0, power = 0.0;
+    int scored = 0, fired = 0, missed = 0, extra = 0, worst_width = 0;
+
+    memset(pulses_in, 0, sizeof(pulses_in));
+    for (int p = 0; p < g->pulses; p++) {
+        int k = crossing_before((double)g->rise[p]);
+        if (k < 0 || crossings[k] < SETTLE_US) {
+            continue;
+        }
+        double half_cycle = crossings[k + 1] - crossings[k];
+        double angle = g->rise[p] - crossings[k];
+        double error = fabs(angle - power_to_firing_delay(s->power[ch], (uint32_t)lround(half_cycle)));
+
+        if (pulses_in[k]++ == 0) {
+            fired++;
+            power += conduction_power(M_PI * angle / half_cycle);
+            sum_angle += error;
+            if (error > worst_angle) {
+                worst_angle = error;
+            }
+        } else {
+            extra++;
+        }
+        int width_error = abs((int)g->width[p] - 10);
+        if (width_error > worst_width) {
+            worst_width = width_error;
+        }
+    }
+
+    for (int k = 0; k < num_crossings - 1; k++) {
+        if (crossings[k] < SETTLE_US) {
+            continue;
+        }
+        scored++;
+        if (s->power[ch] > 0 && pulses_in[k] == 0) {
+            missed++;
+        }
+    }
+
+    double rms = scored ? power / scored : 0.0;
+    double wanted = s->power[ch] / 100.0;
+    printf("  ch%d %3d%%: angle error mean %.1f us worst %.1f us, missed %d/%d, extra %d, "
+           "RMS power %.2f%%\n", ch, s->power[ch], fired ? sum_angle / fired : 0.0, worst_angle,
+           missed, scored, extra, rms * 100.0);
+
+    if (s->power[ch] == 0) {
+        if (fired > 0) {
+            printf("FAIL %s ch%d: fired at 0%%\n", s->name, ch);
+            failures++;
+        }
+        return;
+    }
+    if (worst_angle > ANGLE_TOLERANCE_US || worst_width > WIDTH_TOLERANCE_US) {
+        printf("FAIL %s ch%d: angle error %.1f us, width error %d us\n", s->name, ch, worst_angle, worst_width);
+        failures++;
+    }
+    if (missed > 0 || extra > 0) {
+        printf("FAIL %s ch%d: %d missed and %d extra pulses\n", s->name, ch, missed, extra);
+        failures++;
+    }
+    if (fabs(rms - wanted) > POWER_TOLERANCE) {
+        printf("FAIL %s ch%d: RMS power %.2f%%, requested %d%%\n", s->name, ch, rms * 100.0, s->power[ch]);
+        failures++;
+    }
+}
+
+static void run_scenario(const scenario_t *s) {
+    start(s);
+    run_mains(s, 0, 0);
+
+    triac_diagnostics_t diag;
+    triac_control_get_diagnostics(&diag);
+    printf("%s: %dHz locked %d, missed crossings %u, spurious %u, late alarms %u\n", s->name,
+           diag.mains_frequency, diag.mains_locked, diag.missed_crossings, diag.spurious_edges,
+           diag.missed_alarms);
+    for (int ch = 0; ch < MAX_TRIACS; ch++) {
+        score_channel(s, ch);
+    }
+    if (!diag.mains_locked || diag.sync_losses != 0) {
+        printf("FAIL %s: lock %d, sync losses %u\n", s->name, diag.mains_locked, diag.sync_losses);
+        failures++;
+    }
+    triac_control_deinit();
+}
+
+// Detector silent for 200 ms: gates must stop, then fire again after re-lock
+static void check_dropout(void) {
+    const scenario_t s = { "Dropout", 50.0, 0.0, 10, 0, 0, { 60, 60, 60 } };
+    const uint64_t gap_start = 1000000, gap_end = 1200000;
+
+    start(&s);
+    run_mains(&s, gap_start, gap_end);
+
+    triac_diagnostics_t diag;
+    triac_control_get_diagnostics(&diag);
+
+    // One missing edge is bridged; the gates must be down before a second half-cycle
+    uint64_t limit = gap_start + 2 * 10000 + 10000 / 8 + 10000;
+    int late = 0, resumed = 0;
+    for (int ch = 0; ch < MAX_TRIACS; ch++) {
+        for (int p = 0; p < gates[ch].pulses; p++) {
+            uint64_t rise = gates[ch].rise[p];
+            if (rise >= limit && rise < gap_end) {
+                late++;
+            }
+            if (rise >= gap_end + 200000) {
+                resumed++;
+            }
+        }
+    }
+    printf("Dropout: sync losses %u, pulses after the cut-off %d, pulses after re-lock %d\n",
+           diag.sync_losses, late, resumed);
+    if (diag.sync_losses != 1 || late != 0 || resumed == 0) {
+        printf("FAIL dropout\n");
+        failures++;
+    }
+    triac_control_deinit();
+}
+
+static void disable_all(void) { triac_control_enable(false); }
+
+// Power reported just before the drop, then state 100 ms into the ramp-down
+static uint16_t full_watts = 0;
+static bool probe_enabled = false;
+static uint16_t probe_watts = 0;
+
+static void probe(void) {
+    probe_enabled = triac_control_is_enabled();
+    probe_watts = triac_control_get_actual_power_watts();
+}
+
+static void drop_to_zero(void) {
+    full_watts = triac_control_get_actual_power_watts();
+    triac_control_set_power(0);
+    action = probe;
+    action_at = now_us + 100000;
+}
+
+// A fail-safe trip while the loop was already ramping down to 0
+static void drop_then_disable(void) {
+    triac_control_set_power(0);
+    action = disable_all;
+    action_at = now_us + 100000;
+}
+
+// Last gate pulse on channel 0, 0 if none
+static uint64_t last_pulse(void) {
+    return gates[0].pulses ? gates[0].rise[gates[0].pulses - 1] : 0;
+}
+
+// With a 500 ms ramp, 60% falls to 0 over 300 ms; a disable stops the
+// gates by the next half-cycle (one already scheduled may still fire),
+// also in the middle of that ramp-down. The reported state follows the ramp,
+// not the command
+static void check_stop(void) {
+    const scenario_t s = { "Stop", 50.0, 0.0, 0, 0, 0, { 60, 60, 60 } };
+    const uint64_t stop_at = 1500000;
+
+    start(&s);
+    triac_control_set_ramp(500, TRIAC_RAMP_LINEAR);
+    action = drop_to_zero;
+    action_at = stop_at;
+    run_mains(&s, 0, 0);
+    uint64_t ramped = last_pulse();
+    bool enabled_after = triac_control_is_enabled();
+    uint16_t watts_after = triac_control_get_actual_power_watts();
+    triac_control_deinit();
+
+    start(&s);
+    triac_control_set_ramp(500, TRIAC_RAMP_LINEAR);
+    action = disable_all;
+    action_at = stop_at;
+    run_mains(&s, 0, 0);
+    uint64_t cut = last_pulse();
+    triac_control_deinit();
+
+    start(&s);
+    triac_control_set_ramp(500, TRIAC_RAMP_LINEAR);
+    action = drop_then_disable;
+    action_at = stop_at;
+    run_mains(&s, 0, 0);
+    uint64_t cut_ramping = last_pulse();
+    triac_control_deinit();
+
+    printf("Stop from 60%%: last pulse %.0f ms after a drop to 0, %.0f ms after a disable, "
+           "%.0f ms after a drop to 0 disabled 100 ms in\n", ((double)ramped - stop_at) / 1000.0,
+           ((double)cut - stop_at) / 1000.0, ((double)cut_ramping - stop_at) / 1000.0);
+    if (ramped < stop_at + 250000 || ramped > stop_at + 320000 || cut > stop_at + 2 * 10000 ||
+        cut_ramping < stop_at + 80000 || cut_ramping > stop_at + 100000 + 2 * 10000) {
+        printf("FAIL stop: drop to 0 not ramped, or disable not immediate\n");
+        failures++;
+    }
+    printf("Stop from 60%%: reported %u W before, %s/%u W 100 ms into the ramp-down, %s/%u W after\n",
+           full_watts, probe_enabled ? "on" : "off", probe_watts, enabled_after ? "on" : "off",
+           watts_after);
+    if (!probe_enabled || probe_watts == 0 || probe_watts >= full_watts || enabled_after ||
+        watts_after != 0) {
+        printf("FAIL stop: reported state does not follow the ramp-down\n");
+        failures++;
+    }
+}
+
+static void phase_mode(void) { triac_control_set_mode(0, TRIAC_MODE_PHASE); }
+
+// Channel 0 in burst mode holds its gate for whole cycles; switched back to
+// phase control, it fires plain pulses from the next crossing on
+static void check_mode_switch(void) {
+    const scenario_t s = { "Mode switch", 50.0, 0.0, 0, 0, 0, { 50, 0, 0 } };
+    const uint64_t switch_at = 1500000;
+    int held = 0, long_after = 0, short_after = 0;
+
+    start(&s);
+    triac_control_set_mode(0, TRIAC_MODE_BURST);
+    action = phase_mode;
+    action_at = switch_at;
+    run_mains(&s, 0, 0);
+
+    for (int p = 0; p < gates[0].pulses; p++) {
+        if (gates[0].rise[p] + gates[0].width[p] <= switch_at) {
+            held += gates[0].width[p] >= 10000;
+        } else if (gates[0].rise[p] >= switch_at) {
+            if (gates[0].width[p] > 10 + WIDTH_TOLERANCE_US) {
+                long_after++;
+            } else {
+                short_after++;
+            }
+        }
+    }
+    // A gate left held would hide every later pulse
+    printf("Mode switch: %d held burst cycles, then %d phase pulses, %d long ones\n",
+           held, short_after, long_after);
+    if (held == 0 || short_after < 140 || long_after != 0) {
+        printf("FAIL mode switch\n");
+        failures++;
+    }
+    triac_control_deinit();
+}
+
+int main(void) {
+    const scenario_t scenarios[] = {
+        { "50Hz clean",           50.0,  0.0,  0,  0,  0, { 20, 50, 90 } },
+        { "50Hz jitter",          50.0,  0.0, 20,  0,  0, {  5, 35, 75 } },
+        { "49.8Hz drifting up",   49.8,  0.1, 20,  0,  0, { 10, 60, 99 } },
+        { "60Hz missing edges",   60.0,  0.0, 15, 37,  0, { 25, 50,  0 } },
+        { "50.2Hz with glitches", 50.2, -0.1, 15,  0, 23, { 40, 80,  3 } },
+    };
+
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        run_scenario(&scenarios[i]);
+    }
+    check_dropout();
+    check_stop();
+    check_mode_switch();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
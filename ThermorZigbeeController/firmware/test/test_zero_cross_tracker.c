@@ -0,0 +1,123 @@
+/**
+ * Host test for the zero-cross tracker
+ * Feeds jittered detector edges with missing edges and glitches, and checks
+ * lock, frequency detection, prediction error and the supervision counters.
+ *
+ * Build and run from firmware/:
+ *   gcc -Iinclude test/test_zero_cross_tracker.c src/zero_cross_tracker.c -lm -o /tmp/test_zero_cross_tracker
+ *   /tmp/test_zero_cross_tracker
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "zero_cross_tracker.h"
+
+#define EDGE_JITTER_US      20      // Detector edge noise (+/-)
+#define PHASE_TOLERANCE_US  25      // Tracked crossing against the true one
+#define OFFSET_US           150     // Detector edge ahead of the true crossing
+
+static int failures = 0;
+
+// Edge-clocked run: every accepted edge starts the next half-cycle
+static void run_mains(double frequency, int crossings, int missing_every, int glitch_every) {
+    zc_tracker_t t;
+    double half_cycle = 1e6 / (2.0 * frequency);
+    int locked_at = -1;
+    int expected_missed = 0;
+    int expected_spurious = 0;
+    double worst = 0.0;
+
+    zc_tracker_init(&t, OFFSET_US);
+    srand(1);
+
+    for (int k = 0; k < crossings; k++) {
+        double crossing = 1000.0 + k * half_cycle;
+        double edge = crossing - OFFSET_US + (rand() % (2 * EDGE_JITTER_US + 1)) - EDGE_JITTER_US;
+
+        if (glitch_every && k % glitch_every == glitch_every / 2 && zc_tracker_is_locked(&t)) {
+            zc_tracker_edge(&t, (uint64_t)(edge + half_cycle / 3));
+            expected_spurious++;
+        }
+        if (missing_every && k % missing_every == missing_every / 2) {
+            if (zc_tracker_is_locked(&t)) {
+                expected_missed++;
+            }
+            continue;
+        }
+
+        zc_edge_result_t result = zc_tracker_edge(&t, (uint64_t)edge);
+        if (result == ZC_EDGE_NEXT) {
+            zc_tracker_advance(&t);
+        }
+        if (result == ZC_EDGE_LOCKED && locked_at < 0) {
+            locked_at = k;
+        }
+        if (zc_tracker_is_locked(&t) && k > 50) {
+            double error = fabs((double)t.last - crossing);
+            if (error > worst) {
+                worst = error;
+            }
+        }
+    }
+
+    double period_error = fabs(t.period_q8 / 256.0 - half_cycle);
+    printf("%.1fHz: locked at edge %d, %dHz, period error %.2f us, worst phase error %.1f us, "
+           "missed %u, spurious %u\n", frequency, locked_at, t.frequency, period_error, worst,
+           t.missed, t.spurious);
+
+    uint8_t nominal = (frequency < 55.0) ? 50 : 60;
+    if (locked_at < 0 || locked_at > ZC_LOCK_EDGES + 1 || t.frequency != nominal) {
+        printf("FAIL %.1fHz: lock at edge %d, frequency %d\n", frequency, locked_at, t.frequency);
+        failures++;
+    }
+    if (period_error > 1.0 || worst > PHASE_TOLERANCE_US) {
+        printf("FAIL %.1fHz: tracking error too large\n", frequency);
+        failures++;
+    }
+    if ((int)t.missed != expected_missed || (int)t.spurious != expected_spurious) {
+        printf("FAIL %.1fHz: counters missed %u spurious %u, expected %d and %d\n",
+               frequency, t.missed, t.spurious, expected_missed, expected_spurious);
+        failures++;
+    }
+}
+
+static void check_resync(void) {
+    zc_tracker_t t;
+    zc_tracker_init(&t, 0);
+
+    for (int k = 0; k < 10; k++) {
+        zc_edge_result_t result = zc_tracker_edge(&t, 1000 + k * 10000);
+        if (result == ZC_EDGE_NEXT) {
+            zc_tracker_advance(&t);
+        }
+    }
+    zc_tracker_edge(&t, 1000 + 9 * 10000 + 5000);   // Mid half-cycle glitch
+    uint32_t spurious = t.spurious;
+
+    zc_tracker_resync(&t);
+    if (zc_tracker_is_locked(&t) || t.spurious != spurious || spurious != 1) {
+        printf("FAIL resync: locked %d, spurious %u (was %u)\n", zc_tracker_is_locked(&t), t.spurious, spurious);
+        failures++;
+    }
+
+    // Re-acquires from fresh edges
+    for (int k = 0; k <= ZC_LOCK_EDGES; k++) {
+        zc_tracker_edge(&t, 500000 + k * 10000);
+    }
+    if (!zc_tracker_is_locked(&t)) {
+        printf("FAIL resync: no lock after %d edges\n", ZC_LOCK_EDGES + 1);
+        failures++;
+    }
+    printf("Resync: counters kept, lock re-acquired\n");
+}
+
+int main(void) {
+    run_mains(50.0, 2000, 0, 0);
+    run_mains(49.7, 2000, 97, 53);
+    run_mains(60.2, 2000, 89, 41);
+    check_resync();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+/**
+ * Host tool: cost per sample of each sensor filter stage
+ * Runs every stage type at several window sizes over the same noisy,
+ * spiky temperature trace and reports the mean time per sample, next to
+ * the moving average that re-sums its whole buffer on each sample (what
+ * temperature_sensor_read_filtered used to do). Host timings only rank the
+ * stages and show how they scale with the window; the C6 has no FPU, so
+ * absolute costs there are higher and float-heavy stages lose more.
+ *
+ * Build and run from firmware/:
+ *   gcc -O2 -Iinclude -Itest/host tools/filter_bench.c src/sensor_filter.c -lm -o /tmp/filter_bench
+ *   /tmp/filter_bench -n 2000000
+ *
+ * Options:
+ *   -n samples     samples per measurement (default 1000000)
+ *   -r rounds      measurements per stage, best one kept (default 5)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "sensor_filter.h"
+
+#define TRACE_LENGTH    4096    // Repeated over the run
+#define SAMPLE_MS       100
+
+static float g_trace[TRACE_LENGTH];
+static volatile float g_sink;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void make_trace(void) {
+    srand(1);
+    for (int i = 0; i < TRACE_LENGTH; i++) {
+        float noise = ((rand() % 2001) - 1000) / 10000.0f;  // +-0.1C
+        g_trace[i] = 21.0f + 0.5f * (i % 600) / 600.0f + noise;
+        if (rand() % 200 == 0) {
+            g_trace[i] += 30.0f;  // Occasional spike
+        }
+    }
+}
+
+// Reference: the buffer is summed again on every sample
+typedef struct {
+    float buffer[SENSOR_FILTER_MAX_WINDOW];
+    uint8_t size, index;
+    bool full;
+} resum_average_t;
+
+static float resum_apply(resum_average_t *f, float value) {
+    f->buffer[f->index] = value;
+    f->index = (f->index + 1) % f->size;
+    if (!f->full && f->index == 0) {
+        f->full = true;
+    }
+    int count = f->full ? f->size : f->index;
+    float sum = 0.0f;
+    for (int i = 0; i < count; i++) {
+        sum += f->buffer[i];
+    }
+    return sum / count;
+}
+
+static double bench_chain(const sensor_filter_stage_config_t *stages, uint8_t count,
+                          long samples, int rounds) {
+    double best = 1e30;
+    for (int r = 0; r < rounds; r++) {
+        sensor_filter_t filter;
+        sensor_filter_init(&filter, stages, count);
+        double start = now_ns();
+        for (long n = 0; n < samples; n++) {
+            g_sink = sensor_filter_apply(&filter, g_trace[n % TRACE_LENGTH], (uint32_t)n * SAMPLE_MS);
+        }
+        double ns = (now_ns() - start) / samples;
+        if (ns < best) {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+static double bench_resum(uint8_t window, long samples, int rounds) {
+    double best = 1e30;
+    for (int r = 0; r < rounds; r++) {
+        resum_average_t filter = { .size = window };
+        double start = now_ns();
+        for (long n = 0; n < samples; n++) {
+            g_sink = resum_apply(&filter, g_trace[n % TRACE_LENGTH]);
+        }
+        double ns = (now_ns() - start) / samples;
+        if (ns < best) {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    long samples = 1000000;
+    int rounds = 5;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:")) != -1) {
+        switch (opt) {
+            case 'n': samples = atol(optarg); break;
+            case 'r': rounds = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n samples] [-r rounds]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (samples <= 0 || rounds <= 0) {
+        fprintf(stderr, "samples and rounds must be positive\n");
+        return 2;
+    }
+
+    make_trace();
+    printf("%ld samples, best of %d rounds\n\n", samples, rounds);
+    printf("%-28s %10s\n", "stage", "ns/sample");
+
+    double empty = bench_chain(NULL, 0, samples, rounds);
+    printf("%-28s %10.2f\n", "empty chain (call overhead)", empty);
+
+    static const uint8_t windows[] = { 3, 8, SENSOR_FILTER_MAX_WINDOW };
+    for (size_t i = 0; i < sizeof(windows); i++) {
+        sensor_filter_stage_config_t stage = { .type = SENSOR_FILTER_MOVING_AVERAGE, .window = windows[i] };
+        char name[40];
+        snprintf(name, sizeof(name), "moving average %u", windows[i]);
+        printf("%-28s %10.2f\n", name, bench_chain(&stage, 1, samples, rounds));
+        snprintf(name, sizeof(name), "  re-summed average %u", windows[i]);
+        printf("%-28s %10.2f\n", name, bench_resum(windows[i], samples, rounds));
+    }
+
+    for (uint8_t window = 3; window <= SENSOR_FILTER_MAX_MEDIAN; window += 2) {
+        sensor_filter_stage_config_t stage = { .type = SENSOR_FILTER_MEDIAN, .window = window };
+        char name[40];
+        snprintf(name, sizeof(name), "median %u", window);
+        printf("%-28s %10.2f\n", name, bench_chain(&stage, 1, samples, rounds));
+    }
+
+    sensor_filter_stage_config_t exponential = { .type = SENSOR_FILTER_EXPONENTIAL, .alpha = 0.2f };
+    printf("%-28s %10.2f\n", "exponential", bench_chain(&exponential, 1, samples, rounds));
+
+    sensor_filter_stage_config_t rate = { .type = SENSOR_FILTER_RATE_LIMIT, .max_rate = 0.5f };
+    printf("%-28s %10.2f\n", "rate limit", bench_chain(&rate, 1, samples, rounds));
+
+    sensor_filter_stage_config_t chain[] = {
+        { .type = SENSOR_FILTER_MEDIAN, .window = 5 },
+        { .type = SENSOR_FILTER_MOVING_AVERAGE, .window = 8 },
+        { .type = SENSOR_FILTER_EXPONENTIAL, .alpha = 0.2f },
+        { .type = SENSOR_FILTER_RATE_LIMIT, .max_rate = 0.5f },
+    };
+    printf("%-28s %10.2f\n", "all four stages", bench_chain(chain, 4, samples, rounds));
+
+    return 0;
+}
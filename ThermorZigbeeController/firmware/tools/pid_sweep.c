@@ -0,0 +1,440 @@
+/**
+ * Host tool: Monte-Carlo sweep of PID gains over simulated rooms
+ * Links the firmware PID (Q16.16) and the phase-control power tables
+ * against a two-node room: the heater body warms from the elements and
+ * gives its heat to the air, the air loses heat to the outside and is
+ * read through a delayed, noisy, quantised sensor. Each scenario draws a
+ * room (air and body mass, losses, heater size, sensor lag and noise,
+ * mains frequency) and runs an eco to comfort transition from steady
+ * state. Every gain set of the grid is run on every scenario, spread over
+ * all cores, and the sets are ranked by overshoot, settling time, energy
+ * and output switching.
+ *
+ * Build and run from firmware/:
+ *   gcc -O2 -pthread -Iinclude -Itest/host tools/pid_sweep.c src/pid_controller.c src/triac_power_table.c test/host/nvs_stub.c -lm -o /tmp/pid_sweep
+ *   /tmp/pid_sweep -n 10000
+ *
+ * Options:
+ *   -n scenarios   rooms to simulate (default 1000)
+ *   -j threads     worker threads (default: online cores)
+ *   -s seed        scenario seed (default 1)
+ *   -t top         gain sets listed (default 15)
+ *   -p list        kp values, comma separated
+ *   -i list        ki values, comma separated
+ *   -d list        kd values, comma separated
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "pid_controller.h"
+#include "triac_power_table.h"
+
+#define SIM_HOURS           6       // After the transition
+#define ECO                 17.0f
+#define COMFORT             20.0f
+#define SETTLE_BAND         0.3     // Settled once it stays this close to comfort
+#define SWITCH_STEP         5       // Output moves of at least this many % count as switches
+#define NUM_ELEMENTS        3       // Staged like the firmware: whole elements, one modulated
+#define MAX_SENSOR_DELAY_S  240
+#define MAX_GAINS           32      // Values per gain axis
+#define CHUNK               16      // Runs taken by a worker at a time
+
+// Mirrors triac_control.c: firing delay for a percentage, scaled to the half-cycle
+#define MIN_FIRING_DELAY_US 100
+
+// Cost weights: a set is ranked by the sum of its normalised means
+#define COST_OVERSHOOT_C    0.2     // 0.2 C of mean overshoot costs 1
+#define COST_SETTLE_S       3600.0  // An hour of settling costs 1
+#define COST_EXCESS         0.1     // 10% energy above the minimum costs 1
+#define COST_SWITCHES       500.0   // 500 switches over the run cost 1
+#define COST_FAILED         5.0     // Per unsettled run, as a share of the scenarios
+
+typedef struct {
+    double heater_watts;
+    double body_j_per_k;     // Heater body
+    double body_w_per_k;     // Body to air
+    double room_j_per_k;     // Air and furniture
+    double room_w_per_k;     // Air to outside
+    double outside;
+    int sensor_delay_s;
+    double sensor_noise;     // Standard deviation, C
+    uint32_t half_cycle_us;
+    uint64_t seed;           // Sensor noise stream
+} scenario_t;
+
+typedef struct {
+    float overshoot;         // C above comfort
+    float settle_s;          // Last time outside the band (horizon if never inside)
+    float kwh;               // Delivered energy
+    float excess;            // Energy above the scenario's best set, fraction
+    uint32_t switches;
+    bool settled;
+} run_result_t;
+
+typedef struct {
+    float kp, ki, kd;
+} gains_t;
+
+typedef struct {
+    const scenario_t *scenarios;
+    const gains_t *gains;
+    run_result_t *results;   // [scenario][gain set]
+    uint32_t num_scenarios;
+    uint32_t num_gains;
+    uint32_t next;           // Next run to hand out
+} sweep_t;
+
+// xorshift64*: scenarios are reproducible from the seed and their index
+static inline uint64_t rng_next(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static inline double rng_uniform(uint64_t *state) {
+    return (rng_next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double rng_range(uint64_t *state, double lo, double hi) {
+    return lo + (hi - lo) * rng_uniform(state);
+}
+
+// Roughly normal (Irwin-Hall, 4 terms), cheap enough for every step
+static inline double rng_gauss(uint64_t *state) {
+    double sum = rng_uniform(state) + rng_uniform(state) + rng_uniform(state) + rng_uniform(state);
+    return (sum - 2.0) * 1.7320508;
+}
+
+static void scenario_draw(scenario_t *sc, uint64_t seed, uint32_t index) {
+    uint64_t state = seed * 0x9E3779B97F4A7C15ULL + index + 1;
+    for (int i = 0; i < 4; i++) {
+        rng_next(&state);
+    }
+
+    sc->room_j_per_k = rng_range(&state, 60e3, 400e3);
+    sc->room_w_per_k = rng_range(&state, 15.0, 80.0);
+    sc->outside = rng_range(&state, -5.0, 12.0);
+    // Panel heaters are light, oil-filled ones heavy
+    sc->heater_watts = 500.0 * (1 + (int)rng_range(&state, 0.0, 4.0));
+    sc->body_j_per_k = sc->heater_watts * rng_range(&state, 1.0, 5.0);
+    sc->body_w_per_k = sc->heater_watts / rng_range(&state, 40.0, 90.0);
+    // Enough heater to hold comfort with some margin
+    double need = 1.3 * sc->room_w_per_k * (COMFORT - sc->outside);
+    if (sc->heater_watts < need) {
+        sc->heater_watts = 500.0 * ceil(need / 500.0);
+    }
+    sc->sensor_delay_s = (int)rng_range(&state, 20.0, MAX_SENSOR_DELAY_S);
+    sc->sensor_noise = rng_range(&state, 0.01, 0.15);
+    sc->half_cycle_us = rng_uniform(&state) < 0.8 ? 10000 : 8333;
+    sc->seed = rng_next(&state) | 1;
+}
+
+// Delivered fraction of full power for each heater-wide percentage, through
+// the firmware's delay table and its RMS power table, staged over the elements
+static void power_map(const scenario_t *sc, float map[101]) {
+    uint8_t frequency = sc->half_cycle_us < 9100 ? 60 : 50;
+    uint32_t nominal = frequency == 60 ? 8333 : 10000;
+
+    float element[101];
+    element[0] = 0.0f;
+    for (int p = 1; p <= 100; p++) {
+        uint32_t delay = (triac_table_delay_us(p, frequency) * sc->half_cycle_us + nominal / 2) / nominal;
+        if (delay < MIN_FIRING_DELAY_US) {
+            delay = MIN_FIRING_DELAY_US;
+        }
+        element[p] = triac_table_power_q15(delay, sc->half_cycle_us) / (float)TRIAC_POWER_Q15_ONE;
+    }
+    for (int p = 0; p <= 100; p++) {
+        int remaining = p * NUM_ELEMENTS;
+        float sum = 0.0f;
+        for (int k = 0; k < NUM_ELEMENTS; k++) {
+            int level = remaining > 100 ? 100 : remaining;
+            sum += element[level];
+            remaining -= level;
+        }
+        map[p] = sum / NUM_ELEMENTS;
+    }
+}
+
+static void run(const scenario_t *sc, const gains_t *gains, run_result_t *result) {
+    float map[101];
+    float history[MAX_SENSOR_DELAY_S];
+    uint64_t noise = sc->seed;
+    pid_controller_t pid;
+    const pid_config_t config = {
+        .kp = gains->kp, .ki = gains->ki, .kd = gains->kd,
+        .output_min = 0.0f, .output_max = 100.0f, .sample_time_ms = 1000,
+    };
+
+    power_map(sc, map);
+
+    // Steady state at eco: the air holds ECO, the body the heat it passes on
+    double loss = sc->room_w_per_k * (ECO - sc->outside);
+    double room = ECO;
+    double body = ECO + loss / sc->body_w_per_k;
+    float holding = (float)(100.0 * loss / sc->heater_watts);
+    for (int i = 0; i < sc->sensor_delay_s; i++) {
+        history[i] = ECO;
+    }
+    int head = 0;
+
+    pid_controller_init(&pid, &config);
+    pid.integral = (int64_t)pid_q16_from_float(holding) << PID_Q24_SHIFT;
+    pid.last_output = pid_q16_from_float(holding);
+    pid.last_input = pid_q16_from_float(ECO);
+    pid.first_run = false;
+
+    memset(result, 0, sizeof(*result));
+    double joules = 0.0;
+    int last_percent = (int)holding;
+    int last_outside = 0;
+    const int horizon = SIM_HOURS * 3600;
+
+    for (int s = 0; s < horizon; s++) {
+        float reading = history[head] + (float)(sc->sensor_noise * rng_gauss(&noise));
+        reading = roundf(reading * 100.0f) / 100.0f;
+        int percent = (int)pid_controller_compute(&pid, COMFORT, reading);
+
+        double watts = sc->heater_watts * map[percent];
+        double to_room = sc->body_w_per_k * (body - room);
+        body += (watts - to_room) / sc->body_j_per_k;
+        room += (to_room - sc->room_w_per_k * (room - sc->outside)) / sc->room_j_per_k;
+        history[head] = (float)room;
+        head = (head + 1) % sc->sensor_delay_s;
+
+        joules += watts;
+        if (abs(percent - last_percent) >= SWITCH_STEP) {
+            result->switches++;
+            last_percent = percent;
+        }
+        if (room - COMFORT > result->overshoot) {
+            result->overshoot = (float)(room - COMFORT);
+        }
+        if (fabs(room - COMFORT) > SETTLE_BAND) {
+            last_outside = s + 1;
+        }
+    }
+
+    result->kwh = (float)(joules / 3.6e6);
+    result->settled = last_outside < horizon - 3600;  // Inside the band for the last hour
+    result->settle_s = result->settled ? (float)last_outside : (float)horizon;
+}
+
+static void *sweep_worker(void *arg) {
+    sweep_t *sweep = arg;
+    uint32_t total = sweep->num_scenarios * sweep->num_gains;
+
+    for (;;) {
+        uint32_t first = __atomic_fetch_add(&sweep->next, CHUNK, __ATOMIC_RELAXED);
+        if (first >= total) {
+            break;
+        }
+        uint32_t last = first + CHUNK < total ? first + CHUNK : total;
+        for (uint32_t r = first; r < last; r++) {
+            uint32_t sc = r / sweep->num_gains;
+            uint32_t g = r % sweep->num_gains;
+            run(&sweep->scenarios[sc], &sweep->gains[g], &sweep->results[r]);
+        }
+    }
+    return NULL;
+}
+
+typedef struct {
+    gains_t gains;
+    double overshoot_mean, overshoot_p95;
+    double settle_mean, settle_p95;
+    double kwh_mean, excess_mean;
+    double switches_mean;
+    uint32_t failed;
+    double cost;
+} ranking_t;
+
+static int compare_float(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_cost(const void *a, const void *b) {
+    double x = ((const ranking_t *)a)->cost, y = ((const ranking_t *)b)->cost;
+    return (x > y) - (x < y);
+}
+
+static double percentile95(float *values, uint32_t n) {
+    qsort(values, n, sizeof(float), compare_float);
+    return values[(uint32_t)(0.95 * (n - 1))];
+}
+
+static void rank(const sweep_t *sweep, ranking_t *ranking) {
+    uint32_t n = sweep->num_scenarios;
+    float *overshoots = malloc(n * sizeof(float));
+    float *settles = malloc(n * sizeof(float));
+
+    // Energy against the frugal end of the grid on the same room
+    for (uint32_t sc = 0; sc < n; sc++) {
+        run_result_t *row = &sweep->results[sc * sweep->num_gains];
+        float best = row[0].kwh;
+        for (uint32_t g = 1; g < sweep->num_gains; g++) {
+            if (row[g].kwh < best) {
+                best = row[g].kwh;
+            }
+        }
+        for (uint32_t g = 0; g < sweep->num_gains; g++) {
+            row[g].excess = best > 0.0f ? row[g].kwh / best - 1.0f : 0.0f;
+        }
+    }
+
+    for (uint32_t g = 0; g < sweep->num_gains; g++) {
+        ranking_t *rk = &ranking[g];
+        memset(rk, 0, sizeof(*rk));
+        rk->gains = sweep->gains[g];
+        for (uint32_t sc = 0; sc < n; sc++) {
+            const run_result_t *res = &sweep->results[sc * sweep->num_gains + g];
+            overshoots[sc] = res->overshoot;
+            settles[sc] = res->settle_s;
+            rk->overshoot_mean += res->overshoot;
+            rk->settle_mean += res->settle_s;
+            rk->kwh_mean += res->kwh;
+            rk->excess_mean += res->excess;
+            rk->switches_mean += res->switches;
+            rk->failed += !res->settled;
+        }
+        rk->overshoot_mean /= n;
+        rk->settle_mean /= n;
+        rk->kwh_mean /= n;
+        rk->excess_mean /= n;
+        rk->switches_mean /= n;
+        rk->overshoot_p95 = percentile95(overshoots, n);
+        rk->settle_p95 = percentile95(settles, n);
+        rk->cost = rk->overshoot_mean / COST_OVERSHOOT_C + rk->settle_mean / COST_SETTLE_S +
+                   rk->excess_mean / COST_EXCESS + rk->switches_mean / COST_SWITCHES +
+                   COST_FAILED * rk->failed / n;
+    }
+    qsort(ranking, sweep->num_gains, sizeof(ranking_t), compare_cost);
+
+    free(overshoots);
+    free(settles);
+}
+
+static int parse_list(const char *arg, float *values) {
+    int n = 0;
+    char *copy = strdup(arg);
+    for (char *tok = strtok(copy, ","); tok && n < MAX_GAINS; tok = strtok(NULL, ",")) {
+        values[n++] = strtof(tok, NULL);
+    }
+    free(copy);
+    return n;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    // Around the firmware defaults and the SIMC / relay-tuned ranges
+    float kp[MAX_GAINS] = { 5, 10, 15, 20, 30, 40, 60, 80 };
+    float ki[MAX_GAINS] = { 0.002f, 0.005f, 0.01f, 0.02f, 0.05f, 0.1f };
+    float kd[MAX_GAINS] = { 0 };
+    int nkp = 8, nki = 6, nkd = 1;
+    uint32_t num_scenarios = 1000;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t seed = 1;
+    int top = 15;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:j:s:t:p:i:d:")) != -1) {
+        switch (opt) {
+        case 'n': num_scenarios = strtoul(optarg, NULL, 10); break;
+        case 'j': threads = strtol(optarg, NULL, 10); break;
+        case 's': seed = strtoull(optarg, NULL, 10); break;
+        case 't': top = atoi(optarg); break;
+        case 'p': nkp = parse_list(optarg, kp); break;
+        case 'i': nki = parse_list(optarg, ki); break;
+        case 'd': nkd = parse_list(optarg, kd); break;
+        default:
+            fprintf(stderr, "usage: %s [-n scenarios] [-j threads] [-s seed] [-t top] "
+                    "[-p kp,..] [-i ki,..] [-d kd,..]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (num_scenarios == 0 || nkp == 0 || nki == 0 || nkd == 0) {
+        fprintf(stderr, "nothing to sweep\n");
+        return 2;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    sweep_t sweep = {
+        .num_scenarios = num_scenarios,
+        .num_gains = nkp * nki * nkd,
+    };
+    scenario_t *scenarios = malloc(num_scenarios * sizeof(scenario_t));
+    gains_t *gains = malloc(sweep.num_gains * sizeof(gains_t));
+    sweep.results = malloc((size_t)num_scenarios * sweep.num_gains * sizeof(run_result_t));
+    if (!scenarios || !gains || !sweep.results) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < num_scenarios; i++) {
+        scenario_draw(&scenarios[i], seed, i);
+    }
+    int g = 0;
+    for (int a = 0; a < nkp; a++) {
+        for (int b = 0; b < nki; b++) {
+            for (int c = 0; c < nkd; c++) {
+                gains[g++] = (gains_t){ kp[a], ki[b], kd[c] };
+            }
+        }
+    }
+    sweep.scenarios = scenarios;
+    sweep.gains = gains;
+
+    printf("%u scenarios x %u gain sets, %ld threads, %d h each\n",
+           num_scenarios, sweep.num_gains, threads, SIM_HOURS);
+    double start = now_s();
+    pthread_t *workers = malloc(threads * sizeof(pthread_t));
+    for (long t = 0; t < threads; t++) {
+        pthread_create(&workers[t], NULL, sweep_worker, &sweep);
+    }
+    for (long t = 0; t < threads; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    double elapsed = now_s() - start;
+    uint64_t runs = (uint64_t)num_scenarios * sweep.num_gains;
+    printf("%" PRIu64 " runs in %.1f s (%.0f simulated hours/s)\n\n",
+           runs, elapsed, runs * (double)SIM_HOURS / elapsed);
+
+    ranking_t *ranking = malloc(sweep.num_gains * sizeof(ranking_t));
+    rank(&sweep, ranking);
+
+    printf("rank     kp       ki     kd | overshoot C  | settling min  |  kWh  excess | switches | unsettled | cost\n");
+    printf("                            |  mean   p95  |  mean   p95   |              |          |           |\n");
+    for (int r = 0; r < top && r < (int)sweep.num_gains; r++) {
+        const ranking_t *rk = &ranking[r];
+        printf("%4d %6.1f %8.4f %6.1f | %5.2f %5.2f  | %5.0f %5.0f   | %5.2f %5.1f%% | %8.0f | %9u | %.2f\n",
+               r + 1, rk->gains.kp, rk->gains.ki, rk->gains.kd,
+               rk->overshoot_mean, rk->overshoot_p95,
+               rk->settle_mean / 60.0, rk->settle_p95 / 60.0,
+               rk->kwh_mean, rk->excess_mean * 100.0, rk->switches_mean,
+               rk->failed, rk->cost);
+    }
+
+    free(ranking);
+    free(workers);
+    free(sweep.results);
+    free(gains);
+    free(scenarios);
+    return 0;
+}
@@ -0,0 +1,252 @@
+/**
+ * @file adaptive_start.c
+ * @brief Adaptive-start (optimum start) preheating for scheduled comfort periods
+ */
+
+#include "adaptive_start.h"
+#include <math.h>
+#include "nvs.h"
+
+static const char *TAG = "adaptive_start";
+
+#define NVS_NAMESPACE       "adaptive"
+#define NVS_KEY_MODEL       "model"
+
+#define RLS_FORGETTING      0.9f    // Per run: older runs (seasons) fade out
+// Initial covariance, in units of the run-to-run noise variance, (0.01 °C/min)^2
+#define RLS_P0              25.0f   // Rate known to about 0.05 °C/min
+#define DEFAULT_RATE        0.04f   // 2.4 °C/h
+
+// Stored model: rate in fixed units, 4 bytes
+typedef struct __attribute__((packed)) {
+    int16_t rate_q;         // Rate in 1e-4 °C/min
+    uint16_t runs;          // Runs learned from
+} adaptive_model_t;
+
+// Model state
+static float s_rate = DEFAULT_RATE;
+static float s_p = RLS_P0;
+static uint16_t s_runs = 0;
+
+// Heat-up run being observed
+static bool s_run_active = false;
+static float s_run_start_temp = 0.0f;
+static float s_run_target = 0.0f;
+static uint32_t s_run_start_s = 0;
+
+static int16_t to_q(float value, float unit)
+{
+    float q = roundf(value / unit);
+    if (q > INT16_MAX) return INT16_MAX;
+    if (q < INT16_MIN) return INT16_MIN;
+    return (int16_t)q;
+}
+
+/**
+ * @brief Load the learned coefficients from NVS (defaults if none)
+ */
+esp_err_t adaptive_start_init(void)
+{
+    nvs_handle_t handle;
+    adaptive_model_t model;
+    size_t length = sizeof(model);
+
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGI(TAG, "No learned heat-up model, using defaults");
+        return ESP_OK;
+    }
+
+    ret = nvs_get_blob(handle, NVS_KEY_MODEL, &model, &length);
+    nvs_close(handle);
+    if (ret != ESP_OK || length != sizeof(model)) {
+        ESP_LOGI(TAG, "No learned heat-up model, using defaults");
+        return ESP_OK;
+    }
+
+    s_rate = model.rate_q * 1e-4f;
+    s_runs = model.runs;
+
+    // The covariance is not stored: confidence grows with the runs seen
+    s_p = RLS_P0 / (1.0f + (s_runs < 10 ? s_runs : 10));
+
+    ESP_LOGI(TAG, "Heat-up model loaded: %.4f °C/min (%u runs)", s_rate, s_runs);
+    return ESP_OK;
+}
+
+/**
+ * @brief Persist the learned coefficients to NVS
+ */
+esp_err_t adaptive_start_save(void)
+{
+    adaptive_model_t model = {
+        .rate_q = to_q(s_rate, 1e-4f),
+        .runs = s_runs,
+    };
+    nvs_handle_t handle;
+
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = nvs_set_blob(handle, NVS_KEY_MODEL, &model, sizeof(model));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return ret;
+}
+
+float adaptive_start_get_rate(void)
+{
+    return s_rate;
+}
+
+uint32_t adaptive_start_lead_minutes(float current, float target)
+{
+    if (target <= current) {
+        return 0;
+    }
+
+    float rate = s_rate;
+    if (rate < ADAPTIVE_START_MIN_RATE) {
+        rate = ADAPTIVE_START_MIN_RATE;
+    }
+
+    float lead = (target - current) / rate + ADAPTIVE_START_MARGIN_MIN;
+    if (lead > ADAPTIVE_START_MAX_LEAD_MIN) {
+        lead = ADAPTIVE_START_MAX_LEAD_MIN;
+    }
+    return (uint32_t)ceilf(lead);
+}
+
+/**
+ * @brief One recursive least squares step with forgetting
+ *
+ * Observation: rate, regressor 1. With forgetting, the gain settles at
+ * 1 - RLS_FORGETTING: a running average that weighs recent runs most.
+ */
+static void learn(float rate)
+{
+    float gain = s_p / (RLS_FORGETTING + s_p);
+
+    s_rate += gain * (rate - s_rate);
+    s_p = (s_p - gain * s_p) / RLS_FORGETTING;
+
+    // Heating never cools the room
+    if (s_rate < ADAPTIVE_START_MIN_RATE) s_rate = ADAPTIVE_START_MIN_RATE;
+    if (s_runs < UINT16_MAX) s_runs++;
+}
+
+/**
+ * @brief Track heat-up runs; call once per second from the control loop
+ */
+bool adaptive_start_update(float current, float target, bool heating, uint32_t now_s)
+{
+    if (!s_run_active) {
+        // A run starts when heating begins well below a new setpoint
+        if (heating && target - current >= ADAPTIVE_START_MIN_GAP) {
+            s_run_active = true;
+            s_run_start_temp = current;
+            s_run_target = target;
+            s_run_start_s = now_s;
+        }
+        return false;
+    }
+
+    uint32_t minutes = (now_s - s_run_start_s) / 60;
+
+    // Anything that disturbs the climb spoils the observation
+    if (!heating || target != s_run_target || minutes > ADAPTIVE_START_MAX_RUN_MIN) {
+        s_run_active = false;
+        return false;
+    }
+
+    if (current < s_run_target - TEMP_HYSTERESIS) {
+        return false;
+    }
+
+    s_run_active = false;
+    if (minutes < ADAPTIVE_START_MIN_RUN_MIN) {
+        return false;
+    }
+
+    float rate = (current - s_run_start_temp) / ((now_s - s_run_start_s) / 60.0f);
+    learn(rate);
+
+    ESP_LOGI(TAG, "Heat-up run: %.3f °C/min, model %.4f °C/min", rate, s_rate);
+    return true;
+}
+
+// Active slots: a mode and a usable setpoint
+static bool slot_active(const schedule_entry_t *entry)
+{
+    return entry->mode != MODE_OFF && entry->temperature >= TEMP_MIN_CELSIUS;
+}
+
+/**
+ * @brief Find the next upward setpoint transition in the weekly schedule
+ */
+bool adaptive_start_next_transition(const schedule_entry_t schedule[7][6], const struct tm *now,
+                                    float current, uint32_t *minutes_out, float *target_out)
+{
+    int today = (now->tm_wday + 6) % 7;  // Monday first
+    int now_min = now->tm_hour * 60 + now->tm_min;
+    bool found = false;
+
+    // The lead never exceeds a few hours: today and tomorrow are enough
+    for (int d = 0; d < 2; d++) {
+        for (int slot = 0; slot < 6; slot++) {
+            const schedule_entry_t *entry = &schedule[(today + d) % 7][slot];
+            if (!slot_active(entry) || entry->temperature <= current + TEMP_HYSTERESIS) {
+                continue;
+            }
+
+            int minutes = d * 1440 + entry->hour * 60 + entry->minute - now_min;
+            if (minutes <= 0 || minutes > ADAPTIVE_START_MAX_LEAD_MIN) {
+                continue;
+            }
+            if (!found || (uint32_t)minutes < *minutes_out) {
+                *minutes_out = minutes;
+                *target_out = entry->temperature;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Find the schedule slot in force
+ */
+bool adaptive_start_slot_in_force(const schedule_entry_t schedule[7][6], const struct tm *now,
+                                  int *slot_out, float *target_out)
+{
+    int today = (now->tm_wday + 6) % 7;  // Monday first
+    int now_min = now->tm_hour * 60 + now->tm_min;
+
+    // Today up to now, then whole days backwards (back to today's later
+    // slots a week ago): the latest start wins
+    for (int d = 0; d <= 7; d++) {
+        int day = (today + 7 - d) % 7;
+        int best = -1, best_start = -1;
+        for (int slot = 0; slot < 6; slot++) {
+            const schedule_entry_t *entry = &schedule[day][slot];
+            int start = entry->hour * 60 + entry->minute;
+            if (!slot_active(entry) || (d == 0 && start > now_min)) {
+                continue;
+            }
+            if (start > best_start) {
+                best = slot;
+                best_start = start;
+            }
+        }
+        if (best >= 0) {
+            *slot_out = day * 6 + best;
+            *target_out = schedule[day][best].temperature;
+            return true;
+        }
+    }
+    return false;
+}
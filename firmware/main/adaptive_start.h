@@ -0,0 +1,87 @@
+/**
+ * @file adaptive_start.h
+ * @brief Adaptive-start (optimum start) preheating for scheduled comfort periods
+ *
+ * Learns the room's heat-up rate from past heat-up runs and starts heating
+ * early enough to reach the next comfort setpoint on time. The rate is a
+ * single figure in °C per minute, fitted by recursive least squares with
+ * forgetting, one observation per completed run. Nothing in this firmware
+ * measures the outdoor temperature, so the rate does not depend on the
+ * indoor/outdoor difference: the forgetting lets it follow the seasons.
+ */
+
+#ifndef ADAPTIVE_START_H
+#define ADAPTIVE_START_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "esp_err.h"
+#include "thermor_zigbee.h"
+
+#define ADAPTIVE_START_MIN_GAP          1.0f    // Smallest heat-up (°C) worth learning from
+#define ADAPTIVE_START_MIN_RUN_MIN      10      // Shorter runs are too noisy to learn from
+#define ADAPTIVE_START_MAX_RUN_MIN      360     // Longer runs are abandoned
+#define ADAPTIVE_START_MARGIN_MIN       10      // Extra lead for the heater's own warm-up
+#define ADAPTIVE_START_MAX_LEAD_MIN     240     // Never start earlier than this
+#define ADAPTIVE_START_MIN_RATE         0.005f  // °C/min floor for the lead computation
+
+/**
+ * @brief Load the learned coefficients from NVS (defaults if none)
+ */
+esp_err_t adaptive_start_init(void);
+
+/**
+ * @brief Persist the learned coefficients to NVS
+ */
+esp_err_t adaptive_start_save(void);
+
+/**
+ * @brief Learned heat-up rate in °C per minute
+ */
+float adaptive_start_get_rate(void);
+
+/**
+ * @brief Minutes of heating needed to go from current to target
+ */
+uint32_t adaptive_start_lead_minutes(float current, float target);
+
+/**
+ * @brief Track heat-up runs; call once per second from the control loop
+ *
+ * @param current  Indoor temperature
+ * @param target   Setpoint in force
+ * @param heating  Heating is on and nothing (open window...) disturbs the run
+ * @param now_s    Monotonic time in seconds
+ * @return true when a run was learned from; the caller persists the model
+ *         with adaptive_start_save() once it no longer holds any lock
+ */
+bool adaptive_start_update(float current, float target, bool heating, uint32_t now_s);
+
+/**
+ * @brief Find the next upward setpoint transition in the weekly schedule
+ *
+ * @param schedule     Weekly schedule (7 days x 6 slots, Monday first)
+ * @param now          Local time
+ * @param current      Setpoint in force now; only higher entries count
+ * @param minutes_out  Minutes until the transition
+ * @param target_out   Setpoint of the transition
+ * @return true if one is found within ADAPTIVE_START_MAX_LEAD_MIN
+ */
+bool adaptive_start_next_transition(const schedule_entry_t schedule[7][6], const struct tm *now,
+                                    float current, uint32_t *minutes_out, float *target_out);
+
+/**
+ * @brief Find the schedule slot in force: the latest one started, looking
+ *        back up to a week
+ *
+ * @param schedule     Weekly schedule (7 days x 6 slots, Monday first)
+ * @param now          Local time
+ * @param slot_out     Slot index (day * 6 + slot), changes at each slot start
+ * @param target_out   Setpoint of the slot
+ * @return true if the schedule has any active slot
+ */
+bool adaptive_start_slot_in_force(const schedule_entry_t schedule[7][6], const struct tm *now,
+                                  int *slot_out, float *target_out);
+
+#endif // ADAPTIVE_START_H
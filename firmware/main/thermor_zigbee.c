@@ -5,6 +5,9 @@
  */
 
 #include "thermor_zigbee.h"
+#include "adaptive_start.h"
+#include <time.h>
+#include <sys/time.h>
 #include "esp_timer.h"
 #include "esp_random.h"
 #include "nvs_flash.h"
@@ -29,6 +32,18 @@ static TaskHandle_t zigbee_task_handle = NULL;
 static esp_timer_handle_t system_timer = NULL;
 static nvs_handle_t nvs_handle = 0;
 
+// Wall clock, set from outside (see thermor_set_time)
+static bool clock_set = false;
+static int32_t utc_offset_s = 0;
+
+// PROGRAM mode: slot whose setpoint was last applied (-1: none)
+static int schedule_slot = -1;
+
+// Adaptive start: a PROGRAM setpoint raised ahead of the next comfort slot
+static bool preheat_active = false;
+static float preheat_base_target = 0.0f;
+static time_t preheat_until = 0;
+
 // Forward declarations
 static void main_task(void *pvParameters);
 static void temperature_task(void *pvParameters);
@@ -38,6 +53,7 @@ static void system_timer_callback(void *arg);
 static esp_err_t gpio_init(void);
 static esp_err_t load_default_config(void);
 static esp_err_t init_nvs(void);
+static bool adaptive_start_tick(void);
 
 /**
  * @brief Initialize the Thermor Zigbee system
@@ -86,6 +102,9 @@ esp_err_t thermor_zigbee_init(void)
         }
     }
     
+    // Learned heat-up model for adaptive start
+    adaptive_start_init();
+    
     // Create system timer
     esp_timer_create_args_t timer_args = {
         .callback = system_timer_callback,
@@ -194,12 +213,14 @@ static void main_task(void *pvParameters)
 {
     system_event_t event;
     TickType_t last_wake_time = xTaskGetTickCount();
+    bool save_model;
     
     ESP_LOGI(TAG, "Main task started");
     
     while (1) {
         // Wait for events with timeout
         if (xQueueReceive(g_event_queue, &event, pdMS_TO_TICKS(100)) == pdTRUE) {
+            save_model = false;
             xSemaphoreTake(g_config_mutex, portMAX_DELAY);
             
             switch (event.type) {
@@ -232,11 +253,20 @@ static void main_task(void *pvParameters)
                     // Handle Zigbee commands
                     break;
                     
+                case EVENT_TIMER_TICK:
+                    save_model = adaptive_start_tick();
+                    break;
+                    
                 default:
                     break;
             }
             
             xSemaphoreGive(g_config_mutex);
+            
+            // NVS write, kept out of the config lock
+            if (save_model && adaptive_start_save() != ESP_OK) {
+                ESP_LOGW(TAG, "Failed to save heat-up model");
+            }
         }
         
         // Perform control logic every 100ms
@@ -353,7 +383,8 @@ static void zigbee_task(void *pvParameters)
     ESP_LOGI(TAG, "Zigbee task started");
     
     // Initialize Zigbee stack
-    // Placeholder for actual Zigbee implementation
+    // Placeholder for actual Zigbee implementation; Time cluster reads are
+    // to feed thermor_set_time(), which PROGRAM mode waits for
     
     while (1) {
         // Handle Zigbee communication
@@ -372,6 +403,86 @@ static void system_timer_callback(void *arg)
     xQueueSend(g_event_queue, &event, 0);
 }
 
+/**
+ * @brief Schedule and adaptive start, once per second
+ *
+ * In PROGRAM mode each slot's setpoint is applied when the slot begins; a
+ * setpoint changed by hand holds until the next slot. Adaptive start raises
+ * the setpoint early for an upcoming warmer slot, and the slot after it
+ * brings it down again. Both stay idle until the wall clock is set
+ * (thermor_set_time). Called with g_config_mutex held.
+ *
+ * @return true when the heat-up model learned from a run and should be saved
+ */
+static bool adaptive_start_tick(void)
+{
+    temperature_data_t *temperature = &g_system_config.temperature;
+    bool learned = false;
+    
+    if (temperature->valid) {
+        learned = adaptive_start_update(temperature->current, temperature->target,
+                                        g_system_config.state == STATE_HEATING &&
+                                        !g_system_config.presence.window_open,
+                                        thermor_get_uptime_seconds());
+    }
+    
+    // The schedule needs the wall clock
+    time_t now = time(NULL);
+    time_t local_now = now + utc_offset_s;
+    struct tm local;
+    gmtime_r(&local_now, &local);
+    bool program = g_system_config.mode == MODE_PROGRAM && clock_set;
+    
+    int slot;
+    float scheduled;
+    if (!program || !adaptive_start_slot_in_force(g_system_config.schedule, &local,
+                                                  &slot, &scheduled)) {
+        schedule_slot = -1;
+    } else if (slot != schedule_slot) {
+        schedule_slot = slot;
+        temperature->target = scheduled;
+        preheat_active = false;  // The slot preheated for has begun
+        ESP_LOGI(TAG, "Schedule: setpoint %.1f°C", scheduled);
+    }
+    
+    bool usable = program && schedule_slot >= 0 && g_system_config.adaptive_start;
+    
+    if (preheat_active) {
+        if (!usable) {
+            // Cancelled before the slot began: back to the setpoint in force
+            temperature->target = preheat_base_target;
+            preheat_active = false;
+        } else if (now >= preheat_until) {
+            // Slot start passed without a slot change (two slots at the same time)
+            preheat_active = false;
+        }
+        return learned;
+    }
+    
+    // Preheat only ahead of a slot the schedule will also end
+    if (!usable || !temperature->valid) {
+        return learned;
+    }
+    
+    uint32_t minutes;
+    float next_target;
+    if (!adaptive_start_next_transition(g_system_config.schedule, &local, temperature->target,
+                                        &minutes, &next_target)) {
+        return learned;
+    }
+    
+    uint32_t lead = adaptive_start_lead_minutes(temperature->current, next_target);
+    if (minutes <= lead) {
+        preheat_active = true;
+        preheat_base_target = temperature->target;
+        preheat_until = now + (time_t)minutes * 60 - local.tm_sec;
+        temperature->target = next_target;
+        ESP_LOGI(TAG, "Preheating to %.1f°C, %lu min ahead of schedule (lead %lu min)",
+                 next_target, (unsigned long)minutes, (unsigned long)lead);
+    }
+    return learned;
+}
+
 /**
  * @brief Initialize GPIO pins
  */
@@ -616,9 +727,13 @@ esp_err_t thermor_set_mode(heating_mode_t mode)
             break;
     }
     
+    bool idle = mode == MODE_PROGRAM && !clock_set;
     xSemaphoreGive(g_config_mutex);
     
     ESP_LOGI(TAG, "Mode changed to %s", thermor_mode_to_string(mode));
+    if (idle) {
+        ESP_LOGW(TAG, "Wall clock not set: the schedule waits for it");
+    }
     return ESP_OK;
 }
 
@@ -659,6 +774,49 @@ esp_err_t thermor_set_power_percent(uint8_t percent)
     return ESP_OK;
 }
 
+// System control functions
+esp_err_t thermor_set_adaptive_start(bool enable)
+{
+    xSemaphoreTake(g_config_mutex, portMAX_DELAY);
+    g_system_config.adaptive_start = enable;
+    xSemaphoreGive(g_config_mutex);
+    
+    ESP_LOGI(TAG, "Adaptive start %s", enable ? "enabled" : "disabled");
+    return ESP_OK;
+}
+
+// Wall clock functions
+esp_err_t thermor_set_time(time_t utc, int32_t offset_s)
+{
+    // Before 2020 is an unset clock on the sender's side; offsets span UTC-12..UTC+14
+    if (utc < 1577836800 || offset_s < -12 * 3600 || offset_s > 14 * 3600) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    struct timeval tv = { .tv_sec = utc };
+    settimeofday(&tv, NULL);
+    
+    xSemaphoreTake(g_config_mutex, portMAX_DELAY);
+    bool first = !clock_set;
+    clock_set = true;
+    utc_offset_s = offset_s;
+    xSemaphoreGive(g_config_mutex);
+    
+    if (first) {
+        ESP_LOGI(TAG, "Wall clock set (UTC%+ld min)", (long)(offset_s / 60));
+    }
+    return ESP_OK;
+}
+
+bool thermor_is_time_set(void)
+{
+    bool set;
+    xSemaphoreTake(g_config_mutex, portMAX_DELAY);
+    set = clock_set;
+    xSemaphoreGive(g_config_mutex);
+    return set;
+}
+
 // System state function
 system_state_t thermor_get_system_state(void)
 {
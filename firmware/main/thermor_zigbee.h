@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <time.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -213,6 +214,13 @@ esp_err_t thermor_set_schedule(uint8_t day, uint8_t slot, schedule_entry_t *entr
 esp_err_t thermor_get_schedule(uint8_t day, uint8_t slot, schedule_entry_t *entry);
 esp_err_t thermor_clear_schedule(void);
 
+// Wall Clock
+// Nothing on the board keeps the time: PROGRAM mode and adaptive start stay
+// idle until it is set, e.g. from the Zigbee Time cluster (UTC and the
+// local offset, DST included). Lost on reboot.
+esp_err_t thermor_set_time(time_t utc, int32_t utc_offset_s);
+bool thermor_is_time_set(void);
+
 // System Control
 esp_err_t thermor_set_child_lock(bool enable);
 esp_err_t thermor_set_adaptive_start(bool enable);
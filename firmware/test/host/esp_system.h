@@ -0,0 +1,5 @@
+// Host stand-in for esp_system.h: nothing the host modules use
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#endif // HOST_ESP_SYSTEM_H
@@ -0,0 +1,16 @@
+// Host stand-in for FreeRTOS.h, for single-threaded host builds
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdTRUE          1
+#define pdFALSE         0
+#define portMAX_DELAY   ((TickType_t)0xffffffff)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#endif // HOST_FREERTOS_H
@@ -0,0 +1,9 @@
+// Host stand-in for FreeRTOS queue.h: handle type only
+#ifndef HOST_FREERTOS_QUEUE_H
+#define HOST_FREERTOS_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *QueueHandle_t;
+
+#endif // HOST_FREERTOS_QUEUE_H
@@ -0,0 +1,9 @@
+// Host stand-in for FreeRTOS semphr.h: handle type only
+#ifndef HOST_FREERTOS_SEMPHR_H
+#define HOST_FREERTOS_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *SemaphoreHandle_t;
+
+#endif // HOST_FREERTOS_SEMPHR_H
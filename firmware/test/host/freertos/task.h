@@ -0,0 +1,9 @@
+// Host stand-in for FreeRTOS task.h: handle type only
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+
+#endif // HOST_FREERTOS_TASK_H
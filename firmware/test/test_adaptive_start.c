@@ -0,0 +1,243 @@
+/**
+ * Host test for adaptive start
+ * Checks the schedule lookups (next warmer slot, slot in force) across day
+ * and week boundaries, the lead time from the default model, and the
+ * recursive least squares fit on simulated heat-up runs of a known room,
+ * including the runs it must ignore, a change of season and the NVS round
+ * trip.
+ *
+ * Build and run from firmware/:
+ *   gcc -Imain -Itest/host test/test_adaptive_start.c main/adaptive_start.c -lm -o /tmp/test_adaptive_start
+ *   /tmp/test_adaptive_start
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "adaptive_start.h"
+#include "nvs.h"
+
+#define TRUE_RATE_A     0.08f   // °C/min of the simulated room: a - b * (indoor - outdoor)
+#define TRUE_RATE_B     0.002f
+#define FIT_RUNS        30
+#define FIT_TOLERANCE   0.004f  // °C/min: starts spread the observed rates
+
+static int failures = 0;
+
+// One-blob NVS
+static uint8_t nvs_blob[32];
+static size_t nvs_blob_length = 0;
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    *out_handle = 1;
+    return ESP_OK;
+}
+void nvs_close(nvs_handle_t handle) {
+}
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    return ESP_OK;
+}
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    if (length > sizeof(nvs_blob)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(nvs_blob, value, length);
+    nvs_blob_length = length;
+    return ESP_OK;
+}
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    if (nvs_blob_length == 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (*length < nvs_blob_length) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(out_value, nvs_blob, nvs_blob_length);
+    *length = nvs_blob_length;
+    return ESP_OK;
+}
+
+// Weekdays: eco from 22:00, comfort from 06:30; Sunday also comfort at 01:00
+static schedule_entry_t schedule[7][6];
+
+static void make_schedule(void) {
+    memset(schedule, 0, sizeof(schedule));
+    for (int day = 0; day < 7; day++) {
+        schedule[day][0] = (schedule_entry_t){ .hour = 6, .minute = 30, .mode = MODE_COMFORT, .temperature = 21.0f };
+        schedule[day][1] = (schedule_entry_t){ .hour = 22, .minute = 0, .mode = MODE_ECO, .temperature = 17.0f };
+    }
+    schedule[6][2] = (schedule_entry_t){ .hour = 1, .minute = 0, .mode = MODE_COMFORT, .temperature = 19.0f };
+    schedule[2][3] = (schedule_entry_t){ .hour = 12, .minute = 0, .mode = MODE_OFF, .temperature = 25.0f };
+}
+
+static struct tm at(int wday, int hour, int minute) {
+    struct tm t = { .tm_wday = wday, .tm_hour = hour, .tm_min = minute, .tm_year = 126 };
+    return t;
+}
+
+static void check_next_transition(void) {
+    struct {
+        const char *name;
+        struct tm now;
+        float current;
+        bool found;
+        uint32_t minutes;
+        float target;
+    } cases[] = {
+        { "Mon 05:00 eco",         at(1, 5, 0),   17.0f, true,  90,  21.0f },
+        { "Mon 03:00 eco",         at(1, 3, 0),   17.0f, true,  210, 21.0f },
+        { "Mon 02:00 eco",         at(1, 2, 0),   17.0f, false, 0,   0.0f },   // Beyond the max lead
+        { "Mon 07:00 comfort",     at(1, 7, 0),   21.0f, false, 0,   0.0f },   // Nothing warmer
+        { "Sat 23:30, Sun 01:00",  at(6, 23, 30), 17.0f, true,  90,  19.0f },  // Across midnight
+        { "Sun 23:00, Mon 06:30",  at(0, 23, 0),  17.0f, false, 0,   0.0f },   // 450 min away
+        { "Wed 11:00, OFF slot",   at(3, 11, 0),  21.0f, false, 0,   0.0f },   // Ignored
+        { "Mon 06:30 exactly",     at(1, 6, 30),  17.0f, false, 0,   0.0f },   // Already begun
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        uint32_t minutes = 0;
+        float target = 0.0f;
+        bool found = adaptive_start_next_transition(schedule, &cases[i].now, cases[i].current,
+                                                    &minutes, &target);
+        if (found != cases[i].found ||
+            (found && (minutes != cases[i].minutes || target != cases[i].target))) {
+            printf("FAIL next transition %s: %d, %u min, %.1fC\n", cases[i].name, found, minutes, target);
+            failures++;
+        }
+    }
+    printf("Next transition: %zu cases checked\n", sizeof(cases) / sizeof(cases[0]));
+}
+
+static void check_slot_in_force(void) {
+    struct {
+        const char *name;
+        struct tm now;
+        int slot;
+        float target;
+    } cases[] = {
+        { "Mon 07:00",   at(1, 7, 0),   0 * 6 + 0, 21.0f },
+        { "Mon 22:00",   at(1, 22, 0),  0 * 6 + 1, 17.0f },
+        { "Mon 05:00",   at(1, 5, 0),   6 * 6 + 1, 17.0f },   // Sunday's eco slot
+        { "Sun 02:00",   at(0, 2, 0),   6 * 6 + 2, 19.0f },
+        { "Wed 13:00",   at(3, 13, 0),  2 * 6 + 0, 21.0f },   // OFF slot skipped
+    };
+    schedule_entry_t empty[7][6];
+    schedule_entry_t once[7][6];
+    int slot;
+    float target;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (!adaptive_start_slot_in_force(schedule, &cases[i].now, &slot, &target) ||
+            slot != cases[i].slot || target != cases[i].target) {
+            printf("FAIL slot in force %s: slot %d, %.1fC\n", cases[i].name, slot, target);
+            failures++;
+        }
+    }
+
+    // Empty schedule: nothing in force. A single Tuesday 18:00 slot is still
+    // in force Tuesday 08:00, from a week ago
+    memset(empty, 0, sizeof(empty));
+    memcpy(once, empty, sizeof(once));
+    once[1][0] = (schedule_entry_t){ .hour = 18, .minute = 0, .mode = MODE_ECO, .temperature = 16.0f };
+    struct tm tuesday = at(2, 8, 0);
+    if (adaptive_start_slot_in_force(empty, &tuesday, &slot, &target) ||
+        !adaptive_start_slot_in_force(once, &tuesday, &slot, &target) || slot != 1 * 6 + 0) {
+        printf("FAIL slot in force: empty or single-slot schedule\n");
+        failures++;
+    }
+    printf("Slot in force: %zu cases and edge schedules checked\n", sizeof(cases) / sizeof(cases[0]));
+}
+
+static void check_lead(void) {
+    // Default model: 0.04 °C/min over 3C, plus margin
+    uint32_t lead = adaptive_start_lead_minutes(17.0f, 20.0f);
+    uint32_t none = adaptive_start_lead_minutes(21.0f, 20.0f);
+    uint32_t capped = adaptive_start_lead_minutes(5.0f, 30.0f);
+
+    printf("Lead 17->20C: %u min; already there: %u; 5->30C capped at %u\n", lead, none, capped);
+    if (lead != 85 || none != 0 || capped != ADAPTIVE_START_MAX_LEAD_MIN) {
+        printf("FAIL lead minutes\n");
+        failures++;
+    }
+}
+
+// One heat-up run of the simulated room, one call per second; returns learned.
+// Heating pauses for a second once the room passes disturb_above.
+static bool simulate_run(float start, float target, float outdoor, float disturb_above) {
+    float temp = start;
+    uint32_t t = 100000;
+    bool learned = false;
+
+    bool disturbed = false;
+    for (int s = 0; s < ADAPTIVE_START_MAX_RUN_MIN * 60 && temp < target; s++, t++) {
+        bool heating = disturbed || temp <= disturb_above;
+        disturbed = !heating || disturbed;
+        learned |= adaptive_start_update(temp, target, heating, t);
+        temp += (TRUE_RATE_A - TRUE_RATE_B * (temp - outdoor)) / 60.0f;
+    }
+    learned |= adaptive_start_update(temp, target, true, t);
+    // Heating stops at the setpoint: no run left open
+    adaptive_start_update(temp, target, false, t + 1);
+    return learned;
+}
+
+// Mean rate of a run from start to start + 3C in the simulated room
+static float true_rate(float start, float outdoor) {
+    return TRUE_RATE_A - TRUE_RATE_B * (start + 1.5f - outdoor);
+}
+
+// FIT_RUNS runs at one outdoor temperature; returns the runs learned
+static int fit_season(float outdoor, float *fitted, float *expected) {
+    int learned = 0;
+    *expected = 0.0f;
+    for (int run = 0; run < FIT_RUNS; run++) {
+        float start = 15.0f + (rand() % 20) / 10.0f;
+        learned += simulate_run(start, start + 3.0f, outdoor, INFINITY);
+        *expected += true_rate(start, outdoor) / FIT_RUNS;
+    }
+    *fitted = adaptive_start_get_rate();
+    return learned;
+}
+
+static void check_fit(void) {
+    // A run interrupted close to the setpoint is not learned from (and no
+    // new run starts: less than ADAPTIVE_START_MIN_GAP is left)
+    if (simulate_run(17.0f, 20.0f, 5.0f, 19.5f)) {
+        printf("FAIL fit: disturbed run learned\n");
+        failures++;
+    }
+
+    // Autumn, then winter: forgetting follows the slower winter runs
+    float autumn, autumn_true, winter, winter_true;
+    srand(3);
+    int learned = fit_season(12.0f, &autumn, &autumn_true);
+    learned += fit_season(-5.0f, &winter, &winter_true);
+
+    printf("Fit: %d of %d runs learned, autumn %.4f (true %.4f), winter %.4f (true %.4f) °C/min\n",
+           learned, 2 * FIT_RUNS, autumn, autumn_true, winter, winter_true);
+    if (learned != 2 * FIT_RUNS || fabsf(autumn - autumn_true) > FIT_TOLERANCE ||
+        fabsf(winter - winter_true) > FIT_TOLERANCE) {
+        printf("FAIL fit\n");
+        failures++;
+    }
+
+    // Persisted by the caller, then restored at boot
+    float before = adaptive_start_get_rate();
+    if (adaptive_start_save() != ESP_OK || adaptive_start_init() != ESP_OK ||
+        fabsf(adaptive_start_get_rate() - before) > 0.0002f) {
+        printf("FAIL fit: NVS round trip %.4f -> %.4f\n", before, adaptive_start_get_rate());
+        failures++;
+    }
+}
+
+int main(void) {
+    make_schedule();
+    check_next_transition();
+    check_slot_in_force();
+    check_lead();
+    check_fit();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}